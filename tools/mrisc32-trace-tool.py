@@ -22,54 +22,244 @@
 import argparse
 import struct
 import sys
+import zlib
+
+RAW_RECORD_SIZE = 5*4
+
+# Compressed trace format (see tools/sim/trace_format.hpp for a description).
+COMPRESSED_MAGIC = b'MR32TRC1'
+INDEX_MAGIC = b'MR32TIDX'
+RECORDS_PER_CHUNK = 65536
+METHOD_STORED = 0
+METHOD_ZLIB = 1
+FLAG_SEQUENTIAL_PC = 0x10
+FLAG_CYCLE_GAP = 0x20
+
 
 def load_record(f):
-    buf_str = f.read(5*4)
-    if len(buf_str) < 5*4:
+    buf_str = f.read(RAW_RECORD_SIZE)
+    if len(buf_str) < RAW_RECORD_SIZE:
         return
     buf = struct.unpack('<LLLLL', buf_str)
-    flags = buf[0]
+    return make_record(buf[0], buf[1], buf[2], buf[3], buf[4])
+
+
+def make_record(flags, pc, src_a, src_b, src_c):
     return {
         'valid': True if flags & 1 != 0 else False,
         'src_a_valid': True if flags & 2 != 0 else False,
         'src_b_valid': True if flags & 4 != 0 else False,
         'src_c_valid': True if flags & 8 != 0 else False,
-        'pc': buf[1],
-        'src_a': buf[2],
-        'src_b': buf[3],
-        'src_c': buf[4]
+        'pc': pc,
+        'src_a': src_a,
+        'src_b': src_b,
+        'src_c': src_c
     }
 
 
-def show(trace_file, show_operands, show_defunct):
+def record_flags(trace):
+    return ((1 if trace['valid'] else 0) | (2 if trace['src_a_valid'] else 0) |
+            (4 if trace['src_b_valid'] else 0) | (8 if trace['src_c_valid'] else 0))
+
+
+def load_index(f):
+    # The trailer is: u64 index offset, u64 number of chunks, INDEX_MAGIC.
+    f.seek(-24, 2)
+    index_offset, num_chunks, magic = struct.unpack('<QQ8s', f.read(24))
+    if magic != INDEX_MAGIC:
+        raise ValueError('Missing compressed trace index (incomplete file?)')
+    f.seek(index_offset)
+    index = []
+    for _ in range(num_chunks):
+        offset, first_cycle, num_records, min_pc, max_pc, _ = struct.unpack('<QQLLLL', f.read(32))
+        index.append({'offset': offset, 'first_cycle': first_cycle, 'num_records': num_records,
+                      'min_pc': min_pc, 'max_pc': max_pc})
+    return index
+
+
+def read_varint(data, pos):
+    x, shift = 0, 0
+    while True:
+        b = data[pos]
+        pos += 1
+        x |= (b & 0x7f) << shift
+        shift += 7
+        if b < 0x80:
+            return x, pos
+
+
+def write_varint(buf, x):
+    while x >= 0x80:
+        buf.append((x & 0x7f) | 0x80)
+        x >>= 7
+    buf.append(x)
+
+
+def decode_chunk(f, chunk):
+    """Yield (cycle, record) tuples from a compressed trace chunk."""
+    f.seek(chunk['offset'])
+    method, data_size, raw_size, num_records, cycle, _, _ = struct.unpack('<LLLLQLL', f.read(32))
+    data = f.read(data_size)
+    if method == METHOD_ZLIB:
+        data = zlib.decompress(data)
+    elif method != METHOD_STORED:
+        raise ValueError(f'Unknown chunk compression method: {method}')
+    pos = 0
+    prev_pc = 0
+    cycle -= 1
+    for _ in range(num_records):
+        flags = data[pos]
+        pos += 1
+        if flags & FLAG_SEQUENTIAL_PC:
+            pc = (prev_pc + 4) & 0xffffffff
+        else:
+            # Zigzag encoded varint.
+            x, pos = read_varint(data, pos)
+            delta = (x >> 1) ^ -(x & 1)
+            pc = (prev_pc + 4 + delta) & 0xffffffff
+        cycle += 1
+        if flags & FLAG_CYCLE_GAP:
+            gap, pos = read_varint(data, pos)
+            cycle += gap
+        src = [0, 0, 0]
+        for k in range(3):
+            if flags & (2 << k):
+                src[k] = struct.unpack_from('<L', data, pos)[0]
+                pos += 4
+        prev_pc = pc
+        yield cycle, make_record(flags & 15, pc, src[0], src[1], src[2])
+
+
+def load_records(trace_file, first_cycle=0, last_cycle=None, pc=None):
+    """Yield (cycle, record) tuples from a raw or compressed trace file."""
     with open(trace_file, 'rb') as f:
-        while True:
-            trace = load_record(f)
-            if not trace:
-                break
-            if trace['valid'] or show_defunct:
-                s = f"{trace['pc']:08X}"
-                if show_operands:
-                    s += ":"
-                    s += f" {trace['src_a']:08X}" if trace['src_a_valid'] else (" " + "-" * 8)
-                    s += f" {trace['src_b']:08X}" if trace['src_b_valid'] else (" " + "-" * 8)
-                    s += f" {trace['src_c']:08X}" if trace['src_c_valid'] else (" " + "-" * 8)
-                    if not trace['valid']:
-                        s += ' [defunct]'
-                print(s)
+        if f.read(len(COMPRESSED_MAGIC)) == COMPRESSED_MAGIC:
+            index = load_index(f)
+            for k, chunk in enumerate(index):
+                # Use the index to skip chunks that are outside of the requested range. Cycles may
+                # have been skipped (filtered traces), so a chunk ends before the next chunk starts.
+                if k + 1 < len(index) and index[k + 1]['first_cycle'] <= first_cycle:
+                    continue
+                if last_cycle is not None and chunk['first_cycle'] > last_cycle:
+                    break
+                if pc is not None and not (chunk['min_pc'] <= pc <= chunk['max_pc']):
+                    continue
+                for cycle, trace in decode_chunk(f, chunk):
+                    if cycle >= first_cycle and (last_cycle is None or cycle <= last_cycle):
+                        yield cycle, trace
+        else:
+            # Raw traces have fixed size records, so we can seek to the first cycle.
+            f.seek(first_cycle * RAW_RECORD_SIZE)
+            cycle = first_cycle
+            while last_cycle is None or cycle <= last_cycle:
+                trace = load_record(f)
+                if not trace:
+                    break
+                yield cycle, trace
+                cycle += 1
+
+
+def show(trace_file, show_operands, show_defunct, first_cycle=0, last_cycle=None, pc=None):
+    for _, trace in load_records(trace_file, first_cycle, last_cycle, pc):
+        if pc is not None and trace['pc'] != pc:
+            continue
+        if trace['valid'] or show_defunct:
+            s = f"{trace['pc']:08X}"
+            if show_operands:
+                s += ":"
+                s += f" {trace['src_a']:08X}" if trace['src_a_valid'] else (" " + "-" * 8)
+                s += f" {trace['src_b']:08X}" if trace['src_b_valid'] else (" " + "-" * 8)
+                s += f" {trace['src_c']:08X}" if trace['src_c_valid'] else (" " + "-" * 8)
+                if not trace['valid']:
+                    s += ' [defunct]'
+            print(s)
+
+
+def write_raw(trace_file, out_file):
+    with open(out_file, 'wb') as out_f:
+        for _, trace in load_records(trace_file):
+            out_f.write(struct.pack('<LLLLL', record_flags(trace), trace['pc'],
+                                    trace['src_a'] if trace['src_a_valid'] else 0,
+                                    trace['src_b'] if trace['src_b_valid'] else 0,
+                                    trace['src_c'] if trace['src_c_valid'] else 0))
+
+
+def write_compressed(trace_file, out_file):
+    with open(out_file, 'wb') as out_f:
+        out_f.write(COMPRESSED_MAGIC + struct.pack('<LL', RECORDS_PER_CHUNK, 0))
+        index = []
+        chunk = bytearray()
+        num_records, prev_pc, min_pc, max_pc, first_cycle, prev_cycle = 0, 0, 0, 0, 0, 0
+
+        def flush_chunk():
+            data = zlib.compress(bytes(chunk), 1)
+            method = METHOD_ZLIB
+            if len(data) >= len(chunk):
+                data, method = bytes(chunk), METHOD_STORED
+            index.append(struct.pack('<QQLLLL', out_f.tell(), first_cycle, num_records,
+                                     min_pc, max_pc, 0))
+            out_f.write(struct.pack('<LLLLQLL', method, len(data), len(chunk), num_records,
+                                    first_cycle, min_pc, max_pc))
+            out_f.write(data)
+
+        for cycle, trace in load_records(trace_file):
+            pc = trace['pc']
+            if num_records == 0:
+                first_cycle, prev_cycle = cycle, cycle - 1
+            gap = cycle - prev_cycle - 1
+            flags = record_flags(trace) | (FLAG_CYCLE_GAP if gap else 0)
+            delta = (pc - prev_pc - 4) & 0xffffffff
+            if delta == 0:
+                chunk.append(flags | FLAG_SEQUENTIAL_PC)
+            else:
+                chunk.append(flags)
+                delta = delta - (1 << 32) if delta >= (1 << 31) else delta
+                write_varint(chunk, ((delta << 1) ^ (delta >> 31)) & 0xffffffff)
+            if gap:
+                write_varint(chunk, gap)
+            for k, name in enumerate(['src_a', 'src_b', 'src_c']):
+                if flags & (2 << k):
+                    chunk.extend(struct.pack('<L', trace[name]))
+            min_pc = pc if num_records == 0 else min(min_pc, pc)
+            max_pc = pc if num_records == 0 else max(max_pc, pc)
+            prev_pc = pc
+            prev_cycle = cycle
+            num_records += 1
+            if num_records == RECORDS_PER_CHUNK:
+                flush_chunk()
+                chunk = bytearray()
+                num_records, prev_pc = 0, 0
+        if num_records > 0:
+            flush_chunk()
+
+        index_offset = out_f.tell()
+        out_f.write(b''.join(index))
+        out_f.write(struct.pack('<QQ8s', index_offset, len(index), INDEX_MAGIC))
 
 
 def main():
     # Parse command line arguments.
     parser = argparse.ArgumentParser(
-            description='Tool for inspecting MRISC32 debug trace files')
+            description='Tool for inspecting MRISC32 debug trace files (raw or compressed)')
     parser.add_argument('file', metavar='TRACE_FILE', help='the debug trace file to show')
     parser.add_argument('-o', '--operands', action='store_true', help='show operand values')
     parser.add_argument('-d', '--defunct', action='store_true', help='show defunct operations (bubbles)')
+    parser.add_argument('--first', type=lambda x: int(x, 0), default=0,
+                        help='first cycle to show')
+    parser.add_argument('--last', type=lambda x: int(x, 0), help='last cycle to show')
+    parser.add_argument('--pc', type=lambda x: int(x, 0), help='only show records for this PC')
+    parser.add_argument('--to-raw', metavar='OUT_FILE', help='convert the trace to the raw format')
+    parser.add_argument('--to-compressed', metavar='OUT_FILE',
+                        help='convert the trace to the compressed format')
     args = parser.parse_args()
 
-    # Show the file.
-    show(args.file, args.operands, args.defunct)
+    if args.to_raw:
+        write_raw(args.file, args.to_raw)
+    elif args.to_compressed:
+        write_compressed(args.file, args.to_compressed)
+    else:
+        # Show the file.
+        show(args.file, args.operands, args.defunct, args.first, args.last, args.pc)
 
 
 if __name__ == "__main__":
@@ -0,0 +1,1689 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+// This file contains the EX stage ALU operations, which are shared by the different CPU
+// implementations.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef SIM_ALU_HPP_
+#define SIM_ALU_HPP_
+
+#include "cpu.hpp"
+#include "packed_float.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+inline uint32_t index_scale_factor(const uint32_t packed_mode) {
+  return uint32_t(1u) << packed_mode;
+}
+
+inline float as_f32(const uint32_t x) {
+  float result;
+  std::memcpy(&result, &x, sizeof(float));
+  return result;
+}
+
+inline uint32_t as_u32(const float x) {
+  uint32_t result;
+  std::memcpy(&result, &x, sizeof(uint32_t));
+  return result;
+}
+
+inline uint32_t add32(const uint32_t a, const uint32_t b) {
+  return a + b;
+}
+
+inline uint32_t add16x2(const uint32_t a, const uint32_t b) {
+  const uint32_t hi = (a & 0xffff0000u) + (b & 0xffff0000u);
+  const uint32_t lo = (a + b) & 0x0000ffffu;
+  return hi | lo;
+}
+
+inline uint32_t add8x4(const uint32_t a, const uint32_t b) {
+  const uint32_t hi = ((a & 0xff00ff00u) + (b & 0xff00ff00u)) & 0xff00ff00u;
+  const uint32_t lo = ((a & 0x00ff00ffu) + (b & 0x00ff00ffu)) & 0x00ff00ffu;
+  return hi | lo;
+}
+
+inline uint32_t sub32(const uint32_t a, const uint32_t b) {
+  return add32((~a) + 1u, b);
+}
+
+inline uint32_t sub16x2(const uint32_t a, const uint32_t b) {
+  return add16x2(add16x2(~a, 0x00010001u), b);
+}
+
+inline uint32_t sub8x4(const uint32_t a, const uint32_t b) {
+  return add8x4(add8x4(~a, 0x01010101u), b);
+}
+
+inline uint32_t set32(const uint32_t a, const uint32_t b, bool (*cmp)(uint32_t, uint32_t)) {
+  return cmp(a, b) ? 0xffffffffu : 0u;
+}
+
+inline uint32_t set16x2(const uint32_t a, const uint32_t b, bool (*cmp)(uint16_t, uint16_t)) {
+  const uint32_t h1 =
+      (cmp(static_cast<uint16_t>(a >> 16), static_cast<uint16_t>(b >> 16)) ? 0xffff0000u : 0u);
+  const uint32_t h0 = (cmp(static_cast<uint16_t>(a), static_cast<uint16_t>(b)) ? 0x0000ffffu : 0u);
+  return h1 | h0;
+}
+
+inline uint32_t set8x4(const uint32_t a, const uint32_t b, bool (*cmp)(uint8_t, uint8_t)) {
+  const uint32_t b3 =
+      (cmp(static_cast<uint8_t>(a >> 24), static_cast<uint8_t>(b >> 24)) ? 0xff000000u : 0u);
+  const uint32_t b2 =
+      (cmp(static_cast<uint8_t>(a >> 16), static_cast<uint8_t>(b >> 16)) ? 0x00ff0000u : 0u);
+  const uint32_t b1 =
+      (cmp(static_cast<uint8_t>(a >> 8), static_cast<uint8_t>(b >> 8)) ? 0x0000ff00u : 0u);
+  const uint32_t b0 = (cmp(static_cast<uint8_t>(a), static_cast<uint8_t>(b)) ? 0x000000ffu : 0u);
+  return b3 | b2 | b1 | b0;
+}
+
+inline uint32_t sel32(const uint32_t a, const uint32_t b, const uint32_t mask) {
+  return (a & mask) | (b & ~mask);
+}
+
+inline uint32_t asr32(const uint32_t a, const uint32_t b) {
+  return static_cast<uint32_t>(static_cast<int32_t>(a) >> static_cast<int32_t>(b));
+}
+
+inline uint32_t asr16x2(const uint32_t a, const uint32_t b) {
+  const auto s1 = (b >> 16) & 15;
+  const auto s0 = b & 15;
+  const auto h1 = static_cast<uint32_t>(static_cast<uint16_t>(static_cast<int16_t>(a >> 16) >> s1));
+  const auto h0 = static_cast<uint32_t>(static_cast<uint16_t>(static_cast<int16_t>(a) >> s0));
+  return (h1 << 16) | h0;
+}
+
+inline uint32_t asr8x4(const uint32_t a, const uint32_t b) {
+  const auto s3 = (b >> 24) & 7;
+  const auto s2 = (b >> 16) & 7;
+  const auto s1 = (b >> 8) & 7;
+  const auto s0 = b & 7;
+  const auto b3 = static_cast<uint32_t>(static_cast<uint8_t>(static_cast<int8_t>(a >> 24) >> s3));
+  const auto b2 = static_cast<uint32_t>(static_cast<uint8_t>(static_cast<int8_t>(a >> 16) >> s2));
+  const auto b1 = static_cast<uint32_t>(static_cast<uint8_t>(static_cast<int8_t>(a >> 8) >> s1));
+  const auto b0 = static_cast<uint32_t>(static_cast<uint8_t>(static_cast<int8_t>(a) >> s0));
+  return (b3 << 24) | (b2 << 16) | (b1 << 8) | b0;
+}
+
+inline uint32_t lsl32(const uint32_t a, const uint32_t b) {
+  return a << b;
+}
+
+inline uint32_t lsl16x2(const uint32_t a, const uint32_t b) {
+  const auto s1 = (b >> 16) & 15;
+  const auto s0 = b & 15;
+  const auto h1 = (a & 0xffff0000u) << s1;
+  const auto h0 = (a << s0) & 0x0000ffffu;
+  return h1 | h0;
+}
+
+inline uint32_t lsl8x4(const uint32_t a, const uint32_t b) {
+  const auto s3 = (b >> 24) & 7;
+  const auto s2 = (b >> 16) & 7;
+  const auto s1 = (b >> 8) & 7;
+  const auto s0 = b & 7;
+  const auto b3 = (a & 0xff000000u) << s3;
+  const auto b2 = ((a & 0x00ff0000u) << s2) & 0x00ff0000u;
+  const auto b1 = ((a & 0x0000ff00u) << s1) & 0x0000ff00u;
+  const auto b0 = (a << s0) & 0x000000ffu;
+  return b3 | b2 | b1 | b0;
+}
+
+inline uint32_t lsr32(const uint32_t a, const uint32_t b) {
+  return a >> b;
+}
+
+inline uint32_t lsr16x2(const uint32_t a, const uint32_t b) {
+  const auto s1 = (b >> 16) & 15;
+  const auto s0 = b & 15;
+  const auto h1 = (a >> s1) & 0xffff0000u;
+  const auto h0 = (a & 0x0000ffffu) >> s0;
+  return h1 | h0;
+}
+
+inline uint32_t lsr8x4(const uint32_t a, const uint32_t b) {
+  const auto s3 = (b >> 24) & 7;
+  const auto s2 = (b >> 16) & 7;
+  const auto s1 = (b >> 8) & 7;
+  const auto s0 = b & 7;
+  const auto b3 = (a >> s3) & 0xff000000u;
+  const auto b2 = ((a & 0x00ff0000u) >> s2) & 0x00ff0000u;
+  const auto b1 = ((a & 0x0000ff00u) >> s1) & 0x0000ff00u;
+  const auto b0 = (a & 0x000000ffu) >> s0;
+  return b3 | b2 | b1 | b0;
+}
+
+inline uint32_t saturate32(const int64_t x) {
+  return (x > INT64_C(0x000000007fffffff))
+             ? 0x7fffffffu
+             : ((x < INT64_C(-0x0000000080000000)) ? 0x80000000u : static_cast<uint32_t>(x));
+}
+
+inline uint32_t saturate16(const int32_t x) {
+  return (x > 0x00007fff)
+             ? 0x7fffu
+             : ((x < -0x00008000) ? 0x8000u : (static_cast<uint32_t>(x) & 0x0000ffffu));
+}
+
+inline uint32_t saturate8(const int16_t x) {
+  return (x > 0x007f) ? 0x7fu : ((x < -0x0080) ? 0x80u : (static_cast<uint32_t>(x) & 0x00ffu));
+}
+
+inline uint32_t saturateu32(const uint64_t x) {
+  return (x > UINT64_C(0x8000000000000000))
+             ? 0x00000000u
+             : ((x > UINT64_C(0x00000000ffffffff)) ? 0xffffffffu : static_cast<uint32_t>(x));
+}
+
+inline uint32_t saturateu16(const uint32_t x) {
+  return (x > 0x80000000u) ? 0x0000u : ((x > 0x0000ffffu) ? 0xffffu : static_cast<uint32_t>(x));
+}
+
+inline uint32_t saturateu8(const uint16_t x) {
+  return (x > 0x8000u) ? 0x00u : ((x > 0x00ffu) ? 0xffu : static_cast<uint32_t>(x));
+}
+
+inline uint32_t saturating_op_32(const uint32_t a,
+                                 const uint32_t b,
+                                 int64_t (*op)(int64_t, int64_t)) {
+  const auto a64 = static_cast<int64_t>(static_cast<int32_t>(a));
+  const auto b64 = static_cast<int64_t>(static_cast<int32_t>(b));
+  return saturate32(op(a64, b64));
+}
+
+inline uint32_t saturating_op_16x2(const uint32_t a,
+                                   const uint32_t b,
+                                   int32_t (*op)(int32_t, int32_t)) {
+  const auto a1 = static_cast<int32_t>(static_cast<int16_t>(a >> 16));
+  const auto a2 = static_cast<int32_t>(static_cast<int16_t>(a));
+  const auto b1 = static_cast<int32_t>(static_cast<int16_t>(b >> 16));
+  const auto b2 = static_cast<int32_t>(static_cast<int16_t>(b));
+  const auto c1 = saturate16(op(a1, b1));
+  const auto c2 = saturate16(op(a2, b2));
+  return (c1 << 16) | c2;
+}
+
+inline uint32_t saturating_op_8x4(const uint32_t a,
+                                  const uint32_t b,
+                                  int16_t (*op)(int16_t, int16_t)) {
+  const auto a1 = static_cast<int16_t>(static_cast<int8_t>(a >> 24));
+  const auto a2 = static_cast<int16_t>(static_cast<int8_t>(a >> 16));
+  const auto a3 = static_cast<int16_t>(static_cast<int8_t>(a >> 8));
+  const auto a4 = static_cast<int16_t>(static_cast<int8_t>(a));
+  const auto b1 = static_cast<int16_t>(static_cast<int8_t>(b >> 24));
+  const auto b2 = static_cast<int16_t>(static_cast<int8_t>(b >> 16));
+  const auto b3 = static_cast<int16_t>(static_cast<int8_t>(b >> 8));
+  const auto b4 = static_cast<int16_t>(static_cast<int8_t>(b));
+  const auto c1 = saturate8(op(a1, b1));
+  const auto c2 = saturate8(op(a2, b2));
+  const auto c3 = saturate8(op(a3, b3));
+  const auto c4 = saturate8(op(a4, b4));
+  return (c1 << 24) | (c2 << 16) | (c3 << 8) | c4;
+}
+
+inline uint32_t saturating_op_u32(const uint32_t a,
+                                  const uint32_t b,
+                                  uint64_t (*op)(uint64_t, uint64_t)) {
+  return saturateu32(op(static_cast<uint64_t>(a), static_cast<uint64_t>(b)));
+}
+
+inline uint32_t saturating_op_u16x2(const uint32_t a,
+                                    const uint32_t b,
+                                    uint32_t (*op)(uint32_t, uint32_t)) {
+  const auto a1 = static_cast<uint32_t>(static_cast<uint16_t>(a >> 16));
+  const auto a2 = static_cast<uint32_t>(static_cast<uint16_t>(a));
+  const auto b1 = static_cast<uint32_t>(static_cast<uint16_t>(b >> 16));
+  const auto b2 = static_cast<uint32_t>(static_cast<uint16_t>(b));
+  const auto c1 = saturateu16(op(a1, b1));
+  const auto c2 = saturateu16(op(a2, b2));
+  return (c1 << 16) | c2;
+}
+
+inline uint32_t saturating_op_u8x4(const uint32_t a,
+                                   const uint32_t b,
+                                   uint16_t (*op)(uint16_t, uint16_t)) {
+  const auto a1 = static_cast<uint16_t>(static_cast<uint8_t>(a >> 24));
+  const auto a2 = static_cast<uint16_t>(static_cast<uint8_t>(a >> 16));
+  const auto a3 = static_cast<uint16_t>(static_cast<uint8_t>(a >> 8));
+  const auto a4 = static_cast<uint16_t>(static_cast<uint8_t>(a));
+  const auto b1 = static_cast<uint16_t>(static_cast<uint8_t>(b >> 24));
+  const auto b2 = static_cast<uint16_t>(static_cast<uint8_t>(b >> 16));
+  const auto b3 = static_cast<uint16_t>(static_cast<uint8_t>(b >> 8));
+  const auto b4 = static_cast<uint16_t>(static_cast<uint8_t>(b));
+  const auto c1 = saturateu8(op(a1, b1));
+  const auto c2 = saturateu8(op(a2, b2));
+  const auto c3 = saturateu8(op(a3, b3));
+  const auto c4 = saturateu8(op(a4, b4));
+  return (c1 << 24) | (c2 << 16) | (c3 << 8) | c4;
+}
+
+inline uint32_t halve32(const int64_t x) {
+  return static_cast<uint32_t>(x >> 1);
+}
+
+inline uint32_t halve16(const int32_t x) {
+  return static_cast<uint32_t>(static_cast<uint16_t>(x >> 1));
+}
+
+inline uint32_t halve8(const int16_t x) {
+  return static_cast<uint32_t>(static_cast<uint8_t>(x >> 1));
+}
+
+inline uint32_t halveu32(const uint64_t x) {
+  return static_cast<uint32_t>(x >> 1);
+}
+
+inline uint32_t halveu16(const uint32_t x) {
+  return static_cast<uint32_t>(static_cast<uint16_t>(x >> 1));
+}
+
+inline uint32_t halveu8(const uint16_t x) {
+  return static_cast<uint32_t>(static_cast<uint8_t>(x >> 1));
+}
+
+inline uint32_t halving_op_32(const uint32_t a, const uint32_t b, int64_t (*op)(int64_t, int64_t)) {
+  const auto a64 = static_cast<int64_t>(static_cast<int32_t>(a));
+  const auto b64 = static_cast<int64_t>(static_cast<int32_t>(b));
+  return halve32(op(a64, b64));
+}
+
+inline uint32_t halving_op_16x2(const uint32_t a,
+                                const uint32_t b,
+                                int32_t (*op)(int32_t, int32_t)) {
+  const auto a1 = static_cast<int32_t>(static_cast<int16_t>(a >> 16));
+  const auto a2 = static_cast<int32_t>(static_cast<int16_t>(a));
+  const auto b1 = static_cast<int32_t>(static_cast<int16_t>(b >> 16));
+  const auto b2 = static_cast<int32_t>(static_cast<int16_t>(b));
+  const auto c1 = halve16(op(a1, b1));
+  const auto c2 = halve16(op(a2, b2));
+  return (c1 << 16) | c2;
+}
+
+inline uint32_t halving_op_8x4(const uint32_t a,
+                               const uint32_t b,
+                               int16_t (*op)(int16_t, int16_t)) {
+  const auto a1 = static_cast<int16_t>(static_cast<int8_t>(a >> 24));
+  const auto a2 = static_cast<int16_t>(static_cast<int8_t>(a >> 16));
+  const auto a3 = static_cast<int16_t>(static_cast<int8_t>(a >> 8));
+  const auto a4 = static_cast<int16_t>(static_cast<int8_t>(a));
+  const auto b1 = static_cast<int16_t>(static_cast<int8_t>(b >> 24));
+  const auto b2 = static_cast<int16_t>(static_cast<int8_t>(b >> 16));
+  const auto b3 = static_cast<int16_t>(static_cast<int8_t>(b >> 8));
+  const auto b4 = static_cast<int16_t>(static_cast<int8_t>(b));
+  const auto c1 = halve8(op(a1, b1));
+  const auto c2 = halve8(op(a2, b2));
+  const auto c3 = halve8(op(a3, b3));
+  const auto c4 = halve8(op(a4, b4));
+  return (c1 << 24) | (c2 << 16) | (c3 << 8) | c4;
+}
+
+inline uint32_t halving_op_u32(const uint32_t a,
+                               const uint32_t b,
+                               uint64_t (*op)(uint64_t, uint64_t)) {
+  return halveu32(op(static_cast<uint64_t>(a), static_cast<uint64_t>(b)));
+}
+
+inline uint32_t halving_op_u16x2(const uint32_t a,
+                                 const uint32_t b,
+                                 uint32_t (*op)(uint32_t, uint32_t)) {
+  const auto a1 = static_cast<uint32_t>(static_cast<uint16_t>(a >> 16));
+  const auto a2 = static_cast<uint32_t>(static_cast<uint16_t>(a));
+  const auto b1 = static_cast<uint32_t>(static_cast<uint16_t>(b >> 16));
+  const auto b2 = static_cast<uint32_t>(static_cast<uint16_t>(b));
+  const auto c1 = halveu16(op(a1, b1));
+  const auto c2 = halveu16(op(a2, b2));
+  return (c1 << 16) | c2;
+}
+
+inline uint32_t halving_op_u8x4(const uint32_t a,
+                                const uint32_t b,
+                                uint16_t (*op)(uint16_t, uint16_t)) {
+  const auto a1 = static_cast<uint16_t>(static_cast<uint8_t>(a >> 24));
+  const auto a2 = static_cast<uint16_t>(static_cast<uint8_t>(a >> 16));
+  const auto a3 = static_cast<uint16_t>(static_cast<uint8_t>(a >> 8));
+  const auto a4 = static_cast<uint16_t>(static_cast<uint8_t>(a));
+  const auto b1 = static_cast<uint16_t>(static_cast<uint8_t>(b >> 24));
+  const auto b2 = static_cast<uint16_t>(static_cast<uint8_t>(b >> 16));
+  const auto b3 = static_cast<uint16_t>(static_cast<uint8_t>(b >> 8));
+  const auto b4 = static_cast<uint16_t>(static_cast<uint8_t>(b));
+  const auto c1 = halveu8(op(a1, b1));
+  const auto c2 = halveu8(op(a2, b2));
+  const auto c3 = halveu8(op(a3, b3));
+  const auto c4 = halveu8(op(a4, b4));
+  return (c1 << 24) | (c2 << 16) | (c3 << 8) | c4;
+}
+
+inline uint32_t mulq31(const uint32_t a, const uint32_t b) {
+  const int64_t p =
+      static_cast<int64_t>(static_cast<int32_t>(a)) * static_cast<int64_t>(static_cast<int32_t>(b));
+  return static_cast<uint32_t>(p >> 31u);
+}
+
+inline uint32_t mulq15x2(const uint32_t a, const uint32_t b) {
+  const auto a1 = static_cast<int32_t>(static_cast<int16_t>(a >> 16u));
+  const auto a0 = static_cast<int32_t>(static_cast<int16_t>(a));
+  const auto b1 = static_cast<int32_t>(static_cast<int16_t>(b >> 16u));
+  const auto b0 = static_cast<int32_t>(static_cast<int16_t>(b));
+  const auto c1 = static_cast<uint32_t>((a1 * b1) << 1) & 0xffff0000u;
+  const auto c0 = (static_cast<uint32_t>(a0 * b0) >> 15u) & 0x0000ffffu;
+  return c1 | c0;
+}
+
+inline uint32_t mulq7x4(const uint32_t a, const uint32_t b) {
+  const auto a3 = static_cast<int32_t>(static_cast<int8_t>(a >> 24u));
+  const auto a2 = static_cast<int32_t>(static_cast<int8_t>(a >> 16u));
+  const auto a1 = static_cast<int32_t>(static_cast<int8_t>(a >> 8u));
+  const auto a0 = static_cast<int32_t>(static_cast<int8_t>(a));
+  const auto b3 = static_cast<int32_t>(static_cast<int8_t>(b >> 24u));
+  const auto b2 = static_cast<int32_t>(static_cast<int8_t>(b >> 16u));
+  const auto b1 = static_cast<int32_t>(static_cast<int8_t>(b >> 8u));
+  const auto b0 = static_cast<int32_t>(static_cast<int8_t>(b));
+  const auto c3 = (static_cast<uint32_t>(a3 * b3) & 0x00007f80u) << 17u;
+  const auto c2 = (static_cast<uint32_t>(a2 * b2) & 0x00007f80u) << 9u;
+  const auto c1 = (static_cast<uint32_t>(a1 * b1) & 0x00007f80u) << 1u;
+  const auto c0 = (static_cast<uint32_t>(a0 * b0) & 0x00007f80u) >> 7u;
+  return c3 | c2 | c1 | c0;
+}
+
+inline uint32_t mul32(const uint32_t a, const uint32_t b) {
+  return a * b;
+}
+
+inline uint32_t mul16x2(const uint32_t a, const uint32_t b) {
+  const auto h1 = (a >> 16) * (b >> 16) << 16;
+  const auto h0 = (a * b) & 0x0000ffffu;
+  return h1 | h0;
+}
+
+inline uint32_t mul8x4(const uint32_t a, const uint32_t b) {
+  const auto b3 = (a >> 24) * (b >> 24) << 24;
+  const auto b2 = (((a >> 16) * (b >> 16)) & 0x000000ffu) << 16;
+  const auto b1 = (((a >> 8) * (b >> 8)) & 0x000000ffu) << 8;
+  const auto b0 = (a * b) & 0x000000ffu;
+  return b3 | b2 | b1 | b0;
+}
+
+inline uint32_t mulhi32(const uint32_t a, const uint32_t b) {
+  const int64_t p =
+      static_cast<int64_t>(static_cast<int32_t>(a)) * static_cast<int64_t>(static_cast<int32_t>(b));
+  return static_cast<uint32_t>(p >> 32u);
+}
+
+inline uint32_t mulhi16x2(const uint32_t a, const uint32_t b) {
+  const auto a1 = static_cast<int32_t>(static_cast<int16_t>(a >> 16u));
+  const auto a0 = static_cast<int32_t>(static_cast<int16_t>(a));
+  const auto b1 = static_cast<int32_t>(static_cast<int16_t>(b >> 16u));
+  const auto b0 = static_cast<int32_t>(static_cast<int16_t>(b));
+  const auto c1 = static_cast<uint32_t>(a1 * b1) & 0xffff0000u;
+  const auto c0 = static_cast<uint32_t>(a0 * b0) >> 16u;
+  return c1 | c0;
+}
+
+inline uint32_t mulhi8x4(const uint32_t a, const uint32_t b) {
+  const auto a3 = static_cast<int32_t>(static_cast<int8_t>(a >> 24u));
+  const auto a2 = static_cast<int32_t>(static_cast<int8_t>(a >> 16u));
+  const auto a1 = static_cast<int32_t>(static_cast<int8_t>(a >> 8u));
+  const auto a0 = static_cast<int32_t>(static_cast<int8_t>(a));
+  const auto b3 = static_cast<int32_t>(static_cast<int8_t>(b >> 24u));
+  const auto b2 = static_cast<int32_t>(static_cast<int8_t>(b >> 16u));
+  const auto b1 = static_cast<int32_t>(static_cast<int8_t>(b >> 8u));
+  const auto b0 = static_cast<int32_t>(static_cast<int8_t>(b));
+  const auto c3 = (static_cast<uint32_t>(a3 * b3) & 0x0000ff00u) << 16u;
+  const auto c2 = (static_cast<uint32_t>(a2 * b2) & 0x0000ff00u) << 8u;
+  const auto c1 = (static_cast<uint32_t>(a1 * b1) & 0x0000ff00u);
+  const auto c0 = (static_cast<uint32_t>(a0 * b0) & 0x0000ff00u) >> 8u;
+  return c3 | c2 | c1 | c0;
+}
+
+inline uint32_t mulhiu32(const uint32_t a, const uint32_t b) {
+  const uint64_t p = static_cast<uint64_t>(a) * static_cast<uint64_t>(b);
+  return static_cast<uint32_t>(p >> 32u);
+}
+
+inline uint32_t mulhiu16x2(const uint32_t a, const uint32_t b) {
+  const auto h1 = (a >> 16) * (b >> 16) & 0xffff0000u;
+  const auto h0 = ((a & 0x0000ffffu) * (b & 0x0000ffffu)) >> 16;
+  return h1 | h0;
+}
+
+inline uint32_t mulhiu8x4(const uint32_t a, const uint32_t b) {
+  const auto b3 = ((a & 0xff000000u) >> 16u) * ((b & 0xff000000u) >> 16u) & 0xff000000u;
+  const auto b2 = (((a & 0x00ff0000u) >> 12u) * ((b & 0x00ff0000u) >> 12u)) & 0x00ff0000u;
+  const auto b1 = ((a & 0x0000ff00u) >> 8u) * ((b & 0x0000ff00u) >> 8u) & 0x0000ff00u;
+  const auto b0 = ((a & 0x000000ffu) * (b & 0x000000ffu)) >> 8u;
+  return b3 | b2 | b1 | b0;
+}
+
+template <typename T>
+inline T div_allow_zero(const T a, const T b) {
+  return b != static_cast<T>(0) ? (a / b) : static_cast<T>(-1);
+}
+
+template <typename T>
+inline T mod_allow_zero(const T a, const T b) {
+  return b != static_cast<T>(0) ? (a % b) : a;
+}
+
+inline uint32_t div32(const uint32_t a, const uint32_t b) {
+  return static_cast<uint32_t>(div_allow_zero(static_cast<int32_t>(a), static_cast<int32_t>(b)));
+}
+
+inline uint32_t div16x2(const uint32_t a, const uint32_t b) {
+  const auto a1 = static_cast<int32_t>(static_cast<int16_t>(a >> 16u));
+  const auto a0 = static_cast<int32_t>(static_cast<int16_t>(a));
+  const auto b1 = static_cast<int32_t>(static_cast<int16_t>(b >> 16u));
+  const auto b0 = static_cast<int32_t>(static_cast<int16_t>(b));
+  const auto c1 = (static_cast<uint32_t>(div_allow_zero(a1, b1)) & 0x0000ffffu) << 16u;
+  const auto c0 = static_cast<uint32_t>(div_allow_zero(a0, b0)) & 0x0000ffffu;
+  return c1 | c0;
+}
+
+inline uint32_t div8x4(const uint32_t a, const uint32_t b) {
+  const auto a3 = static_cast<int32_t>(static_cast<int8_t>(a >> 24u));
+  const auto a2 = static_cast<int32_t>(static_cast<int8_t>(a >> 16u));
+  const auto a1 = static_cast<int32_t>(static_cast<int8_t>(a >> 8u));
+  const auto a0 = static_cast<int32_t>(static_cast<int8_t>(a));
+  const auto b3 = static_cast<int32_t>(static_cast<int8_t>(b >> 24u));
+  const auto b2 = static_cast<int32_t>(static_cast<int8_t>(b >> 16u));
+  const auto b1 = static_cast<int32_t>(static_cast<int8_t>(b >> 8u));
+  const auto b0 = static_cast<int32_t>(static_cast<int8_t>(b));
+  const auto c3 = (static_cast<uint32_t>(div_allow_zero(a3, b3)) & 0x000000ffu) << 24u;
+  const auto c2 = (static_cast<uint32_t>(div_allow_zero(a2, b2)) & 0x000000ffu) << 16u;
+  const auto c1 = (static_cast<uint32_t>(div_allow_zero(a1, b1)) & 0x000000ffu) << 8u;
+  const auto c0 = static_cast<uint32_t>(div_allow_zero(a0, b0)) & 0x000000ffu;
+  return c3 | c2 | c1 | c0;
+}
+
+inline uint32_t divu32(const uint32_t a, const uint32_t b) {
+  return div_allow_zero(a, b);
+}
+
+inline uint32_t divu16x2(const uint32_t a, const uint32_t b) {
+  const auto a1 = a >> 16u;
+  const auto a0 = a & 0x0000ffff;
+  const auto b1 = b >> 16u;
+  const auto b0 = b & 0x0000ffff;
+  const auto c1 = div_allow_zero(a1, b1) << 16u;
+  const auto c0 = div_allow_zero(a0, b0);
+  return c1 | c0;
+}
+
+inline uint32_t divu8x4(const uint32_t a, const uint32_t b) {
+  const auto a3 = a >> 24u;
+  const auto a2 = (a >> 16u) & 0x000000ff;
+  const auto a1 = (a >> 8u) & 0x000000ff;
+  const auto a0 = a & 0x000000ff;
+  const auto b3 = b >> 24u;
+  const auto b2 = (b >> 16u) & 0x000000ff;
+  const auto b1 = (b >> 8u) & 0x000000ff;
+  const auto b0 = b & 0x000000ff;
+  const auto c3 = div_allow_zero(a3, b3) << 24u;
+  const auto c2 = div_allow_zero(a2, b2) << 16u;
+  const auto c1 = div_allow_zero(a1, b1) << 8u;
+  const auto c0 = div_allow_zero(a0, b0);
+  return c3 | c2 | c1 | c0;
+}
+
+inline uint32_t rem32(const uint32_t a, const uint32_t b) {
+  return static_cast<uint32_t>(mod_allow_zero(static_cast<int32_t>(a), static_cast<int32_t>(b)));
+}
+
+inline uint32_t rem16x2(const uint32_t a, const uint32_t b) {
+  const auto a1 = static_cast<int32_t>(static_cast<int16_t>(a >> 16u));
+  const auto a0 = static_cast<int32_t>(static_cast<int16_t>(a));
+  const auto b1 = static_cast<int32_t>(static_cast<int16_t>(b >> 16u));
+  const auto b0 = static_cast<int32_t>(static_cast<int16_t>(b));
+  const auto c1 = (static_cast<uint32_t>(mod_allow_zero(a1, b1)) & 0x0000ffffu) << 16u;
+  const auto c0 = static_cast<uint32_t>(mod_allow_zero(a0, b0)) & 0x0000ffffu;
+  return c1 | c0;
+}
+
+inline uint32_t rem8x4(const uint32_t a, const uint32_t b) {
+  const auto a3 = static_cast<int32_t>(static_cast<int8_t>(a >> 24u));
+  const auto a2 = static_cast<int32_t>(static_cast<int8_t>(a >> 16u));
+  const auto a1 = static_cast<int32_t>(static_cast<int8_t>(a >> 8u));
+  const auto a0 = static_cast<int32_t>(static_cast<int8_t>(a));
+  const auto b3 = static_cast<int32_t>(static_cast<int8_t>(b >> 24u));
+  const auto b2 = static_cast<int32_t>(static_cast<int8_t>(b >> 16u));
+  const auto b1 = static_cast<int32_t>(static_cast<int8_t>(b >> 8u));
+  const auto b0 = static_cast<int32_t>(static_cast<int8_t>(b));
+  const auto c3 = (static_cast<uint32_t>(mod_allow_zero(a3, b3)) & 0x000000ffu) << 24u;
+  const auto c2 = (static_cast<uint32_t>(mod_allow_zero(a2, b2)) & 0x000000ffu) << 16u;
+  const auto c1 = (static_cast<uint32_t>(mod_allow_zero(a1, b1)) & 0x000000ffu) << 8u;
+  const auto c0 = static_cast<uint32_t>(mod_allow_zero(a0, b0)) & 0x000000ffu;
+  return c3 | c2 | c1 | c0;
+}
+
+inline uint32_t remu32(const uint32_t a, const uint32_t b) {
+  return mod_allow_zero(a, b);
+}
+
+inline uint32_t remu16x2(const uint32_t a, const uint32_t b) {
+  const auto a1 = a >> 16u;
+  const auto a0 = a & 0x0000ffff;
+  const auto b1 = b >> 16u;
+  const auto b0 = b & 0x0000ffff;
+  const auto c1 = mod_allow_zero(a1, b1) << 16u;
+  const auto c0 = mod_allow_zero(a0, b0);
+  return c1 | c0;
+}
+
+inline uint32_t remu8x4(const uint32_t a, const uint32_t b) {
+  const auto a3 = a >> 24u;
+  const auto a2 = (a >> 16u) & 0x000000ff;
+  const auto a1 = (a >> 8u) & 0x000000ff;
+  const auto a0 = a & 0x000000ff;
+  const auto b3 = b >> 24u;
+  const auto b2 = (b >> 16u) & 0x000000ff;
+  const auto b1 = (b >> 8u) & 0x000000ff;
+  const auto b0 = b & 0x000000ff;
+  const auto c3 = mod_allow_zero(a3, b3) << 24u;
+  const auto c2 = mod_allow_zero(a2, b2) << 16u;
+  const auto c1 = mod_allow_zero(a1, b1) << 8u;
+  const auto c0 = mod_allow_zero(a0, b0);
+  return c3 | c2 | c1 | c0;
+}
+
+inline uint32_t fadd32(const uint32_t a, const uint32_t b) {
+  return as_u32(as_f32(a) + as_f32(b));
+}
+
+inline uint32_t fadd16x2(const uint32_t a, const uint32_t b) {
+  return (f16x2_t(a) + f16x2_t(b)).packf();
+}
+
+inline uint32_t fadd8x4(const uint32_t a, const uint32_t b) {
+  return (f8x4_t(a) + f8x4_t(b)).packf();
+}
+
+inline uint32_t fsub32(const uint32_t a, const uint32_t b) {
+  return as_u32(as_f32(a) - as_f32(b));
+}
+
+inline uint32_t fsub16x2(const uint32_t a, const uint32_t b) {
+  return (f16x2_t(a) - f16x2_t(b)).packf();
+}
+
+inline uint32_t fsub8x4(const uint32_t a, const uint32_t b) {
+  return (f8x4_t(a) - f8x4_t(b)).packf();
+}
+
+inline uint32_t fmul32(const uint32_t a, const uint32_t b) {
+  return as_u32(as_f32(a) * as_f32(b));
+}
+
+inline uint32_t fmul16x2(const uint32_t a, const uint32_t b) {
+  return (f16x2_t(a) * f16x2_t(b)).packf();
+}
+
+inline uint32_t fmul8x4(const uint32_t a, const uint32_t b) {
+  return (f8x4_t(a) * f8x4_t(b)).packf();
+}
+
+inline uint32_t fdiv32(const uint32_t a, const uint32_t b) {
+  return as_u32(as_f32(a) / as_f32(b));
+}
+
+inline uint32_t fdiv16x2(const uint32_t a, const uint32_t b) {
+  return (f16x2_t(a) / f16x2_t(b)).packf();
+}
+
+inline uint32_t fdiv8x4(const uint32_t a, const uint32_t b) {
+  return (f8x4_t(a) / f8x4_t(b)).packf();
+}
+
+inline uint32_t fsqrt32(const uint32_t a, const uint32_t b) {
+  (void)b;
+  return as_u32(std::sqrt(as_f32(a)));
+}
+
+inline uint32_t fsqrt16x2(const uint32_t a, const uint32_t b) {
+  (void)b;
+  return f16x2_t(a).sqrt().packf();
+}
+
+inline uint32_t fsqrt8x4(const uint32_t a, const uint32_t b) {
+  (void)b;
+  return f8x4_t(a).sqrt().packf();
+}
+
+inline uint32_t fmin32(const uint32_t a, const uint32_t b) {
+  return as_u32(std::min(as_f32(a), as_f32(b)));
+}
+
+inline uint32_t fmin16x2(const uint32_t a, const uint32_t b) {
+  return min(f16x2_t(a), f16x2_t(b)).packf();
+}
+
+inline uint32_t fmin8x4(const uint32_t a, const uint32_t b) {
+  return min(f8x4_t(a), f8x4_t(b)).packf();
+}
+
+inline uint32_t fmax32(const uint32_t a, const uint32_t b) {
+  return as_u32(std::max(as_f32(a), as_f32(b)));
+}
+
+inline uint32_t fmax16x2(const uint32_t a, const uint32_t b) {
+  return max(f16x2_t(a), f16x2_t(b)).packf();
+}
+
+inline uint32_t fmax8x4(const uint32_t a, const uint32_t b) {
+  return max(f8x4_t(a), f8x4_t(b)).packf();
+}
+
+inline uint32_t clz32(const uint32_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+  return (x == 0u) ? 32u : static_cast<uint32_t>(__builtin_clz(x));
+#else
+  uint32_t count = 0u;
+  for (; (count != 32u) && ((x & (0x80000000u >> count)) == 0u); ++count)
+    ;
+  return count;
+#endif
+}
+
+inline uint32_t clz16x2(const uint32_t x) {
+  return (clz32(x | 0x00008000u) << 16u) | (clz32((x << 16u) | 0x00008000u));
+}
+
+inline uint32_t clz8x4(const uint32_t x) {
+  return (clz32(x | 0x00800000u) << 24u) | (clz32((x << 8u) | 0x00800000u) << 16u) |
+         (clz32((x << 16u) | 0x00800000u) << 8u) | (clz32((x << 24u) | 0x00800000u));
+}
+
+inline uint32_t rev32(const uint32_t x) {
+  return ((x >> 31u) & 0x00000001u) | ((x >> 29u) & 0x00000002u) | ((x >> 27u) & 0x00000004u) |
+         ((x >> 25u) & 0x00000008u) | ((x >> 23u) & 0x00000010u) | ((x >> 21u) & 0x00000020u) |
+         ((x >> 19u) & 0x00000040u) | ((x >> 17u) & 0x00000080u) | ((x >> 15u) & 0x00000100u) |
+         ((x >> 13u) & 0x00000200u) | ((x >> 11u) & 0x00000400u) | ((x >> 9u) & 0x00000800u) |
+         ((x >> 7u) & 0x00001000u) | ((x >> 5u) & 0x00002000u) | ((x >> 3u) & 0x00004000u) |
+         ((x >> 1u) & 0x00008000u) | ((x << 1u) & 0x00010000u) | ((x << 3u) & 0x00020000u) |
+         ((x << 5u) & 0x00040000u) | ((x << 7u) & 0x00080000u) | ((x << 9u) & 0x00100000u) |
+         ((x << 11u) & 0x00200000u) | ((x << 13u) & 0x00400000u) | ((x << 15u) & 0x00800000u) |
+         ((x << 17u) & 0x01000000u) | ((x << 19u) & 0x02000000u) | ((x << 21u) & 0x04000000u) |
+         ((x << 23u) & 0x08000000u) | ((x << 25u) & 0x10000000u) | ((x << 27u) & 0x20000000u) |
+         ((x << 29u) & 0x40000000u) | ((x << 31u) & 0x80000000u);
+}
+
+inline uint32_t rev16x2(const uint32_t x) {
+  return ((x >> 15u) & 0x00010001u) | ((x >> 13u) & 0x00020002u) | ((x >> 11u) & 0x00040004u) |
+         ((x >> 9u) & 0x00080008u) | ((x >> 7u) & 0x00100010u) | ((x >> 5u) & 0x00200020u) |
+         ((x >> 3u) & 0x00400040u) | ((x >> 1u) & 0x00800080u) | ((x << 1u) & 0x01000100u) |
+         ((x << 3u) & 0x02000200u) | ((x << 5u) & 0x04000400u) | ((x << 7u) & 0x08000800u) |
+         ((x << 9u) & 0x10001000u) | ((x << 11u) & 0x20002000u) | ((x << 13u) & 0x40004000u) |
+         ((x << 15u) & 0x80008000u);
+}
+
+inline uint32_t rev8x4(const uint32_t x) {
+  return ((x >> 7u) & 0x01010101u) | ((x >> 5u) & 0x02020202u) | ((x >> 3u) & 0x04040404u) |
+         ((x >> 1u) & 0x08080808u) | ((x << 1u) & 0x10101010u) | ((x << 3u) & 0x20202020u) |
+         ((x << 5u) & 0x40404040u) | ((x << 7u) & 0x80808080u);
+}
+
+inline uint8_t shuf_op(const uint8_t x, const bool fill, const bool sign_fill) {
+  const uint8_t fill_bits = (sign_fill && ((x & 0x80u) != 0u)) ? 0xffu : 0x00u;
+  return fill ? fill_bits : x;
+}
+
+inline uint32_t shuf32(const uint32_t x, const uint32_t idx) {
+  // Extract the four bytes from x.
+  uint8_t xv[4];
+  xv[0] = static_cast<uint8_t>(x);
+  xv[1] = static_cast<uint8_t>(x >> 8u);
+  xv[2] = static_cast<uint8_t>(x >> 16u);
+  xv[3] = static_cast<uint8_t>(x >> 24u);
+
+  // Extract the four indices from idx.
+  uint8_t idxv[4];
+  idxv[0] = static_cast<uint8_t>(idx & 3u);
+  idxv[1] = static_cast<uint8_t>((idx >> 3u) & 3u);
+  idxv[2] = static_cast<uint8_t>((idx >> 6u) & 3u);
+  idxv[3] = static_cast<uint8_t>((idx >> 9u) & 3u);
+
+  // Extract the four fill operation descriptions from idx.
+  bool fillv[4];
+  fillv[0] = ((idx & 4u) != 0u);
+  fillv[1] = ((idx & (4u << 3u)) != 0u);
+  fillv[2] = ((idx & (4u << 6u)) != 0u);
+  fillv[3] = ((idx & (4u << 9u)) != 0u);
+
+  // Sign-fill or zero-fill?
+  const bool sign_fill = (((idx >> 12u) & 1u) != 0u);
+
+  // Combine the parts into four new bytes.
+  uint8_t yv[4];
+  yv[0] = shuf_op(xv[idxv[0]], fillv[0], sign_fill);
+  yv[1] = shuf_op(xv[idxv[1]], fillv[1], sign_fill);
+  yv[2] = shuf_op(xv[idxv[2]], fillv[2], sign_fill);
+  yv[3] = shuf_op(xv[idxv[3]], fillv[3], sign_fill);
+
+  // Combine the four bytes into a 32-bit word.
+  return static_cast<uint32_t>(yv[0]) | (static_cast<uint32_t>(yv[1]) << 8u) |
+         (static_cast<uint32_t>(yv[2]) << 16u) | (static_cast<uint32_t>(yv[3]) << 24u);
+}
+
+inline uint32_t packb32(const uint32_t a, const uint32_t b) {
+  return ((a & 0x00ff0000u) << 8u) | ((a & 0x000000ffu) << 16u) | ((b & 0x00ff0000u) >> 8u) |
+         (b & 0x000000ffu);
+}
+
+inline uint32_t packh32(const uint32_t a, const uint32_t b) {
+  return ((a & 0x0000ffffu) << 16) | (b & 0x0000ffffu);
+}
+
+inline bool float32_isnan(const uint32_t x) {
+  return ((x & 0x7F800000u) == 0x7F800000u) && ((x & 0x007fffffu) != 0u);
+}
+
+inline uint32_t itof32(const uint32_t a, const uint32_t b) {
+  const float f = static_cast<float>(static_cast<int32_t>(a));
+  return as_u32(std::ldexp(f, -static_cast<int32_t>(b)));
+}
+
+inline uint32_t itof16x2(const uint32_t a, const uint32_t b) {
+  return f16x2_t::itof(a, b).packf();
+}
+
+inline uint32_t itof8x4(const uint32_t a, const uint32_t b) {
+  return f8x4_t::itof(a, b).packf();
+}
+
+inline uint32_t utof32(const uint32_t a, const uint32_t b) {
+  const float f = static_cast<float>(a);
+  return as_u32(std::ldexp(f, -static_cast<int32_t>(b)));
+}
+
+inline uint32_t utof16x2(const uint32_t a, const uint32_t b) {
+  return f16x2_t::utof(a, b).packf();
+}
+
+inline uint32_t utof8x4(const uint32_t a, const uint32_t b) {
+  return f8x4_t::utof(a, b).packf();
+}
+
+inline uint32_t ftoi32(const uint32_t a, const uint32_t b) {
+  const float f = std::ldexp(as_f32(a), static_cast<int32_t>(b));
+  return static_cast<uint32_t>(static_cast<int32_t>(f));
+}
+
+inline uint32_t ftoi16x2(const uint32_t a, const uint32_t b) {
+  return f16x2_t(a).packi(b);
+}
+
+inline uint32_t ftoi8x4(const uint32_t a, const uint32_t b) {
+  return f8x4_t(a).packi(b);
+}
+
+inline uint32_t ftou32(const uint32_t a, const uint32_t b) {
+  const float f = std::ldexp(as_f32(a), static_cast<int32_t>(b));
+  return static_cast<uint32_t>(f);
+}
+
+inline uint32_t ftou16x2(const uint32_t a, const uint32_t b) {
+  return f16x2_t(a).packu(b);
+}
+
+inline uint32_t ftou8x4(const uint32_t a, const uint32_t b) {
+  return f8x4_t(a).packu(b);
+}
+
+inline uint32_t ftoir32(const uint32_t a, const uint32_t b) {
+  const float f = std::ldexp(as_f32(a), static_cast<int32_t>(b));
+  return static_cast<uint32_t>(static_cast<int32_t>(std::round(f)));
+}
+
+inline uint32_t ftoir16x2(const uint32_t a, const uint32_t b) {
+  return f16x2_t(a).packir(b);
+}
+
+inline uint32_t ftoir8x4(const uint32_t a, const uint32_t b) {
+  return f8x4_t(a).packir(b);
+}
+
+inline uint32_t ftour32(const uint32_t a, const uint32_t b) {
+  const float f = std::ldexp(as_f32(a), static_cast<int32_t>(b));
+  return static_cast<uint32_t>(std::round(f));
+}
+
+inline uint32_t ftour16x2(const uint32_t a, const uint32_t b) {
+  return f16x2_t(a).packur(b);
+}
+
+inline uint32_t ftour8x4(const uint32_t a, const uint32_t b) {
+  return f8x4_t(a).packur(b);
+}
+
+inline uint32_t cpu_t::execute_alu(const uint32_t ex_op,
+                                   const uint32_t packed_mode,
+                                   const uint32_t src_a,
+                                   const uint32_t src_b) {
+  uint32_t ex_result = 0u;
+  switch (ex_op) {
+    case EX_OP_CPUID:
+      ex_result = cpuid32(src_a, src_b);
+      break;
+
+    case EX_OP_LDHI:
+      ex_result = src_b << 11u;
+      break;
+    case EX_OP_LDHIO:
+      ex_result = (src_b << 11u) | 0x7ffu;
+      break;
+    case EX_OP_ADDPCHI:
+      ex_result = src_a + (src_b << 11u);
+      break;
+
+    case EX_OP_OR:
+      ex_result = src_a | src_b;
+      break;
+    case EX_OP_NOR:
+      ex_result = ~(src_a | src_b);
+      break;
+    case EX_OP_AND:
+      ex_result = src_a & src_b;
+      break;
+    case EX_OP_BIC:
+      ex_result = src_a & ~src_b;
+      break;
+    case EX_OP_XOR:
+      ex_result = src_a ^ src_b;
+      break;
+    case EX_OP_ADD:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = add8x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = add16x2(src_a, src_b);
+          break;
+        default:
+          ex_result = add32(src_a, src_b);
+      }
+      break;
+    case EX_OP_SUB:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = sub8x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = sub16x2(src_a, src_b);
+          break;
+        default:
+          ex_result = sub32(src_a, src_b);
+      }
+      break;
+    case EX_OP_SEQ:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result =
+              set8x4(src_a, src_b, [](uint8_t a, uint8_t b) { return a == b; });
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = set16x2(
+              src_a, src_b, [](uint16_t a, uint16_t b) { return a == b; });
+          break;
+        default:
+          ex_result = set32(
+              src_a, src_b, [](uint32_t a, uint32_t b) { return a == b; });
+      }
+      break;
+    case EX_OP_SNE:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result =
+              set8x4(src_a, src_b, [](uint8_t a, uint8_t b) { return a != b; });
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = set16x2(
+              src_a, src_b, [](uint16_t a, uint16_t b) { return a != b; });
+          break;
+        default:
+          ex_result = set32(
+              src_a, src_b, [](uint32_t a, uint32_t b) { return a != b; });
+      }
+      break;
+    case EX_OP_SLT:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = set8x4(src_a, src_b, [](uint8_t a, uint8_t b) {
+            return static_cast<int8_t>(a) < static_cast<int8_t>(b);
+          });
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = set16x2(src_a, src_b, [](uint16_t a, uint16_t b) {
+            return static_cast<int16_t>(a) < static_cast<int16_t>(b);
+          });
+          break;
+        default:
+          ex_result = set32(src_a, src_b, [](uint32_t a, uint32_t b) {
+            return static_cast<int32_t>(a) < static_cast<int32_t>(b);
+          });
+      }
+      break;
+    case EX_OP_SLTU:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result =
+              set8x4(src_a, src_b, [](uint8_t a, uint8_t b) { return a < b; });
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = set16x2(
+              src_a, src_b, [](uint16_t a, uint16_t b) { return a < b; });
+          break;
+        default:
+          ex_result =
+              set32(src_a, src_b, [](uint32_t a, uint32_t b) { return a < b; });
+      }
+      break;
+    case EX_OP_SLE:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = set8x4(src_a, src_b, [](uint8_t a, uint8_t b) {
+            return static_cast<int8_t>(a) <= static_cast<int8_t>(b);
+          });
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = set16x2(src_a, src_b, [](uint16_t a, uint16_t b) {
+            return static_cast<int16_t>(a) <= static_cast<int16_t>(b);
+          });
+          break;
+        default:
+          ex_result = set32(src_a, src_b, [](uint32_t a, uint32_t b) {
+            return static_cast<int32_t>(a) <= static_cast<int32_t>(b);
+          });
+      }
+      break;
+    case EX_OP_SLEU:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result =
+              set8x4(src_a, src_b, [](uint8_t a, uint8_t b) { return a <= b; });
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = set16x2(
+              src_a, src_b, [](uint16_t a, uint16_t b) { return a <= b; });
+          break;
+        default:
+          ex_result = set32(
+              src_a, src_b, [](uint32_t a, uint32_t b) { return a <= b; });
+      }
+      break;
+    case EX_OP_MIN:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = sel32(src_a,
+                            src_b,
+                            set8x4(src_a, src_b, [](uint8_t x, uint8_t y) {
+                              return static_cast<int8_t>(x) < static_cast<int8_t>(y);
+                            }));
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = sel32(src_a,
+                            src_b,
+                            set16x2(src_a, src_b, [](uint16_t x, uint16_t y) {
+                              return static_cast<int16_t>(x) < static_cast<int16_t>(y);
+                            }));
+          break;
+        default:
+          ex_result = sel32(src_a,
+                            src_b,
+                            set32(src_a, src_b, [](uint32_t x, uint32_t y) {
+                              return static_cast<int32_t>(x) < static_cast<int32_t>(y);
+                            }));
+      }
+      break;
+    case EX_OP_MAX:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = sel32(src_a,
+                            src_b,
+                            set8x4(src_a, src_b, [](uint8_t x, uint8_t y) {
+                              return static_cast<int8_t>(x) > static_cast<int8_t>(y);
+                            }));
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = sel32(src_a,
+                            src_b,
+                            set16x2(src_a, src_b, [](uint16_t x, uint16_t y) {
+                              return static_cast<int16_t>(x) > static_cast<int16_t>(y);
+                            }));
+          break;
+        default:
+          ex_result = sel32(src_a,
+                            src_b,
+                            set32(src_a, src_b, [](uint32_t x, uint32_t y) {
+                              return static_cast<int32_t>(x) > static_cast<int32_t>(y);
+                            }));
+      }
+      break;
+    case EX_OP_MINU:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = sel32(
+              src_a,
+              src_b,
+              set8x4(src_a, src_b, [](uint8_t x, uint8_t y) { return x < y; }));
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = sel32(src_a,
+                            src_b,
+                            set16x2(src_a, src_b, [](uint16_t x, uint16_t y) {
+                              return x < y;
+                            }));
+          break;
+        default:
+          ex_result = sel32(src_a,
+                            src_b,
+                            set32(src_a, src_b, [](uint32_t x, uint32_t y) {
+                              return x < y;
+                            }));
+      }
+      break;
+    case EX_OP_MAXU:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = sel32(
+              src_a,
+              src_b,
+              set8x4(src_a, src_b, [](uint8_t x, uint8_t y) { return x > y; }));
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = sel32(src_a,
+                            src_b,
+                            set16x2(src_a, src_b, [](uint16_t x, uint16_t y) {
+                              return x > y;
+                            }));
+          break;
+        default:
+          ex_result = sel32(src_a,
+                            src_b,
+                            set32(src_a, src_b, [](uint32_t x, uint32_t y) {
+                              return x > y;
+                            }));
+      }
+      break;
+    case EX_OP_ASR:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = asr8x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = asr16x2(src_a, src_b);
+          break;
+        default:
+          ex_result = asr32(src_a, src_b);
+      }
+      break;
+    case EX_OP_LSL:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = lsl8x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = lsl16x2(src_a, src_b);
+          break;
+        default:
+          ex_result = lsl32(src_a, src_b);
+      }
+      break;
+    case EX_OP_LSR:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = lsr8x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = lsr16x2(src_a, src_b);
+          break;
+        default:
+          ex_result = lsr32(src_a, src_b);
+      }
+      break;
+    case EX_OP_SHUF:
+      ex_result = shuf32(src_a, src_b);
+      break;
+    case EX_OP_CLZ:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = clz8x4(src_a);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = clz16x2(src_a);
+          break;
+        default:
+          ex_result = clz32(src_a);
+      }
+      break;
+    case EX_OP_REV:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = rev8x4(src_a);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = rev16x2(src_a);
+          break;
+        default:
+          ex_result = rev32(src_a);
+      }
+      break;
+    case EX_OP_PACKB:
+      ex_result = packb32(src_a, src_b);
+      break;
+    case EX_OP_PACKH:
+      ex_result = packh32(src_a, src_b);
+      break;
+
+    case EX_OP_ADDS:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = saturating_op_8x4(
+              src_a, src_b, [](int16_t x, int16_t y) -> int16_t {
+                return x + y;
+              });
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = saturating_op_16x2(
+              src_a, src_b, [](int32_t x, int32_t y) -> int32_t {
+                return x + y;
+              });
+          break;
+        default:
+          ex_result = saturating_op_32(
+              src_a, src_b, [](int64_t x, int64_t y) -> int64_t {
+                return x + y;
+              });
+      }
+      break;
+    case EX_OP_ADDSU:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = saturating_op_u8x4(
+              src_a, src_b, [](uint16_t x, uint16_t y) -> uint16_t {
+                return x + y;
+              });
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = saturating_op_u16x2(
+              src_a, src_b, [](uint32_t x, uint32_t y) -> uint32_t {
+                return x + y;
+              });
+          break;
+        default:
+          ex_result = saturating_op_u32(
+              src_a, src_b, [](uint64_t x, uint64_t y) -> uint64_t {
+                return x + y;
+              });
+      }
+      break;
+    case EX_OP_ADDH:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = halving_op_8x4(src_a,
+                                     src_b,
+                                     [](int16_t x, int16_t y) -> int16_t { return x + y; });
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = halving_op_16x2(
+              src_a, src_b, [](int32_t x, int32_t y) -> int32_t {
+                return x + y;
+              });
+          break;
+        default:
+          ex_result = halving_op_32(src_a,
+                                    src_b,
+                                    [](int64_t x, int64_t y) -> int64_t { return x + y; });
+      }
+      break;
+    case EX_OP_ADDHU:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = halving_op_u8x4(
+              src_a, src_b, [](uint16_t x, uint16_t y) -> uint16_t {
+                return x + y;
+              });
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = halving_op_u16x2(
+              src_a, src_b, [](uint32_t x, uint32_t y) -> uint32_t {
+                return x + y;
+              });
+          break;
+        default:
+          ex_result = halving_op_u32(
+              src_a, src_b, [](uint64_t x, uint64_t y) -> uint64_t {
+                return x + y;
+              });
+      }
+      break;
+    case EX_OP_SUBS:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = saturating_op_8x4(
+              src_a, src_b, [](int16_t x, int16_t y) -> int16_t {
+                return x - y;
+              });
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = saturating_op_16x2(
+              src_a, src_b, [](int32_t x, int32_t y) -> int32_t {
+                return x - y;
+              });
+          break;
+        default:
+          ex_result = saturating_op_32(
+              src_a, src_b, [](int64_t x, int64_t y) -> int64_t {
+                return x - y;
+              });
+      }
+      break;
+    case EX_OP_SUBSU:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = saturating_op_u8x4(
+              src_a, src_b, [](uint16_t x, uint16_t y) -> uint16_t {
+                return x - y;
+              });
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = saturating_op_u16x2(
+              src_a, src_b, [](uint32_t x, uint32_t y) -> uint32_t {
+                return x - y;
+              });
+          break;
+        default:
+          ex_result = saturating_op_u32(
+              src_a, src_b, [](uint64_t x, uint64_t y) -> uint64_t {
+                return x - y;
+              });
+      }
+      break;
+    case EX_OP_SUBH:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = halving_op_8x4(src_a,
+                                     src_b,
+                                     [](int16_t x, int16_t y) -> int16_t { return x - y; });
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = halving_op_16x2(
+              src_a, src_b, [](int32_t x, int32_t y) -> int32_t {
+                return x - y;
+              });
+          break;
+        default:
+          ex_result = halving_op_32(src_a,
+                                    src_b,
+                                    [](int64_t x, int64_t y) -> int64_t { return x - y; });
+      }
+      break;
+    case EX_OP_SUBHU:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = halving_op_u8x4(
+              src_a, src_b, [](uint16_t x, uint16_t y) -> uint16_t {
+                return x - y;
+              });
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = halving_op_u16x2(
+              src_a, src_b, [](uint32_t x, uint32_t y) -> uint32_t {
+                return x - y;
+              });
+          break;
+        default:
+          ex_result = halving_op_u32(
+              src_a, src_b, [](uint64_t x, uint64_t y) -> uint64_t {
+                return x - y;
+              });
+      }
+      break;
+
+    case EX_OP_MULQ:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = mulq7x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = mulq15x2(src_a, src_b);
+          break;
+        default:
+          ex_result = mulq31(src_a, src_b);
+      }
+      break;
+    case EX_OP_MUL:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = mul8x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = mul16x2(src_a, src_b);
+          break;
+        default:
+          ex_result = mul32(src_a, src_b);
+      }
+      break;
+    case EX_OP_MULHI:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = mulhi8x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = mulhi16x2(src_a, src_b);
+          break;
+        default:
+          ex_result = mulhi32(src_a, src_b);
+      }
+      break;
+    case EX_OP_MULHIU:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = mulhiu8x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = mulhiu16x2(src_a, src_b);
+          break;
+        default:
+          ex_result = mulhiu32(src_a, src_b);
+      }
+      break;
+
+    case EX_OP_DIV:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = div8x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = div16x2(src_a, src_b);
+          break;
+        default:
+          ex_result = div32(src_a, src_b);
+      }
+      break;
+    case EX_OP_DIVU:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = divu8x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = divu16x2(src_a, src_b);
+          break;
+        default:
+          ex_result = divu32(src_a, src_b);
+      }
+      break;
+    case EX_OP_REM:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = rem8x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = rem16x2(src_a, src_b);
+          break;
+        default:
+          ex_result = rem32(src_a, src_b);
+      }
+      break;
+    case EX_OP_REMU:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = remu8x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = remu16x2(src_a, src_b);
+          break;
+        default:
+          ex_result = remu32(src_a, src_b);
+      }
+      break;
+
+    case EX_OP_ITOF:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = itof8x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = itof16x2(src_a, src_b);
+          break;
+        default:
+          ex_result = itof32(src_a, src_b);
+      }
+      break;
+    case EX_OP_UTOF:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = utof8x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = utof16x2(src_a, src_b);
+          break;
+        default:
+          ex_result = utof32(src_a, src_b);
+      }
+      break;
+    case EX_OP_FTOI:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = ftoi8x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = ftoi16x2(src_a, src_b);
+          break;
+        default:
+          ex_result = ftoi32(src_a, src_b);
+      }
+      break;
+    case EX_OP_FTOU:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = ftou8x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = ftou16x2(src_a, src_b);
+          break;
+        default:
+          ex_result = ftou32(src_a, src_b);
+      }
+      break;
+    case EX_OP_FTOIR:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = ftoir8x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = ftoir16x2(src_a, src_b);
+          break;
+        default:
+          ex_result = ftoir32(src_a, src_b);
+      }
+      break;
+    case EX_OP_FTOUR:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = ftour8x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = ftour16x2(src_a, src_b);
+          break;
+        default:
+          ex_result = ftour32(src_a, src_b);
+      }
+      break;
+    case EX_OP_FADD:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = fadd8x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = fadd16x2(src_a, src_b);
+          break;
+        default:
+          ex_result = fadd32(src_a, src_b);
+      }
+      break;
+    case EX_OP_FSUB:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = fsub8x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = fsub16x2(src_a, src_b);
+          break;
+        default:
+          ex_result = fsub32(src_a, src_b);
+      }
+      break;
+    case EX_OP_FMUL:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = fmul8x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = fmul16x2(src_a, src_b);
+          break;
+        default:
+          ex_result = fmul32(src_a, src_b);
+      }
+      break;
+    case EX_OP_FDIV:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = fdiv8x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = fdiv16x2(src_a, src_b);
+          break;
+        default:
+          ex_result = fdiv32(src_a, src_b);
+      }
+      break;
+    case EX_OP_FSQRT:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = fsqrt8x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = fsqrt16x2(src_a, src_b);
+          break;
+        default:
+          ex_result = fsqrt32(src_a, src_b);
+      }
+      break;
+    case EX_OP_FSEQ:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = f8x4_t(src_a).fseq(f8x4_t(src_b));
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = f16x2_t(src_a).fseq(f16x2_t(src_b));
+          break;
+        default:
+          ex_result = set32(src_a, src_b, [](uint32_t a, uint32_t b) {
+            return as_f32(a) == as_f32(b);
+          });
+      }
+      break;
+    case EX_OP_FSNE:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = f8x4_t(src_a).fsne(f8x4_t(src_b));
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = f16x2_t(src_a).fsne(f16x2_t(src_b));
+          break;
+        default:
+          ex_result = set32(src_a, src_b, [](uint32_t a, uint32_t b) {
+            return as_f32(a) != as_f32(b);
+          });
+      }
+      break;
+    case EX_OP_FSLT:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = f8x4_t(src_a).fsle(f8x4_t(src_b));
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = f16x2_t(src_a).fslt(f16x2_t(src_b));
+          break;
+        default:
+          ex_result = set32(src_a, src_b, [](uint32_t a, uint32_t b) {
+            return as_f32(a) < as_f32(b);
+          });
+      }
+      break;
+    case EX_OP_FSLE:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = f8x4_t(src_a).fsle(f8x4_t(src_b));
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = f16x2_t(src_a).fsle(f16x2_t(src_b));
+          break;
+        default:
+          ex_result = set32(src_a, src_b, [](uint32_t a, uint32_t b) {
+            return as_f32(a) <= as_f32(b);
+          });
+      }
+      break;
+    case EX_OP_FSNAN:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = f8x4_t(src_a).fsnan(f8x4_t(src_b));
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = f16x2_t(src_a).fsnan(f16x2_t(src_b));
+          break;
+        default:
+          ex_result = set32(src_a, src_b, [](uint32_t a, uint32_t b) {
+            return float32_isnan(a) || float32_isnan(b);
+          });
+      }
+      break;
+    case EX_OP_FMIN:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = fmin8x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = fmin16x2(src_a, src_b);
+          break;
+        default:
+          ex_result = fmin32(src_a, src_b);
+      }
+      break;
+    case EX_OP_FMAX:
+      switch (packed_mode) {
+        case PACKED_BYTE:
+          ex_result = fmax8x4(src_a, src_b);
+          break;
+        case PACKED_HALF_WORD:
+          ex_result = fmax16x2(src_a, src_b);
+          break;
+        default:
+          ex_result = fmax32(src_a, src_b);
+      }
+      break;
+  }
+  return ex_result;
+}
+
+#endif  // SIM_ALU_HPP_
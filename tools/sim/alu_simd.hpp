@@ -0,0 +1,627 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------------------------------
+// This file contains host SIMD implementations of common vector ALU operations. They produce
+// exactly the same results as the scalar ALU operations in alu.hpp, but process several vector
+// elements per host instruction.
+//
+// SSE2 kernels are used on all x86-64 hosts. AVX2 kernels (including variable shifts) are used if
+// the compiler targets AVX2 (e.g. with -mavx2 or -march=native).
+//--------------------------------------------------------------------------------------------------
+
+#ifndef SIM_ALU_SIMD_HPP_
+#define SIM_ALU_SIMD_HPP_
+
+#include "alu.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define ALU_SIMD_SSE2
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ALU_SIMD_AVX2
+#endif
+
+#ifdef ALU_SIMD_SSE2
+namespace simd {
+
+// 128-bit vectors (4 x 32 bits).
+struct v128_t {
+  using vec_t = __m128i;
+  enum { WIDTH = 4 };
+
+  static vec_t load(const uint32_t* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  }
+  static void store(uint32_t* p, const vec_t x) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), x);
+  }
+  static vec_t splat(const uint32_t x) {
+    return _mm_set1_epi32(static_cast<int>(x));
+  }
+
+  static vec_t or_(const vec_t a, const vec_t b) {
+    return _mm_or_si128(a, b);
+  }
+  static vec_t and_(const vec_t a, const vec_t b) {
+    return _mm_and_si128(a, b);
+  }
+  static vec_t xor_(const vec_t a, const vec_t b) {
+    return _mm_xor_si128(a, b);
+  }
+  static vec_t andnot(const vec_t a, const vec_t b) {
+    return _mm_andnot_si128(a, b);  // ~a & b
+  }
+  static vec_t not_(const vec_t a) {
+    return _mm_xor_si128(a, _mm_set1_epi32(-1));
+  }
+  static vec_t sel(const vec_t a, const vec_t b, const vec_t mask) {
+    return _mm_or_si128(_mm_and_si128(a, mask), _mm_andnot_si128(mask, b));
+  }
+
+  static vec_t add8(const vec_t a, const vec_t b) {
+    return _mm_add_epi8(a, b);
+  }
+  static vec_t add16(const vec_t a, const vec_t b) {
+    return _mm_add_epi16(a, b);
+  }
+  static vec_t add32(const vec_t a, const vec_t b) {
+    return _mm_add_epi32(a, b);
+  }
+  static vec_t sub8(const vec_t a, const vec_t b) {
+    return _mm_sub_epi8(a, b);
+  }
+  static vec_t sub16(const vec_t a, const vec_t b) {
+    return _mm_sub_epi16(a, b);
+  }
+  static vec_t sub32(const vec_t a, const vec_t b) {
+    return _mm_sub_epi32(a, b);
+  }
+  static vec_t adds8(const vec_t a, const vec_t b) {
+    return _mm_adds_epi8(a, b);
+  }
+  static vec_t adds16(const vec_t a, const vec_t b) {
+    return _mm_adds_epi16(a, b);
+  }
+  static vec_t addsu8(const vec_t a, const vec_t b) {
+    return _mm_adds_epu8(a, b);
+  }
+  static vec_t addsu16(const vec_t a, const vec_t b) {
+    return _mm_adds_epu16(a, b);
+  }
+  static vec_t subs8(const vec_t a, const vec_t b) {
+    return _mm_subs_epi8(a, b);
+  }
+  static vec_t subs16(const vec_t a, const vec_t b) {
+    return _mm_subs_epi16(a, b);
+  }
+  static vec_t subsu8(const vec_t a, const vec_t b) {
+    return _mm_subs_epu8(a, b);
+  }
+  static vec_t subsu16(const vec_t a, const vec_t b) {
+    return _mm_subs_epu16(a, b);
+  }
+
+  static vec_t cmpeq8(const vec_t a, const vec_t b) {
+    return _mm_cmpeq_epi8(a, b);
+  }
+  static vec_t cmpeq16(const vec_t a, const vec_t b) {
+    return _mm_cmpeq_epi16(a, b);
+  }
+  static vec_t cmpeq32(const vec_t a, const vec_t b) {
+    return _mm_cmpeq_epi32(a, b);
+  }
+  static vec_t cmpgt8(const vec_t a, const vec_t b) {
+    return _mm_cmpgt_epi8(a, b);
+  }
+  static vec_t cmpgt16(const vec_t a, const vec_t b) {
+    return _mm_cmpgt_epi16(a, b);
+  }
+  static vec_t cmpgt32(const vec_t a, const vec_t b) {
+    return _mm_cmpgt_epi32(a, b);
+  }
+
+  static vec_t mul16(const vec_t a, const vec_t b) {
+    return _mm_mullo_epi16(a, b);
+  }
+  static vec_t mulhi16(const vec_t a, const vec_t b) {
+    return _mm_mulhi_epi16(a, b);
+  }
+  static vec_t mulhiu16(const vec_t a, const vec_t b) {
+    return _mm_mulhi_epu16(a, b);
+  }
+  static vec_t mulq16(const vec_t a, const vec_t b) {
+    // Bits 15..30 of the 32-bit product.
+    return _mm_or_si128(_mm_slli_epi16(_mm_mulhi_epi16(a, b), 1),
+                        _mm_srli_epi16(_mm_mullo_epi16(a, b), 15));
+  }
+  static vec_t mul32(const vec_t a, const vec_t b) {
+#ifdef ALU_SIMD_AVX2
+    return _mm_mullo_epi32(a, b);
+#else
+    // SSE2 only has a 32x32->64-bit multiplication of the even elements.
+    const __m128i even = _mm_mul_epu32(a, b);
+    const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+#endif
+  }
+
+#ifdef ALU_SIMD_AVX2
+  // Note: Shift counts are masked to five bits, just like the x86 scalar shift instructions.
+  static vec_t sll32(const vec_t a, const vec_t b) {
+    return _mm_sllv_epi32(a, _mm_and_si128(b, _mm_set1_epi32(31)));
+  }
+  static vec_t srl32(const vec_t a, const vec_t b) {
+    return _mm_srlv_epi32(a, _mm_and_si128(b, _mm_set1_epi32(31)));
+  }
+  static vec_t sra32(const vec_t a, const vec_t b) {
+    return _mm_srav_epi32(a, _mm_and_si128(b, _mm_set1_epi32(31)));
+  }
+#endif
+
+  static vec_t fadd(const vec_t a, const vec_t b) {
+    return _mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b)));
+  }
+  static vec_t fsub(const vec_t a, const vec_t b) {
+    return _mm_castps_si128(_mm_sub_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b)));
+  }
+  static vec_t fmul(const vec_t a, const vec_t b) {
+    return _mm_castps_si128(_mm_mul_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b)));
+  }
+  static vec_t fdiv(const vec_t a, const vec_t b) {
+    return _mm_castps_si128(_mm_div_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b)));
+  }
+  static vec_t fcmplt(const vec_t a, const vec_t b) {
+    return _mm_castps_si128(_mm_cmplt_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b)));
+  }
+  static bool any_nan(const vec_t a) {
+    const __m128 x = _mm_castsi128_ps(a);
+    return _mm_movemask_ps(_mm_cmpunord_ps(x, x)) != 0;
+  }
+};
+
+#ifdef ALU_SIMD_AVX2
+// 256-bit vectors (8 x 32 bits).
+struct v256_t {
+  using vec_t = __m256i;
+  enum { WIDTH = 8 };
+
+  static vec_t load(const uint32_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  }
+  static void store(uint32_t* p, const vec_t x) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), x);
+  }
+  static vec_t splat(const uint32_t x) {
+    return _mm256_set1_epi32(static_cast<int>(x));
+  }
+
+  static vec_t or_(const vec_t a, const vec_t b) {
+    return _mm256_or_si256(a, b);
+  }
+  static vec_t and_(const vec_t a, const vec_t b) {
+    return _mm256_and_si256(a, b);
+  }
+  static vec_t xor_(const vec_t a, const vec_t b) {
+    return _mm256_xor_si256(a, b);
+  }
+  static vec_t andnot(const vec_t a, const vec_t b) {
+    return _mm256_andnot_si256(a, b);  // ~a & b
+  }
+  static vec_t not_(const vec_t a) {
+    return _mm256_xor_si256(a, _mm256_set1_epi32(-1));
+  }
+  static vec_t sel(const vec_t a, const vec_t b, const vec_t mask) {
+    return _mm256_blendv_epi8(b, a, mask);
+  }
+
+  static vec_t add8(const vec_t a, const vec_t b) {
+    return _mm256_add_epi8(a, b);
+  }
+  static vec_t add16(const vec_t a, const vec_t b) {
+    return _mm256_add_epi16(a, b);
+  }
+  static vec_t add32(const vec_t a, const vec_t b) {
+    return _mm256_add_epi32(a, b);
+  }
+  static vec_t sub8(const vec_t a, const vec_t b) {
+    return _mm256_sub_epi8(a, b);
+  }
+  static vec_t sub16(const vec_t a, const vec_t b) {
+    return _mm256_sub_epi16(a, b);
+  }
+  static vec_t sub32(const vec_t a, const vec_t b) {
+    return _mm256_sub_epi32(a, b);
+  }
+  static vec_t adds8(const vec_t a, const vec_t b) {
+    return _mm256_adds_epi8(a, b);
+  }
+  static vec_t adds16(const vec_t a, const vec_t b) {
+    return _mm256_adds_epi16(a, b);
+  }
+  static vec_t addsu8(const vec_t a, const vec_t b) {
+    return _mm256_adds_epu8(a, b);
+  }
+  static vec_t addsu16(const vec_t a, const vec_t b) {
+    return _mm256_adds_epu16(a, b);
+  }
+  static vec_t subs8(const vec_t a, const vec_t b) {
+    return _mm256_subs_epi8(a, b);
+  }
+  static vec_t subs16(const vec_t a, const vec_t b) {
+    return _mm256_subs_epi16(a, b);
+  }
+  static vec_t subsu8(const vec_t a, const vec_t b) {
+    return _mm256_subs_epu8(a, b);
+  }
+  static vec_t subsu16(const vec_t a, const vec_t b) {
+    return _mm256_subs_epu16(a, b);
+  }
+
+  static vec_t cmpeq8(const vec_t a, const vec_t b) {
+    return _mm256_cmpeq_epi8(a, b);
+  }
+  static vec_t cmpeq16(const vec_t a, const vec_t b) {
+    return _mm256_cmpeq_epi16(a, b);
+  }
+  static vec_t cmpeq32(const vec_t a, const vec_t b) {
+    return _mm256_cmpeq_epi32(a, b);
+  }
+  static vec_t cmpgt8(const vec_t a, const vec_t b) {
+    return _mm256_cmpgt_epi8(a, b);
+  }
+  static vec_t cmpgt16(const vec_t a, const vec_t b) {
+    return _mm256_cmpgt_epi16(a, b);
+  }
+  static vec_t cmpgt32(const vec_t a, const vec_t b) {
+    return _mm256_cmpgt_epi32(a, b);
+  }
+
+  static vec_t mul16(const vec_t a, const vec_t b) {
+    return _mm256_mullo_epi16(a, b);
+  }
+  static vec_t mulhi16(const vec_t a, const vec_t b) {
+    return _mm256_mulhi_epi16(a, b);
+  }
+  static vec_t mulhiu16(const vec_t a, const vec_t b) {
+    return _mm256_mulhi_epu16(a, b);
+  }
+  static vec_t mulq16(const vec_t a, const vec_t b) {
+    // Bits 15..30 of the 32-bit product.
+    return _mm256_or_si256(_mm256_slli_epi16(_mm256_mulhi_epi16(a, b), 1),
+                           _mm256_srli_epi16(_mm256_mullo_epi16(a, b), 15));
+  }
+  static vec_t mul32(const vec_t a, const vec_t b) {
+    return _mm256_mullo_epi32(a, b);
+  }
+
+  // Note: Shift counts are masked to five bits, just like the x86 scalar shift instructions.
+  static vec_t sll32(const vec_t a, const vec_t b) {
+    return _mm256_sllv_epi32(a, _mm256_and_si256(b, _mm256_set1_epi32(31)));
+  }
+  static vec_t srl32(const vec_t a, const vec_t b) {
+    return _mm256_srlv_epi32(a, _mm256_and_si256(b, _mm256_set1_epi32(31)));
+  }
+  static vec_t sra32(const vec_t a, const vec_t b) {
+    return _mm256_srav_epi32(a, _mm256_and_si256(b, _mm256_set1_epi32(31)));
+  }
+
+  static vec_t fadd(const vec_t a, const vec_t b) {
+    return _mm256_castps_si256(_mm256_add_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b)));
+  }
+  static vec_t fsub(const vec_t a, const vec_t b) {
+    return _mm256_castps_si256(_mm256_sub_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b)));
+  }
+  static vec_t fmul(const vec_t a, const vec_t b) {
+    return _mm256_castps_si256(_mm256_mul_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b)));
+  }
+  static vec_t fdiv(const vec_t a, const vec_t b) {
+    return _mm256_castps_si256(_mm256_div_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b)));
+  }
+  static vec_t fcmplt(const vec_t a, const vec_t b) {
+    return _mm256_castps_si256(
+        _mm256_cmp_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b), _CMP_LT_OQ));
+  }
+  static bool any_nan(const vec_t a) {
+    const __m256 x = _mm256_castsi256_ps(a);
+    return _mm256_movemask_ps(_mm256_cmp_ps(x, x, _CMP_UNORD_Q)) != 0;
+  }
+};
+#endif  // ALU_SIMD_AVX2
+
+// Operations that depend on the lane size (8, 16 or 32 bits).
+template <typename V, int LANE_BITS>
+struct lanes_t;
+
+template <typename V>
+struct lanes_t<V, 8> : public V {
+  using vec_t = typename V::vec_t;
+  static vec_t add(const vec_t a, const vec_t b) {
+    return V::add8(a, b);
+  }
+  static vec_t sub(const vec_t a, const vec_t b) {
+    return V::sub8(a, b);
+  }
+  static vec_t eq(const vec_t a, const vec_t b) {
+    return V::cmpeq8(a, b);
+  }
+  static vec_t gt(const vec_t a, const vec_t b) {
+    return V::cmpgt8(a, b);
+  }
+  static vec_t gtu(const vec_t a, const vec_t b) {
+    const vec_t bias = V::splat(0x80808080u);
+    return V::cmpgt8(V::xor_(a, bias), V::xor_(b, bias));
+  }
+  static vec_t adds(const vec_t a, const vec_t b) {
+    return V::adds8(a, b);
+  }
+  static vec_t addsu(const vec_t a, const vec_t b) {
+    return V::addsu8(a, b);
+  }
+  static vec_t subs(const vec_t a, const vec_t b) {
+    return V::subs8(a, b);
+  }
+  static vec_t subsu(const vec_t a, const vec_t b) {
+    return V::subsu8(a, b);
+  }
+};
+
+template <typename V>
+struct lanes_t<V, 16> : public V {
+  using vec_t = typename V::vec_t;
+  static vec_t add(const vec_t a, const vec_t b) {
+    return V::add16(a, b);
+  }
+  static vec_t sub(const vec_t a, const vec_t b) {
+    return V::sub16(a, b);
+  }
+  static vec_t eq(const vec_t a, const vec_t b) {
+    return V::cmpeq16(a, b);
+  }
+  static vec_t gt(const vec_t a, const vec_t b) {
+    return V::cmpgt16(a, b);
+  }
+  static vec_t gtu(const vec_t a, const vec_t b) {
+    const vec_t bias = V::splat(0x80008000u);
+    return V::cmpgt16(V::xor_(a, bias), V::xor_(b, bias));
+  }
+  static vec_t adds(const vec_t a, const vec_t b) {
+    return V::adds16(a, b);
+  }
+  static vec_t addsu(const vec_t a, const vec_t b) {
+    return V::addsu16(a, b);
+  }
+  static vec_t subs(const vec_t a, const vec_t b) {
+    return V::subs16(a, b);
+  }
+  static vec_t subsu(const vec_t a, const vec_t b) {
+    return V::subsu16(a, b);
+  }
+};
+
+template <typename V>
+struct lanes_t<V, 32> : public V {
+  using vec_t = typename V::vec_t;
+  static vec_t add(const vec_t a, const vec_t b) {
+    return V::add32(a, b);
+  }
+  static vec_t sub(const vec_t a, const vec_t b) {
+    return V::sub32(a, b);
+  }
+  static vec_t eq(const vec_t a, const vec_t b) {
+    return V::cmpeq32(a, b);
+  }
+  static vec_t gt(const vec_t a, const vec_t b) {
+    return V::cmpgt32(a, b);
+  }
+  static vec_t gtu(const vec_t a, const vec_t b) {
+    const vec_t bias = V::splat(0x80000000u);
+    return V::cmpgt32(V::xor_(a, bias), V::xor_(b, bias));
+  }
+};
+
+/// @brief Run a SIMD kernel over the vector elements, one host vector at a time.
+///
+/// The elements are processed in order, and all source elements of a host vector are read before
+/// any destination elements are written, so the result is the same as for the scalar ALU when the
+/// destination register is also a source register (including folding operations).
+/// @param kernel The kernel, which is called as kernel(a, b) for each host vector.
+/// @param check_nan Leave host vectors that produce NaN results to the scalar ALU (x86 NaN
+/// propagation depends on the operand order, which may differ for the scalar code).
+/// @returns the number of elements that were processed.
+template <typename V, typename K>
+inline uint32_t run_kernel(const K kernel,
+                           const bool check_nan,
+                           uint32_t* dst,
+                           const uint32_t* src_a,
+                           const uint32_t* src_b,
+                           const uint32_t scalar_b,
+                           const uint32_t count,
+                           uint32_t i) {
+  const uint32_t width = V::WIDTH;
+
+  // With a vector length greater than the register size, a folding operation may read elements
+  // that were written a few elements earlier (in the same host vector). Leave that to the scalar
+  // ALU.
+  if (src_b != nullptr && src_b < dst && dst - src_b < static_cast<ptrdiff_t>(width)) {
+    return i;
+  }
+
+  const typename V::vec_t splat_b = V::splat(scalar_b);
+  for (; i + width <= count; i += width) {
+    const auto b = (src_b != nullptr) ? V::load(&src_b[i]) : splat_b;
+    const auto result = kernel(V::load(&src_a[i]), b);
+    if (check_nan && V::any_nan(result)) {
+      break;
+    }
+    V::store(&dst[i], result);
+  }
+  return i;
+}
+
+}  // namespace simd
+#endif  // ALU_SIMD_SSE2
+
+// (EX operation, packed mode, kernel expression) for the operations that have SIMD kernels. In the
+// kernel expression, a and b are the source operands and L is the lanes_t type of the packed mode.
+// Note: The MRISC32 SUB instruction computes b - a, and FMIN/FMAX select one of the unmodified
+// operands (like std::min/std::max), so denormals are not flushed to zero.
+#define ALU_SIMD_KERNELS(X)                                  \
+  X(OR, 0, L::or_(a, b))                                     \
+  X(NOR, 0, L::not_(L::or_(a, b)))                           \
+  X(AND, 0, L::and_(a, b))                                   \
+  X(BIC, 0, L::andnot(b, a))                                 \
+  X(XOR, 0, L::xor_(a, b))                                   \
+  X(ADD, 0, L::add(a, b))                                    \
+  X(ADD, 1, L::add(a, b))                                    \
+  X(ADD, 2, L::add(a, b))                                    \
+  X(SUB, 0, L::sub(b, a))                                    \
+  X(SUB, 1, L::sub(b, a))                                    \
+  X(SUB, 2, L::sub(b, a))                                    \
+  X(SEQ, 0, L::eq(a, b))                                     \
+  X(SEQ, 1, L::eq(a, b))                                     \
+  X(SEQ, 2, L::eq(a, b))                                     \
+  X(SNE, 0, L::not_(L::eq(a, b)))                            \
+  X(SNE, 1, L::not_(L::eq(a, b)))                            \
+  X(SNE, 2, L::not_(L::eq(a, b)))                            \
+  X(SLT, 0, L::gt(b, a))                                     \
+  X(SLT, 1, L::gt(b, a))                                     \
+  X(SLT, 2, L::gt(b, a))                                     \
+  X(SLTU, 0, L::gtu(b, a))                                   \
+  X(SLTU, 1, L::gtu(b, a))                                   \
+  X(SLTU, 2, L::gtu(b, a))                                   \
+  X(SLE, 0, L::not_(L::gt(a, b)))                            \
+  X(SLE, 1, L::not_(L::gt(a, b)))                            \
+  X(SLE, 2, L::not_(L::gt(a, b)))                            \
+  X(SLEU, 0, L::not_(L::gtu(a, b)))                          \
+  X(SLEU, 1, L::not_(L::gtu(a, b)))                          \
+  X(SLEU, 2, L::not_(L::gtu(a, b)))                          \
+  X(MIN, 0, L::sel(a, b, L::gt(b, a)))                       \
+  X(MIN, 1, L::sel(a, b, L::gt(b, a)))                       \
+  X(MIN, 2, L::sel(a, b, L::gt(b, a)))                       \
+  X(MAX, 0, L::sel(a, b, L::gt(a, b)))                       \
+  X(MAX, 1, L::sel(a, b, L::gt(a, b)))                       \
+  X(MAX, 2, L::sel(a, b, L::gt(a, b)))                       \
+  X(MINU, 0, L::sel(a, b, L::gtu(b, a)))                     \
+  X(MINU, 1, L::sel(a, b, L::gtu(b, a)))                     \
+  X(MINU, 2, L::sel(a, b, L::gtu(b, a)))                     \
+  X(MAXU, 0, L::sel(a, b, L::gtu(a, b)))                     \
+  X(MAXU, 1, L::sel(a, b, L::gtu(a, b)))                     \
+  X(MAXU, 2, L::sel(a, b, L::gtu(a, b)))                     \
+  X(ADDS, 1, L::adds(a, b))                                  \
+  X(ADDS, 2, L::adds(a, b))                                  \
+  X(ADDSU, 1, L::addsu(a, b))                                \
+  X(ADDSU, 2, L::addsu(a, b))                                \
+  X(SUBS, 1, L::subs(a, b))                                  \
+  X(SUBS, 2, L::subs(a, b))                                  \
+  X(SUBSU, 1, L::subsu(a, b))                                \
+  X(SUBSU, 2, L::subsu(a, b))                                \
+  X(MULQ, 2, L::mulq16(a, b))                                \
+  X(MUL, 0, L::mul32(a, b))                                  \
+  X(MUL, 2, L::mul16(a, b))                                  \
+  X(MULHI, 2, L::mulhi16(a, b))                              \
+  X(MULHIU, 2, L::mulhiu16(a, b))                            \
+  X(FADD, 0, L::fadd(a, b))                                  \
+  X(FSUB, 0, L::fsub(a, b))                                  \
+  X(FMUL, 0, L::fmul(a, b))                                  \
+  X(FDIV, 0, L::fdiv(a, b))                                  \
+  X(FMIN, 0, L::sel(b, a, L::fcmplt(b, a)))                  \
+  X(FMAX, 0, L::sel(b, a, L::fcmplt(a, b)))                  \
+  ALU_SIMD_SHIFT_KERNELS(X)
+
+#ifdef ALU_SIMD_AVX2
+#define ALU_SIMD_SHIFT_KERNELS(X) \
+  X(ASR, 0, L::sra32(a, b))       \
+  X(LSL, 0, L::sll32(a, b))       \
+  X(LSR, 0, L::srl32(a, b))
+#else
+#define ALU_SIMD_SHIFT_KERNELS(X)
+#endif
+
+#ifdef ALU_SIMD_SSE2
+template <typename V>
+inline uint32_t cpu_t::execute_alu_simd(const uint32_t ex_op,
+                                        const uint32_t packed_mode,
+                                        uint32_t* dst,
+                                        const uint32_t* src_a,
+                                        const uint32_t* src_b,
+                                        const uint32_t scalar_b,
+                                        const uint32_t count,
+                                        const uint32_t start) {
+  using vec_t = typename V::vec_t;
+  const bool check_nan = (ex_op == EX_OP_FADD) || (ex_op == EX_OP_FSUB) ||
+                         (ex_op == EX_OP_FMUL) || (ex_op == EX_OP_FDIV);
+
+#define ALU_SIMD_CASE(op, pm, expr)                                                             \
+  case (EX_OP_##op << 2u) | pm: {                                                               \
+    using L = simd::lanes_t<V, (pm == PACKED_BYTE) ? 8 : ((pm == PACKED_HALF_WORD) ? 16 : 32)>; \
+    return simd::run_kernel<V>([](const vec_t a, const vec_t b) { return expr; },               \
+                               check_nan,                                                       \
+                               dst,                                                             \
+                               src_a,                                                           \
+                               src_b,                                                           \
+                               scalar_b,                                                        \
+                               count,                                                           \
+                               start);                                                          \
+  }
+
+  switch ((ex_op << 2u) | packed_mode) {
+    ALU_SIMD_KERNELS(ALU_SIMD_CASE)
+    default:
+      return start;
+  }
+
+#undef ALU_SIMD_CASE
+}
+#endif  // ALU_SIMD_SSE2
+
+inline uint32_t cpu_t::execute_alu_simd(const uint32_t ex_op,
+                                        const uint32_t packed_mode,
+                                        uint32_t* dst,
+                                        const uint32_t* src_a,
+                                        const uint32_t* src_b,
+                                        const uint32_t scalar_b,
+                                        const uint32_t count) {
+  uint32_t done = 0u;
+#ifdef ALU_SIMD_AVX2
+  done = execute_alu_simd<simd::v256_t>(
+      ex_op, packed_mode, dst, src_a, src_b, scalar_b, count, done);
+#endif
+#ifdef ALU_SIMD_SSE2
+  done = execute_alu_simd<simd::v128_t>(
+      ex_op, packed_mode, dst, src_a, src_b, scalar_b, count, done);
+#else
+  (void)ex_op;
+  (void)packed_mode;
+  (void)dst;
+  (void)src_a;
+  (void)src_b;
+  (void)scalar_b;
+  (void)count;
+#endif
+  return done;
+}
+
+#endif  // SIM_ALU_SIMD_HPP_
@@ -0,0 +1,244 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#include "branch_predictor.hpp"
+
+#include "hex_string.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+namespace {
+// Predictor table sizes.
+const uint32_t LOG2_BIMODAL_ENTRIES = 12u;
+const uint32_t LOG2_GSHARE_ENTRIES = 12u;
+
+const size_t NUM_REPORTED_BRANCHES = 10u;
+const size_t NUM_JSON_BRANCHES = 100u;
+
+// 2-bit saturating counters: 0-1 = not taken, 2-3 = taken. They start as weakly not taken.
+const uint8_t COUNTER_INIT = 1u;
+
+uint8_t update_counter(const uint8_t counter, const bool taken) {
+  if (taken) {
+    return counter < 3u ? counter + 1u : counter;
+  }
+  return counter > 0u ? counter - 1u : counter;
+}
+
+double percent(const uint64_t part, const uint64_t total) {
+  return total > 0u ? (100.0 * static_cast<double>(part)) / static_cast<double>(total) : 0.0;
+}
+}  // namespace
+
+bimodal_predictor_t::bimodal_predictor_t(const uint32_t log2_entries)
+    : m_mask((1u << log2_entries) - 1u), m_counters(1u << log2_entries) {
+  reset();
+}
+
+bool bimodal_predictor_t::predict(const uint32_t pc, const uint32_t) const {
+  return m_counters[index(pc)] >= 2u;
+}
+
+void bimodal_predictor_t::update(const uint32_t pc, const bool taken) {
+  auto& counter = m_counters[index(pc)];
+  counter = update_counter(counter, taken);
+}
+
+void bimodal_predictor_t::reset() {
+  std::fill(m_counters.begin(), m_counters.end(), COUNTER_INIT);
+}
+
+gshare_predictor_t::gshare_predictor_t(const uint32_t log2_entries)
+    : m_mask((1u << log2_entries) - 1u), m_counters(1u << log2_entries) {
+  reset();
+}
+
+bool gshare_predictor_t::predict(const uint32_t pc, const uint32_t) const {
+  return m_counters[index(pc)] >= 2u;
+}
+
+void gshare_predictor_t::update(const uint32_t pc, const bool taken) {
+  auto& counter = m_counters[index(pc)];
+  counter = update_counter(counter, taken);
+  m_history = ((m_history << 1u) | (taken ? 1u : 0u)) & m_mask;
+}
+
+void gshare_predictor_t::reset() {
+  m_history = 0u;
+  std::fill(m_counters.begin(), m_counters.end(), COUNTER_INIT);
+}
+
+branch_stats_t::branch_stats_t() {
+  m_predictors[0].reset(new btfn_predictor_t());
+  m_predictors[1].reset(new bimodal_predictor_t(LOG2_BIMODAL_ENTRIES));
+  m_predictors[2].reset(new gshare_predictor_t(LOG2_GSHARE_ENTRIES));
+  reset();
+}
+
+void branch_stats_t::reset() {
+  for (auto& predictor : m_predictors) {
+    predictor->reset();
+  }
+  m_mispredictions.fill(0u);
+  m_branches = 0u;
+  m_pc_stats.clear();
+  m_ras.fill(0u);
+  m_ras_top = 0u;
+  m_ras_count = 0u;
+  m_returns = 0u;
+  m_ras_mispredictions = 0u;
+}
+
+void branch_stats_t::branch(const uint32_t pc, const uint32_t target, const bool taken) {
+  auto& stats = m_pc_stats[pc];
+  ++stats.executed;
+  if (taken) {
+    ++stats.taken;
+  }
+  for (size_t k = 0u; k < NUM_PREDICTORS; ++k) {
+    auto& predictor = *m_predictors[k];
+    if (predictor.predict(pc, target) != taken) {
+      ++m_mispredictions[k];
+      ++stats.mispredictions[k];
+    }
+    predictor.update(pc, taken);
+  }
+  ++m_branches;
+}
+
+void branch_stats_t::call(const uint32_t return_addr) {
+  m_ras_top = (m_ras_top + 1u) % RAS_DEPTH;
+  m_ras[m_ras_top] = return_addr;
+  if (m_ras_count < RAS_DEPTH) {
+    ++m_ras_count;
+  }
+}
+
+void branch_stats_t::ret(const uint32_t target) {
+  ++m_returns;
+  if (m_ras_count == 0u || m_ras[m_ras_top] != target) {
+    ++m_ras_mispredictions;
+  }
+  discard_call();
+}
+
+void branch_stats_t::discard_call() {
+  if (m_ras_count > 0u) {
+    m_ras_top = (m_ras_top + RAS_DEPTH - 1u) % RAS_DEPTH;
+    --m_ras_count;
+  }
+}
+
+std::vector<branch_stats_t::pc_entry_t> branch_stats_t::worst_branches(const size_t count) const {
+  // Rank the branches by their total number of mispredictions (over all predictors).
+  const auto total = [](const pc_stats_t& s) {
+    uint64_t sum = 0u;
+    for (const auto x : s.mispredictions) {
+      sum += x;
+    }
+    return sum;
+  };
+  std::vector<pc_entry_t> branches(m_pc_stats.begin(), m_pc_stats.end());
+  const size_t num = std::min(branches.size(), count);
+  std::partial_sort(branches.begin(),
+                    branches.begin() + static_cast<std::ptrdiff_t>(num),
+                    branches.end(),
+                    [&total](const pc_entry_t& a, const pc_entry_t& b) {
+                      const auto total_a = total(a.second);
+                      const auto total_b = total(b.second);
+                      return total_a > total_b || (total_a == total_b && a.first < b.first);
+                    });
+  branches.resize(num);
+  return branches;
+}
+
+void branch_stats_t::dump_stats() const {
+  char line[128];
+  std::cout << "Branch prediction:\n";
+  std::cout << " Conditional branches: " << m_branches << "\n";
+  for (size_t k = 0u; k < NUM_PREDICTORS; ++k) {
+    std::snprintf(line,
+                  sizeof(line),
+                  "  %-20s%llu mispredicted (%.2f%% accuracy)\n",
+                  m_predictors[k]->name(),
+                  static_cast<unsigned long long>(m_mispredictions[k]),
+                  100.0 - percent(m_mispredictions[k], m_branches));
+    std::cout << line;
+  }
+  std::cout << " Returns:              " << m_returns << "\n";
+  std::snprintf(line,
+                sizeof(line),
+                "  %-20s%llu mispredicted (%.2f%% accuracy)\n",
+                "ras",
+                static_cast<unsigned long long>(m_ras_mispredictions),
+                100.0 - percent(m_ras_mispredictions, m_returns));
+  std::cout << line;
+
+  const auto branches = worst_branches(NUM_REPORTED_BRANCHES);
+  if (!branches.empty()) {
+    std::cout << " Most mispredicted branches:\n";
+    std::snprintf(line,
+                  sizeof(line),
+                  "  %-10s %12s %7s %12s %12s %12s\n",
+                  "PC",
+                  "Executed",
+                  "Taken",
+                  m_predictors[0]->name(),
+                  m_predictors[1]->name(),
+                  m_predictors[2]->name());
+    std::cout << line;
+    for (const auto& b : branches) {
+      std::snprintf(line,
+                    sizeof(line),
+                    "  %-10s %12llu %6.1f%% %12llu %12llu %12llu\n",
+                    as_hex32(b.first).c_str(),
+                    static_cast<unsigned long long>(b.second.executed),
+                    percent(b.second.taken, b.second.executed),
+                    static_cast<unsigned long long>(b.second.mispredictions[0]),
+                    static_cast<unsigned long long>(b.second.mispredictions[1]),
+                    static_cast<unsigned long long>(b.second.mispredictions[2]));
+      std::cout << line;
+    }
+  }
+}
+
+void branch_stats_t::write_stats(json_writer_t& json) const {
+  json.value("branches", m_branches);
+  json.begin_object("mispredictions");
+  for (size_t k = 0u; k < NUM_PREDICTORS; ++k) {
+    json.value(m_predictors[k]->name(), m_mispredictions[k]);
+  }
+  json.end_object();
+  json.value("returns", m_returns);
+  json.value("ras_mispredictions", m_ras_mispredictions);
+  json.begin_object("worst_branches");
+  for (const auto& b : worst_branches(NUM_JSON_BRANCHES)) {
+    json.begin_object(as_hex32(b.first).c_str());
+    json.value("executed", b.second.executed);
+    json.value("taken", b.second.taken);
+    for (size_t k = 0u; k < NUM_PREDICTORS; ++k) {
+      json.value(m_predictors[k]->name(), b.second.mispredictions[k]);
+    }
+    json.end_object();
+  }
+  json.end_object();
+}
@@ -0,0 +1,176 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef SIM_BRANCH_PREDICTOR_HPP_
+#define SIM_BRANCH_PREDICTOR_HPP_
+
+#include "json_writer.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/// @brief Interface for conditional branch direction predictors.
+class branch_predictor_t {
+public:
+  virtual ~branch_predictor_t() {
+  }
+
+  /// @brief Get the name of the predictor.
+  virtual const char* name() const = 0;
+
+  /// @brief Predict the direction of a conditional branch.
+  /// @param pc The address of the branch instruction.
+  /// @param target The branch target address.
+  /// @returns true if the branch is predicted to be taken.
+  virtual bool predict(const uint32_t pc, const uint32_t target) const = 0;
+
+  /// @brief Update the predictor state with the outcome of a branch.
+  /// @param pc The address of the branch instruction.
+  /// @param taken True if the branch was taken.
+  virtual void update(const uint32_t pc, const bool taken) = 0;
+
+  /// @brief Clear the predictor state.
+  virtual void reset() = 0;
+};
+
+/// @brief Static prediction: backward branches are taken, forward branches are not taken.
+class btfn_predictor_t : public branch_predictor_t {
+public:
+  const char* name() const override {
+    return "btfn";
+  }
+  bool predict(const uint32_t pc, const uint32_t target) const override {
+    return target <= pc;
+  }
+  void update(const uint32_t, const bool) override {
+  }
+  void reset() override {
+  }
+};
+
+/// @brief A table of 2-bit saturating counters, indexed by the PC.
+class bimodal_predictor_t : public branch_predictor_t {
+public:
+  explicit bimodal_predictor_t(const uint32_t log2_entries);
+  const char* name() const override {
+    return "bimodal";
+  }
+  bool predict(const uint32_t pc, const uint32_t target) const override;
+  void update(const uint32_t pc, const bool taken) override;
+  void reset() override;
+
+private:
+  uint32_t index(const uint32_t pc) const {
+    return (pc >> 2u) & m_mask;
+  }
+
+  const uint32_t m_mask;
+  std::vector<uint8_t> m_counters;
+};
+
+/// @brief A table of 2-bit saturating counters, indexed by the PC XOR:ed with the global branch
+/// history.
+class gshare_predictor_t : public branch_predictor_t {
+public:
+  explicit gshare_predictor_t(const uint32_t log2_entries);
+  const char* name() const override {
+    return "gshare";
+  }
+  bool predict(const uint32_t pc, const uint32_t target) const override;
+  void update(const uint32_t pc, const bool taken) override;
+  void reset() override;
+
+private:
+  uint32_t index(const uint32_t pc) const {
+    return ((pc >> 2u) ^ m_history) & m_mask;
+  }
+
+  const uint32_t m_mask;
+  uint32_t m_history;
+  std::vector<uint8_t> m_counters;
+};
+
+/// @brief Evaluates several branch predictors (and a return address stack) side by side.
+///
+/// All predictors see the same branch stream, so their accuracies are directly comparable. The
+/// number of mispredictions is also recorded per branch instruction, to find the branches that
+/// are hardest to predict.
+class branch_stats_t {
+public:
+  branch_stats_t();
+
+  /// @brief Clear all predictor state and statistics.
+  void reset();
+
+  /// @brief Record a resolved conditional branch.
+  /// @param pc The address of the branch instruction.
+  /// @param target The branch target address.
+  /// @param taken True if the branch was taken.
+  void branch(const uint32_t pc, const uint32_t target, const bool taken);
+
+  /// @brief Record a subroutine call (pushes the return address to the return address stack).
+  void call(const uint32_t return_addr);
+
+  /// @brief Record a subroutine return (j lr), which is predicted by the return address stack.
+  /// @param target The actual return address.
+  void ret(const uint32_t target);
+
+  /// @brief Drop the latest return address without recording a prediction.
+  ///
+  /// This is used when the simulator returns from a simulator routine.
+  void discard_call();
+
+  /// @brief Print the predictor statistics.
+  void dump_stats() const;
+
+  /// @brief Write the predictor statistics as JSON object members.
+  void write_stats(json_writer_t& json) const;
+
+private:
+  static const size_t NUM_PREDICTORS = 3u;
+  static const uint32_t RAS_DEPTH = 16u;
+
+  struct pc_stats_t {
+    uint64_t executed;
+    uint64_t taken;
+    std::array<uint64_t, NUM_PREDICTORS> mispredictions;
+  };
+
+  using pc_entry_t = std::pair<uint32_t, pc_stats_t>;
+  std::vector<pc_entry_t> worst_branches(const size_t count) const;
+
+  std::array<std::unique_ptr<branch_predictor_t>, NUM_PREDICTORS> m_predictors;
+  std::array<uint64_t, NUM_PREDICTORS> m_mispredictions;
+  uint64_t m_branches;
+  std::unordered_map<uint32_t, pc_stats_t> m_pc_stats;
+
+  // Return address stack (a circular buffer, so the oldest entries are overwritten on overflow).
+  std::array<uint32_t, RAS_DEPTH> m_ras;
+  uint32_t m_ras_top;
+  uint32_t m_ras_count;
+  uint64_t m_returns;
+  uint64_t m_ras_mispredictions;
+};
+
+#endif  // SIM_BRANCH_PREDICTOR_HPP_
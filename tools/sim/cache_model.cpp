@@ -0,0 +1,253 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#include "cache_model.hpp"
+
+#include "hex_string.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+const size_t NUM_REPORTED_REGIONS = 10u;
+const size_t NUM_JSON_REGIONS = 100u;
+
+bool is_pow2(const uint32_t x) {
+  return x != 0u && (x & (x - 1u)) == 0u;
+}
+
+uint32_t log2_of(uint32_t x) {
+  uint32_t result = 0u;
+  while (x > 1u) {
+    x >>= 1u;
+    ++result;
+  }
+  return result;
+}
+
+const char* policy_name(const cache_params_t::policy_t policy) {
+  switch (policy) {
+    case cache_params_t::policy_t::FIFO:
+      return "fifo";
+    case cache_params_t::policy_t::RANDOM:
+      return "random";
+    default:
+      return "lru";
+  }
+}
+}  // namespace
+
+cache_params_t cache_params_t::parse(const std::string& spec) {
+  // Split the string into colon separated fields.
+  std::vector<std::string> fields;
+  size_t start = 0u;
+  while (true) {
+    const auto pos = spec.find(':', start);
+    fields.push_back(spec.substr(start, pos - start));
+    if (pos == std::string::npos) {
+      break;
+    }
+    start = pos + 1u;
+  }
+  if (fields.size() < 3u || fields.size() > 4u) {
+    throw std::runtime_error("Invalid cache specification (expected SIZE:WAYS:LINE[:POLICY]): " +
+                             spec);
+  }
+
+  cache_params_t params;
+  try {
+    params.size = static_cast<uint32_t>(std::stoul(fields[0], nullptr, 0));
+    params.ways = static_cast<uint32_t>(std::stoul(fields[1], nullptr, 0));
+    params.line_size = static_cast<uint32_t>(std::stoul(fields[2], nullptr, 0));
+  } catch (std::exception&) {
+    throw std::runtime_error("Invalid cache specification: " + spec);
+  }
+  if (fields.size() > 3u) {
+    if (fields[3] == "lru") {
+      params.policy = policy_t::LRU;
+    } else if (fields[3] == "fifo") {
+      params.policy = policy_t::FIFO;
+    } else if (fields[3] == "random") {
+      params.policy = policy_t::RANDOM;
+    } else {
+      throw std::runtime_error("Invalid cache replacement policy: " + fields[3]);
+    }
+  }
+
+  if (!is_pow2(params.size) || !is_pow2(params.ways) || !is_pow2(params.line_size) ||
+      params.line_size < 4u || params.size < params.ways * params.line_size) {
+    throw std::runtime_error("Invalid cache geometry (sizes must be powers of two): " + spec);
+  }
+  return params;
+}
+
+cache_model_t::cache_model_t(const std::string& name, const cache_params_t& params)
+    : m_name(name),
+      m_params(params),
+      m_log2_line_size(log2_of(params.line_size)),
+      m_num_sets(params.size / (params.ways * params.line_size)),
+      m_tags(params.size / params.line_size),
+      m_stamps(m_tags.size()),
+      m_dirty(m_tags.size()) {
+  reset();
+}
+
+void cache_model_t::reset() {
+  std::fill(m_tags.begin(), m_tags.end(), 0u);
+  std::fill(m_stamps.begin(), m_stamps.end(), 0u);
+  std::fill(m_dirty.begin(), m_dirty.end(), false);
+  m_time = 0u;
+  m_random_state = 0x12345678u;
+  m_read_hits = 0u;
+  m_read_misses = 0u;
+  m_write_hits = 0u;
+  m_write_misses = 0u;
+  m_writebacks = 0u;
+  m_regions.clear();
+}
+
+bool cache_model_t::access(const uint32_t addr, const bool is_write, const uint32_t pc) {
+  const uint32_t line_addr = addr >> m_log2_line_size;
+  const uint32_t first = (line_addr & (m_num_sets - 1u)) * m_params.ways;
+  const uint32_t last = first + m_params.ways;
+  ++m_time;
+
+  auto& region = m_regions[pc >> LOG2_REGION_SIZE];
+  ++region.accesses;
+
+  // Look for the line in the set.
+  for (uint32_t k = first; k < last; ++k) {
+    if (m_stamps[k] != 0u && m_tags[k] == line_addr) {
+      if (m_params.policy == cache_params_t::policy_t::LRU) {
+        m_stamps[k] = m_time;
+      }
+      if (is_write) {
+        m_dirty[k] = true;
+        ++m_write_hits;
+      } else {
+        ++m_read_hits;
+      }
+      return true;
+    }
+  }
+
+  // Miss: Select a victim (an invalid line if there is one).
+  uint32_t victim = first;
+  if (m_params.policy == cache_params_t::policy_t::RANDOM) {
+    m_random_state ^= m_random_state << 13u;
+    m_random_state ^= m_random_state >> 17u;
+    m_random_state ^= m_random_state << 5u;
+    victim = first + (m_random_state & (m_params.ways - 1u));
+  }
+  for (uint32_t k = first; k < last; ++k) {
+    if (m_stamps[k] == 0u) {
+      victim = k;
+      break;
+    }
+    if (m_params.policy != cache_params_t::policy_t::RANDOM && m_stamps[k] < m_stamps[victim]) {
+      victim = k;
+    }
+  }
+
+  // Evict the old line and fill the new line.
+  if (m_stamps[victim] != 0u && m_dirty[victim]) {
+    ++m_writebacks;
+  }
+  m_tags[victim] = line_addr;
+  m_stamps[victim] = m_time;
+  m_dirty[victim] = is_write;
+
+  ++(is_write ? m_write_misses : m_read_misses);
+  ++region.misses;
+  return false;
+}
+
+std::vector<std::pair<uint32_t, cache_model_t::region_stats_t>> cache_model_t::worst_regions(
+    const size_t count) const {
+  std::vector<std::pair<uint32_t, region_stats_t>> regions;
+  for (const auto& r : m_regions) {
+    if (r.second.misses > 0u) {
+      regions.emplace_back(r.first << LOG2_REGION_SIZE, r.second);
+    }
+  }
+  const size_t num = std::min(regions.size(), count);
+  std::partial_sort(regions.begin(),
+                    regions.begin() + static_cast<std::ptrdiff_t>(num),
+                    regions.end(),
+                    [](const std::pair<uint32_t, region_stats_t>& a,
+                       const std::pair<uint32_t, region_stats_t>& b) {
+                      return a.second.misses > b.second.misses ||
+                             (a.second.misses == b.second.misses && a.first < b.first);
+                    });
+  regions.resize(num);
+  return regions;
+}
+
+void cache_model_t::dump_stats() const {
+  const uint64_t accesses = m_read_hits + m_read_misses + m_write_hits + m_write_misses;
+  const double miss_ratio =
+      static_cast<double>(misses()) / static_cast<double>(std::max<uint64_t>(accesses, 1u));
+  std::cout << m_name << " (" << m_params.size << " bytes, " << m_params.ways << "-way, "
+            << m_params.line_size << " byte lines, " << policy_name(m_params.policy) << "):\n";
+  std::cout << " Reads:                " << (m_read_hits + m_read_misses) << " (" << m_read_misses
+            << " misses)\n";
+  std::cout << " Writes:               " << (m_write_hits + m_write_misses) << " ("
+            << m_write_misses << " misses)\n";
+  std::cout << " Miss ratio:           " << (100.0 * miss_ratio) << "%\n";
+  std::cout << " Write-backs:          " << m_writebacks << "\n";
+
+  const auto regions = worst_regions(NUM_REPORTED_REGIONS);
+  if (!regions.empty()) {
+    std::cout << " Most misses (by PC, " << REGION_SIZE << " byte regions):\n";
+    for (const auto& r : regions) {
+      char line[128];
+      std::snprintf(line,
+                    sizeof(line),
+                    "  %s: %llu misses (%llu accesses)\n",
+                    as_hex32(r.first).c_str(),
+                    static_cast<unsigned long long>(r.second.misses),
+                    static_cast<unsigned long long>(r.second.accesses));
+      std::cout << line;
+    }
+  }
+}
+
+void cache_model_t::write_stats(json_writer_t& json) const {
+  json.value("size", m_params.size);
+  json.value("ways", m_params.ways);
+  json.value("line_size", m_params.line_size);
+  json.value("policy", policy_name(m_params.policy));
+  json.value("read_hits", m_read_hits);
+  json.value("read_misses", m_read_misses);
+  json.value("write_hits", m_write_hits);
+  json.value("write_misses", m_write_misses);
+  json.value("writebacks", m_writebacks);
+  json.value("region_size", REGION_SIZE);
+  json.begin_object("regions");
+  for (const auto& r : worst_regions(NUM_JSON_REGIONS)) {
+    json.begin_object(as_hex32(r.first).c_str());
+    json.value("accesses", r.second.accesses);
+    json.value("misses", r.second.misses);
+    json.end_object();
+  }
+  json.end_object();
+}
@@ -0,0 +1,112 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef SIM_CACHE_MODEL_HPP_
+#define SIM_CACHE_MODEL_HPP_
+
+#include "json_writer.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// @brief Cache configuration.
+struct cache_params_t {
+  enum class policy_t { LRU, FIFO, RANDOM };
+
+  uint32_t size = 8192u;      // Total size in bytes.
+  uint32_t ways = 2u;         // Associativity.
+  uint32_t line_size = 32u;   // Line size in bytes.
+  policy_t policy = policy_t::LRU;
+
+  /// @brief Parse a cache specification.
+  ///
+  /// The format is SIZE:WAYS:LINE[:POLICY], where POLICY is one of lru, fifo or random, e.g.
+  /// "8192:2:32:lru". All sizes must be powers of two.
+  /// @param spec The cache specification string.
+  /// @throws std::runtime_error if the specification is invalid.
+  static cache_params_t parse(const std::string& spec);
+};
+
+/// @brief A set associative cache model.
+///
+/// Only tags are modelled (no data). Writes use a write-back, write-allocate policy. Hits and
+/// misses are also counted per PC region (the address of the instruction that made the access,
+/// in blocks of REGION_SIZE bytes), to help find code that thrashes the cache.
+class cache_model_t {
+public:
+  static const uint32_t LOG2_REGION_SIZE = 8u;
+  static const uint32_t REGION_SIZE = 1u << LOG2_REGION_SIZE;
+
+  /// @brief Constructor for cache_model_t.
+  /// @param name The name of the cache (used in reports).
+  /// @param params The cache configuration.
+  cache_model_t(const std::string& name, const cache_params_t& params);
+
+  /// @brief Clear the cache contents and statistics.
+  void reset();
+
+  /// @brief Access the cache.
+  /// @param addr The memory address.
+  /// @param is_write True for a write access.
+  /// @param pc The address of the instruction that makes the access.
+  /// @returns true if the access was a hit.
+  bool access(const uint32_t addr, const bool is_write, const uint32_t pc);
+
+  uint64_t misses() const {
+    return m_read_misses + m_write_misses;
+  }
+
+  /// @brief Print the cache statistics (including the PC regions with the most misses).
+  void dump_stats() const;
+
+  /// @brief Write the cache statistics as JSON object members.
+  void write_stats(json_writer_t& json) const;
+
+private:
+  struct region_stats_t {
+    uint64_t accesses;
+    uint64_t misses;
+  };
+
+  std::vector<std::pair<uint32_t, region_stats_t>> worst_regions(const size_t count) const;
+
+  const std::string m_name;
+  const cache_params_t m_params;
+  uint32_t m_log2_line_size;
+  uint32_t m_num_sets;
+
+  // Per line state (indexed by set * ways + way).
+  std::vector<uint32_t> m_tags;
+  std::vector<uint64_t> m_stamps;  // Last use (LRU) or fill (FIFO) time, 0 = invalid.
+  std::vector<bool> m_dirty;
+  uint64_t m_time;
+  uint32_t m_random_state;
+
+  // Statistics.
+  uint64_t m_read_hits;
+  uint64_t m_read_misses;
+  uint64_t m_write_hits;
+  uint64_t m_write_misses;
+  uint64_t m_writebacks;
+  std::unordered_map<uint32_t, region_stats_t> m_regions;
+};
+
+#endif  // SIM_CACHE_MODEL_HPP_
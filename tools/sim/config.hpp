@@ -25,6 +25,9 @@
 
 class config_t {
 public:
+  enum class cpu_type_t { SIMPLE, FAST, JIT, REC };
+  enum class trace_format_t { RAW, COMPRESSED };
+
   static config_t& instance();
 
   uint64_t ram_size() const {
@@ -35,6 +38,14 @@ public:
     m_ram_size = std::min(x, 4294967296u);
   }
 
+  bool unchecked_ram() const {
+    return m_unchecked_ram;
+  }
+
+  void set_unchecked_ram(const bool x) {
+    m_unchecked_ram = x;
+  }
+
   bool trace_enabled() const {
     return m_trace_enabled;
   }
@@ -51,6 +62,181 @@ public:
     m_trace_file_name = x;
   }
 
+  trace_format_t trace_format() const {
+    return m_trace_format;
+  }
+
+  void set_trace_format(const trace_format_t x) {
+    m_trace_format = x;
+  }
+
+  uint32_t trace_pc_first() const {
+    return m_trace_pc_first;
+  }
+
+  uint32_t trace_pc_last() const {
+    return m_trace_pc_last;
+  }
+
+  void set_trace_pc_range(const uint32_t first, const uint32_t last) {
+    m_trace_pc_first = first;
+    m_trace_pc_last = last;
+  }
+
+  uint64_t trace_cycle_begin() const {
+    return m_trace_cycle_begin;
+  }
+
+  uint64_t trace_cycle_end() const {
+    return m_trace_cycle_end;
+  }
+
+  void set_trace_cycle_window(const uint64_t begin, const uint64_t end) {
+    m_trace_cycle_begin = begin;
+    m_trace_cycle_end = end;
+  }
+
+  bool trace_trigger_enabled() const {
+    return m_trace_trigger_enabled;
+  }
+
+  uint32_t trace_trigger_pc() const {
+    return m_trace_trigger_pc;
+  }
+
+  void set_trace_trigger_pc(const uint32_t x) {
+    m_trace_trigger_pc = x;
+    m_trace_trigger_enabled = true;
+  }
+
+  uint32_t trace_sample_rate() const {
+    return m_trace_sample_rate;
+  }
+
+  void set_trace_sample_rate(const uint32_t x) {
+    m_trace_sample_rate = x;
+  }
+
+  bool profile_enabled() const {
+    return m_profile_enabled;
+  }
+
+  void set_profile_enabled(const bool x) {
+    m_profile_enabled = x;
+  }
+
+  const std::string& profile_file_name() const {
+    return m_profile_file_name;
+  }
+
+  void set_profile_file_name(const std::string& x) {
+    m_profile_file_name = x;
+  }
+
+  bool instr_mix_enabled() const {
+    return m_instr_mix_enabled;
+  }
+
+  void set_instr_mix_enabled(const bool x) {
+    m_instr_mix_enabled = x;
+  }
+
+  const std::string& instr_mix_file_name() const {
+    return m_instr_mix_file_name;
+  }
+
+  void set_instr_mix_file_name(const std::string& x) {
+    m_instr_mix_file_name = x;
+  }
+
+  bool timing_enabled() const {
+    return m_timing_enabled;
+  }
+
+  void set_timing_enabled(const bool x) {
+    m_timing_enabled = x;
+  }
+
+  const std::string& timing_params_file_name() const {
+    return m_timing_params_file_name;
+  }
+
+  void set_timing_params_file_name(const std::string& x) {
+    m_timing_params_file_name = x;
+  }
+
+  const std::string& icache_spec() const {
+    return m_icache_spec;
+  }
+
+  void set_icache_spec(const std::string& x) {
+    m_icache_spec = x;
+  }
+
+  const std::string& dcache_spec() const {
+    return m_dcache_spec;
+  }
+
+  void set_dcache_spec(const std::string& x) {
+    m_dcache_spec = x;
+  }
+
+  bool branch_stats_enabled() const {
+    return m_branch_stats_enabled;
+  }
+
+  void set_branch_stats_enabled(const bool x) {
+    m_branch_stats_enabled = x;
+  }
+
+  bool stats_json_enabled() const {
+    return m_stats_json_enabled;
+  }
+
+  void set_stats_json_enabled(const bool x) {
+    m_stats_json_enabled = x;
+  }
+
+  const std::string& stats_json_file_name() const {
+    return m_stats_json_file_name;
+  }
+
+  void set_stats_json_file_name(const std::string& x) {
+    m_stats_json_file_name = x;
+  }
+
+  const std::string& profile_stacks_file_name() const {
+    return m_profile_stacks_file_name;
+  }
+
+  void set_profile_stacks_file_name(const std::string& x) {
+    m_profile_stacks_file_name = x;
+  }
+
+  cpu_type_t cpu_type() const {
+    return m_cpu_type;
+  }
+
+  void set_cpu_type(const cpu_type_t x) {
+    m_cpu_type = x;
+  }
+
+  uint32_t num_harts() const {
+    return m_num_harts;
+  }
+
+  void set_num_harts(const uint32_t x) {
+    m_num_harts = std::max(x, 1u);
+  }
+
+  bool virtual_time() const {
+    return m_virtual_time;
+  }
+
+  void set_virtual_time(const bool x) {
+    m_virtual_time = x;
+  }
+
   bool verbose() const {
     return m_verbose;
   }
@@ -103,7 +289,22 @@ private:
 
   // Default values.
   static const uint64_t DEFAULT_RAM_SIZE = 0x100000000u;  // 4 GiB
+  static const bool DEFAULT_UNCHECKED_RAM = false;
   static const bool DEFAULT_TRACE_ENABLED = false;
+  static const trace_format_t DEFAULT_TRACE_FORMAT = trace_format_t::RAW;
+  static const uint32_t DEFAULT_TRACE_PC_FIRST = 0u;
+  static const uint32_t DEFAULT_TRACE_PC_LAST = 0xffffffffu;
+  static const uint64_t DEFAULT_TRACE_CYCLE_BEGIN = 0u;
+  static const uint64_t DEFAULT_TRACE_CYCLE_END = UINT64_MAX;
+  static const uint32_t DEFAULT_TRACE_SAMPLE_RATE = 1u;
+  static const bool DEFAULT_PROFILE_ENABLED = false;
+  static const bool DEFAULT_INSTR_MIX_ENABLED = false;
+  static const bool DEFAULT_STATS_JSON_ENABLED = false;
+  static const bool DEFAULT_TIMING_ENABLED = false;
+  static const bool DEFAULT_BRANCH_STATS_ENABLED = false;
+  static const cpu_type_t DEFAULT_CPU_TYPE = cpu_type_t::SIMPLE;
+  static const uint32_t DEFAULT_NUM_HARTS = 1u;
+  static const bool DEFAULT_VIRTUAL_TIME = false;
   static const bool DEFAULT_VERBOSE = false;
   static const bool DEFAULT_GFX_ENABLED = false;
   static const uint32_t DEFAULT_GFX_ADDR = 0x4003d480u;  // Start of MC1 VCON framebuffer.
@@ -112,8 +313,32 @@ private:
   static const uint32_t DEFAULT_GFX_DEPTH = 1u;
 
   uint64_t m_ram_size = DEFAULT_RAM_SIZE;
+  bool m_unchecked_ram = DEFAULT_UNCHECKED_RAM;
   bool m_trace_enabled = DEFAULT_TRACE_ENABLED;
   std::string m_trace_file_name;
+  trace_format_t m_trace_format = DEFAULT_TRACE_FORMAT;
+  uint32_t m_trace_pc_first = DEFAULT_TRACE_PC_FIRST;
+  uint32_t m_trace_pc_last = DEFAULT_TRACE_PC_LAST;
+  uint64_t m_trace_cycle_begin = DEFAULT_TRACE_CYCLE_BEGIN;
+  uint64_t m_trace_cycle_end = DEFAULT_TRACE_CYCLE_END;
+  bool m_trace_trigger_enabled = false;
+  uint32_t m_trace_trigger_pc = 0u;
+  uint32_t m_trace_sample_rate = DEFAULT_TRACE_SAMPLE_RATE;
+  bool m_profile_enabled = DEFAULT_PROFILE_ENABLED;
+  std::string m_profile_file_name;
+  std::string m_profile_stacks_file_name;
+  bool m_instr_mix_enabled = DEFAULT_INSTR_MIX_ENABLED;
+  std::string m_instr_mix_file_name;
+  bool m_stats_json_enabled = DEFAULT_STATS_JSON_ENABLED;
+  std::string m_stats_json_file_name;
+  bool m_timing_enabled = DEFAULT_TIMING_ENABLED;
+  std::string m_timing_params_file_name;
+  std::string m_icache_spec;
+  std::string m_dcache_spec;
+  bool m_branch_stats_enabled = DEFAULT_BRANCH_STATS_ENABLED;
+  cpu_type_t m_cpu_type = DEFAULT_CPU_TYPE;
+  uint32_t m_num_harts = DEFAULT_NUM_HARTS;
+  bool m_virtual_time = DEFAULT_VIRTUAL_TIME;
   bool m_verbose = DEFAULT_VERBOSE;
   bool m_gfx_enabled = DEFAULT_GFX_ENABLED;
   uint32_t m_gfx_addr = DEFAULT_GFX_ADDR;
@@ -19,6 +19,7 @@
 
 #include "cpu.hpp"
 
+#include "alu_simd.hpp"
 #include "config.hpp"
 
 #include <algorithm>
@@ -33,6 +34,38 @@
 
 namespace {
 
+inline std::string as_hex32(const uint32_t x) {
+  char str[16];
+  std::snprintf(str, sizeof(str) - 1, "0x%08x", x);
+  return std::string(&str[0]);
+}
+
+template <typename T>
+inline std::string as_dec(const T x) {
+  char str[32];
+  std::snprintf(str, sizeof(str) - 1, "%d", static_cast<int>(x));
+  return std::string(&str[0]);
+}
+
+const char* const MEM_OP_NAMES[16] = {"none", "ldb", "ldh", "ldw", "(4)",  "ldub", "lduh", "ldea",
+                                       "(8)",  "stb", "sth", "stw", "(12)", "(13)", "(14)", "(15)"};
+const char* const PACKED_MODE_NAMES[4] = {"none", "byte", "half_word", "reserved"};
+const char* const VECTOR_MODE_NAMES[4] = {"scalar", "folding", "vector_scalar", "vector_vector"};
+
+// The identity of the hart that runs on the current host thread (used by CPUID).
+thread_local uint32_t t_hart_id = 0u;
+thread_local uint32_t t_num_harts = 1u;
+
+void print_count(const std::string& name, const uint64_t count) {
+  char str[64];
+  std::snprintf(str,
+                sizeof(str) - 1,
+                "  %-20s%llu\n",
+                name.c_str(),
+                static_cast<unsigned long long>(count));
+  std::cout << str;
+}
+
 void configure_fpu() {
 #ifdef __x86_64__
   _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
@@ -42,17 +75,69 @@ void configure_fpu() {
 
 }  // namespace
 
-cpu_t::cpu_t(ram_t& ram) : m_ram(ram), m_syscalls(ram) {
+cpu_t::code_sync_t::code_sync_t(const ram_t& ram, const uint32_t num_harts)
+    : m_mailboxes(new mailbox_t[num_harts]), m_num_harts(num_harts) {
+  const uint64_t num_pages = (ram.size() + DECODED_PAGE_SIZE - 1u) >> LOG2_DECODED_PAGE_SIZE;
+  m_code_pages.reset(new std::atomic<uint8_t>[num_pages]);
+  for (uint64_t i = 0u; i < num_pages; ++i) {
+    m_code_pages[i] = 0u;
+  }
+}
+
+void cpu_t::code_sync_t::post(const uint32_t sender, const uint32_t addr) {
+  for (uint32_t hart_id = 0u; hart_id < m_num_harts; ++hart_id) {
+    if (hart_id == sender) {
+      continue;
+    }
+    auto& mailbox = m_mailboxes[hart_id];
+    std::lock_guard<std::mutex> lock(mailbox.mutex);
+    if (mailbox.addrs.size() < MAX_FORWARDED_STORES) {
+      mailbox.addrs.push_back(addr);
+    } else {
+      mailbox.overflow = true;
+    }
+    mailbox.pending.store(true, std::memory_order_release);
+  }
+}
+
+bool cpu_t::code_sync_t::take(const uint32_t hart_id, std::vector<uint32_t>& addrs) {
+  auto& mailbox = m_mailboxes[hart_id];
+  std::lock_guard<std::mutex> lock(mailbox.mutex);
+  addrs.swap(mailbox.addrs);
+  mailbox.addrs.clear();
+  const bool overflow = mailbox.overflow;
+  mailbox.overflow = false;
+  mailbox.pending.store(false, std::memory_order_relaxed);
+  return overflow;
+}
+
+cpu_t::cpu_t(ram_t& ram)
+    : m_code_pages((ram.size() + DECODED_PAGE_SIZE - 1u) >> LOG2_DECODED_PAGE_SIZE, 0u),
+      m_code_page_flags(m_code_pages.data()),
+      m_ram(ram),
+      m_syscalls(ram) {
+  m_decoded_dirs.resize((m_code_pages.size() + DECODED_PAGES_PER_DIR - 1u) >>
+                        LOG2_DECODED_PAGES_PER_DIR);
+
   if (config_t::instance().trace_enabled()) {
-    m_trace_file.open(config_t::instance().trace_file_name(), std::ios::out | std::ios::binary);
+    m_trace_writer.open(
+        config_t::instance().trace_file_name(),
+        config_t::instance().trace_format() == config_t::trace_format_t::COMPRESSED);
+    m_trace_filter.set_pc_range(config_t::instance().trace_pc_first(),
+                                config_t::instance().trace_pc_last());
+    m_trace_filter.set_cycle_window(config_t::instance().trace_cycle_begin(),
+                                    config_t::instance().trace_cycle_end());
+    if (config_t::instance().trace_trigger_enabled()) {
+      m_trace_filter.set_trigger_pc(config_t::instance().trace_trigger_pc());
+    }
+    m_trace_filter.set_sample_rate(config_t::instance().trace_sample_rate());
   }
+  m_instr_mix_enabled = config_t::instance().instr_mix_enabled();
   reset();
 }
 
 cpu_t::~cpu_t() {
-  if (m_trace_file.is_open()) {
-    m_trace_file.close();
-  }
+  m_trace_writer.close();
 }
 
 void cpu_t::reset() {
@@ -65,6 +150,8 @@ void cpu_t::reset() {
   // Clear run state.
   m_syscalls.clear();
   m_terminate_requested = false;
+  flush_decoded();
+  clear_stats();
 
   // Configure the host FPU to match MRISC32 behavior.
   configure_fpu();
@@ -74,14 +161,600 @@ void cpu_t::terminate() {
   m_terminate_requested = true;
 }
 
+void cpu_t::set_hart(const uint32_t hart_id, const uint32_t num_harts) {
+  m_hart_id = hart_id;
+  m_num_harts = num_harts;
+}
+
+void cpu_t::set_code_sync(code_sync_t* code_sync) {
+  m_code_sync = code_sync;
+  m_code_page_flags = m_code_pages.data();
+  if (code_sync != nullptr) {
+    // Share the code pages that this hart already has (e.g. recompiled code).
+    for (uint32_t page_no = 0u; page_no < m_code_pages.size(); ++page_no) {
+      if (m_code_pages[page_no] != 0u) {
+        code_sync->mark_code_page(page_no);
+      }
+    }
+    m_code_page_flags = code_sync->code_pages();
+  }
+}
+
+void cpu_t::bind_hart_to_thread() const {
+  t_hart_id = m_hart_id;
+  t_num_harts = m_num_harts;
+}
+
+void cpu_t::clear_stats() {
+  m_fetched_instr_count = 0u;
+  m_vector_loop_count = 0u;
+  m_total_cycle_count = 0u;
+  m_decoded_hit_count = 0u;
+
+  // The EX op histogram is large and sparse, so it is only allocated if it is used.
+  m_instr_mix.ex_ops.assign(m_instr_mix_enabled ? instr_mix_t::NUM_EX_OPS : 0u, 0u);
+  m_instr_mix.mem_ops.fill(0u);
+  m_instr_mix.packed_modes.fill(0u);
+  m_instr_mix.vector_modes.fill(0u);
+  m_instr_mix.branches_taken = 0u;
+  m_instr_mix.branches_not_taken = 0u;
+  m_instr_mix.jumps = 0u;
+  m_instr_mix.subroutine_calls = 0u;
+}
+
 void cpu_t::dump_stats() {
   const double cpo = static_cast<double>(m_total_cycle_count) /
                      static_cast<double>(m_fetched_instr_count + m_vector_loop_count);
+  const double hit_ratio = static_cast<double>(m_decoded_hit_count) /
+                           static_cast<double>(std::max<uint64_t>(m_fetched_instr_count, 1u));
   std::cout << "CPU instructions:\n";
   std::cout << " Fetched instructions: " << m_fetched_instr_count << "\n";
   std::cout << " Vector loops:         " << m_vector_loop_count << "\n";
   std::cout << " Total CPU cycles:     " << m_total_cycle_count << "\n";
   std::cout << " Cycles/Operation:     " << cpo << "\n";
+  std::cout << " Decoded cache hits:   " << m_decoded_hit_count << " (" << (100.0 * hit_ratio)
+            << "%)\n";
+  std::cout << " Simulator calls:      " << m_syscalls.call_count() << "\n";
+}
+
+std::string cpu_t::ex_op_name(const uint32_t ex_op) {
+  switch (ex_op) {
+    case EX_OP_CPUID:
+      return "cpuid";
+    case EX_OP_LDHI:
+      return "ldhi";
+    case EX_OP_LDHIO:
+      return "ldhio";
+    case EX_OP_ADDPCHI:
+      return "addpchi";
+    case EX_OP_OR:
+      return "or";
+    case EX_OP_NOR:
+      return "nor";
+    case EX_OP_AND:
+      return "and";
+    case EX_OP_BIC:
+      return "bic";
+    case EX_OP_XOR:
+      return "xor";
+    case EX_OP_ADD:
+      return "add";
+    case EX_OP_SUB:
+      return "sub";
+    case EX_OP_SEQ:
+      return "seq";
+    case EX_OP_SNE:
+      return "sne";
+    case EX_OP_SLT:
+      return "slt";
+    case EX_OP_SLTU:
+      return "sltu";
+    case EX_OP_SLE:
+      return "sle";
+    case EX_OP_SLEU:
+      return "sleu";
+    case EX_OP_MIN:
+      return "min";
+    case EX_OP_MAX:
+      return "max";
+    case EX_OP_MINU:
+      return "minu";
+    case EX_OP_MAXU:
+      return "maxu";
+    case EX_OP_ASR:
+      return "asr";
+    case EX_OP_LSL:
+      return "lsl";
+    case EX_OP_LSR:
+      return "lsr";
+    case EX_OP_SHUF:
+      return "shuf";
+    case EX_OP_PACKB:
+      return "packb";
+    case EX_OP_PACKH:
+      return "packh";
+    case EX_OP_ADDS:
+      return "adds";
+    case EX_OP_ADDSU:
+      return "addsu";
+    case EX_OP_ADDH:
+      return "addh";
+    case EX_OP_ADDHU:
+      return "addhu";
+    case EX_OP_SUBS:
+      return "subs";
+    case EX_OP_SUBSU:
+      return "subsu";
+    case EX_OP_SUBH:
+      return "subh";
+    case EX_OP_SUBHU:
+      return "subhu";
+    case EX_OP_MULQ:
+      return "mulq";
+    case EX_OP_MUL:
+      return "mul";
+    case EX_OP_MULHI:
+      return "mulhi";
+    case EX_OP_MULHIU:
+      return "mulhiu";
+    case EX_OP_DIV:
+      return "div";
+    case EX_OP_DIVU:
+      return "divu";
+    case EX_OP_REM:
+      return "rem";
+    case EX_OP_REMU:
+      return "remu";
+    case EX_OP_FMIN:
+      return "fmin";
+    case EX_OP_FMAX:
+      return "fmax";
+    case EX_OP_FSEQ:
+      return "fseq";
+    case EX_OP_FSNE:
+      return "fsne";
+    case EX_OP_FSLT:
+      return "fslt";
+    case EX_OP_FSLE:
+      return "fsle";
+    case EX_OP_FSNAN:
+      return "fsnan";
+    case EX_OP_ITOF:
+      return "itof";
+    case EX_OP_UTOF:
+      return "utof";
+    case EX_OP_FTOI:
+      return "ftoi";
+    case EX_OP_FTOU:
+      return "ftou";
+    case EX_OP_FTOIR:
+      return "ftoir";
+    case EX_OP_FTOUR:
+      return "ftour";
+    case EX_OP_FADD:
+      return "fadd";
+    case EX_OP_FSUB:
+      return "fsub";
+    case EX_OP_FMUL:
+      return "fmul";
+    case EX_OP_FDIV:
+      return "fdiv";
+    case EX_OP_CLZ:
+      return "clz";
+    case EX_OP_REV:
+      return "rev";
+    case EX_OP_FSQRT:
+      return "fsqrt";
+    default: {
+      char str[16];
+      std::snprintf(str, sizeof(str) - 1, "ex_op_0x%04x", ex_op);
+      return std::string(&str[0]);
+    }
+  }
+}
+
+void cpu_t::dump_instr_mix() const {
+  const auto& mix = m_instr_mix;
+  std::cout << "Instruction mix:\n";
+  std::cout << " ALU operations:\n";
+  for (uint32_t ex_op = 0u; ex_op < mix.ex_ops.size(); ++ex_op) {
+    if (mix.ex_ops[ex_op] != 0u) {
+      print_count(ex_op_name(ex_op), mix.ex_ops[ex_op]);
+    }
+  }
+  std::cout << " Memory operations:\n";
+  for (uint32_t mem_op = 1u; mem_op < mix.mem_ops.size(); ++mem_op) {
+    if (mix.mem_ops[mem_op] != 0u) {
+      print_count(MEM_OP_NAMES[mem_op], mix.mem_ops[mem_op]);
+    }
+  }
+  std::cout << " Branches:\n";
+  print_count("taken", mix.branches_taken);
+  print_count("not_taken", mix.branches_not_taken);
+  print_count("jumps", mix.jumps);
+  print_count("subroutine_calls", mix.subroutine_calls);
+  std::cout << " Packed modes:\n";
+  for (size_t k = 0u; k < mix.packed_modes.size(); ++k) {
+    print_count(PACKED_MODE_NAMES[k], mix.packed_modes[k]);
+  }
+  std::cout << " Vector modes:\n";
+  for (size_t k = 0u; k < mix.vector_modes.size(); ++k) {
+    print_count(VECTOR_MODE_NAMES[k], mix.vector_modes[k]);
+  }
+}
+
+void cpu_t::write_stats(json_writer_t& json) const {
+  json.value("fetched_instructions", m_fetched_instr_count);
+  json.value("vector_loops", m_vector_loop_count);
+  json.value("total_cycles", m_total_cycle_count);
+  json.value("decoded_cache_hits", m_decoded_hit_count);
+  json.value("simulator_calls", m_syscalls.call_count());
+}
+
+void cpu_t::write_instr_mix(json_writer_t& json) const {
+  const auto& mix = m_instr_mix;
+  json.begin_object("ex_ops");
+  for (uint32_t ex_op = 0u; ex_op < mix.ex_ops.size(); ++ex_op) {
+    if (mix.ex_ops[ex_op] != 0u) {
+      json.value(ex_op_name(ex_op), mix.ex_ops[ex_op]);
+    }
+  }
+  json.end_object();
+  json.begin_object("mem_ops");
+  for (uint32_t mem_op = 1u; mem_op < mix.mem_ops.size(); ++mem_op) {
+    if (mix.mem_ops[mem_op] != 0u) {
+      json.value(MEM_OP_NAMES[mem_op], mix.mem_ops[mem_op]);
+    }
+  }
+  json.end_object();
+  json.begin_object("branches");
+  json.value("taken", mix.branches_taken);
+  json.value("not_taken", mix.branches_not_taken);
+  json.value("jumps", mix.jumps);
+  json.value("subroutine_calls", mix.subroutine_calls);
+  json.end_object();
+  json.begin_object("packed_modes");
+  for (size_t k = 0u; k < mix.packed_modes.size(); ++k) {
+    json.value(PACKED_MODE_NAMES[k], mix.packed_modes[k]);
+  }
+  json.end_object();
+  json.begin_object("vector_modes");
+  for (size_t k = 0u; k < mix.vector_modes.size(); ++k) {
+    json.value(VECTOR_MODE_NAMES[k], mix.vector_modes[k]);
+  }
+  json.end_object();
+}
+
+cpu_t::decoded_instr_t cpu_t::decode(const uint32_t iword) {
+  decoded_instr_t d = decoded_instr_t();
+
+  // Detect encoding class (A, B or C).
+  const bool op_class_B = ((iword & 0xfc00007cu) == 0x0000007cu);
+  const bool op_class_A = ((iword & 0xfc000000u) == 0x00000000u) && !op_class_B;
+  const bool op_class_D = ((iword & 0xc0000000u) == 0xc0000000u);
+  const bool op_class_C = !op_class_A && !op_class_B && !op_class_D;
+
+  // Is this a vector operation?
+  const uint32_t vec_mask = op_class_A ? 3u : (op_class_B || op_class_C ? 2u : 0u);
+  const uint32_t vector_mode = (iword >> 14u) & vec_mask;
+
+  // Is this a packed operation?
+  const uint32_t packed_mode = (op_class_A || op_class_B ? ((iword & 0x00000180u) >> 7) : 0u);
+
+  // Extract parts of the instruction.
+  // NOTE: These may or may not be valid, depending on the instruction type.
+  const uint32_t reg1 = (iword >> 21u) & 31u;
+  const uint32_t reg2 = (iword >> 16u) & 31u;
+  const uint32_t reg3 = (iword >> 9u) & 31u;
+  const uint32_t imm15 = (iword & 0x00007fffu) | ((iword & 0x00004000u) ? 0xffff8000u : 0u);
+  const uint32_t imm21 = (iword & 0x001fffffu) | ((iword & 0x00100000u) ? 0xffe00000u : 0u);
+
+  // Branch instructions.
+  const bool is_bcc = ((iword & 0xe0000000u) == 0xc0000000u);
+  const bool is_j = ((iword & 0xf8000000u) == 0xe0000000u);
+  const bool is_subroutine_branch = ((iword & 0xfc000000u) == 0xe4000000u);
+  const bool is_branch = is_bcc || is_j;
+
+  // Is this a mem load/store operation?
+  const bool is_ldx =
+      ((iword & 0xfc000078u) == 0x00000000u) && ((iword & 0x00000007u) != 0x00000000u);
+  const bool is_ld =
+      ((iword & 0xe0000000u) == 0x00000000u) && ((iword & 0x1c000000u) != 0x00000000u);
+  const bool is_mem_load = is_ldx || is_ld;
+  const bool is_stx = ((iword & 0xfc000078u) == 0x00000008u);
+  const bool is_st = ((iword & 0xe0000000u) == 0x20000000u);
+  const bool is_mem_store = is_stx || is_st;
+  const bool is_mem_op = (is_mem_load || is_mem_store);
+
+  // Is this ADDPCHI?
+  const bool is_addpchi = ((iword & 0xfc000000u) == 0xf4000000u);
+
+  // Should we use reg1 as a source (special case)?
+  const bool reg1_is_src = is_mem_store || is_branch;
+
+  // Should we use reg2 as a source?
+  const bool reg2_is_src = op_class_A || op_class_B || op_class_C;
+
+  // Should we use reg3 as a source?
+  const bool reg3_is_src = op_class_A;
+
+  // Should we use reg1 as a destination?
+  const bool reg1_is_dst = !reg1_is_src;
+
+  // Determine the source & destination register numbers (zero for none).
+  const uint32_t src_reg_a =
+      (is_subroutine_branch || is_addpchi) ? REG_PC : (reg2_is_src ? reg2 : REG_Z);
+  const uint32_t src_reg_b = reg3_is_src ? reg3 : REG_Z;
+  const uint32_t src_reg_c = reg1_is_src ? reg1 : REG_Z;
+  const uint32_t dst_reg = is_subroutine_branch ? REG_LR : (reg1_is_dst ? reg1 : REG_Z);
+
+  // Determine EX operation.
+  uint32_t ex_op = EX_OP_CPUID;
+  if (is_subroutine_branch) {
+    ex_op = EX_OP_ADD;
+  } else if (op_class_A && ((iword & 0x000001f0u) != 0x00000000u)) {
+    ex_op = iword & 0x0000007fu;
+  } else if (op_class_B) {
+    ex_op = iword & 0x00007e7fu;
+  } else if (op_class_C && ((iword & 0xc0000000u) != 0x00000000u)) {
+    ex_op = iword >> 26u;
+  } else if (op_class_D) {
+    switch (iword & 0xfc000000u) {
+      case 0xe8000000u:  // ldli
+        ex_op = EX_OP_OR;
+        break;
+      case 0xec000000u:  // ldhi
+        ex_op = EX_OP_LDHI;
+        break;
+      case 0xf0000000u:  // ldhio
+        ex_op = EX_OP_LDHIO;
+        break;
+      case 0xf4000000u:  // addpchi
+        ex_op = EX_OP_ADDPCHI;
+        break;
+    }
+  }
+
+  // Determine MEM operation.
+  uint32_t mem_op = MEM_OP_NONE;
+  if (is_mem_load) {
+    mem_op = (is_ldx ? (iword & 0x0000007fu) : (iword >> 26u));
+  } else if (is_mem_store) {
+    mem_op = (is_stx ? (iword & 0x0000007fu) : (iword >> 26u));
+  }
+
+  // Determine the execution unit (for timing models).
+  exec_unit_t exec_unit = exec_unit_t::ALU;
+  if (is_bcc) {
+    exec_unit = exec_unit_t::BRANCH;
+  } else if (is_mem_load && mem_op != MEM_OP_LDEA) {
+    exec_unit = exec_unit_t::LOAD;
+  } else if (is_mem_store) {
+    exec_unit = exec_unit_t::STORE;
+  } else if (!is_mem_op && !is_j) {
+    if (ex_op >= EX_OP_MULQ && ex_op <= EX_OP_MULHIU) {
+      exec_unit = exec_unit_t::MUL;
+    } else if (ex_op >= EX_OP_DIV && ex_op <= EX_OP_REMU) {
+      exec_unit = exec_unit_t::DIV;
+    } else if (ex_op >= EX_OP_FMIN && ex_op <= EX_OP_FMUL) {
+      exec_unit = exec_unit_t::FPU;
+    } else if (ex_op == EX_OP_FDIV) {
+      exec_unit = exec_unit_t::FDIV;
+    } else if (ex_op == EX_OP_FSQRT) {
+      exec_unit = exec_unit_t::FSQRT;
+    }
+  }
+
+  d.imm = op_class_C ? imm15 : imm21;
+  d.ex_op = ex_op;
+  d.mem_op = static_cast<uint8_t>(mem_op);
+  d.packed_mode = static_cast<uint8_t>(packed_mode);
+  d.vector_mode = static_cast<uint8_t>(vector_mode);
+  d.reg1 = static_cast<uint8_t>(reg1);
+  d.reg3 = static_cast<uint8_t>(reg3);
+  d.src_reg_a = static_cast<uint8_t>(src_reg_a);
+  d.src_reg_b = static_cast<uint8_t>(src_reg_b);
+  d.src_reg_c = static_cast<uint8_t>(src_reg_c);
+  d.dst_reg = static_cast<uint8_t>(dst_reg);
+  d.exec_unit = exec_unit;
+  d.condition = static_cast<uint8_t>((iword >> 26u) & 0x0000003fu);
+  d.op_class_C = op_class_C;
+  d.op_class_D = op_class_D;
+  d.is_bcc = is_bcc;
+  d.is_j = is_j;
+  d.is_subroutine_branch = is_subroutine_branch;
+  d.is_mem_op = is_mem_op;
+  d.reg1_is_src = reg1_is_src;
+  d.reg2_is_src = reg2_is_src;
+  d.reg3_is_src = reg3_is_src;
+  d.valid = true;
+  return d;
+}
+
+const cpu_t::decoded_instr_t& cpu_t::decode_and_cache(const uint32_t pc) {
+  // Note: load32() throws an exception if the address is out of range or unaligned, so past this
+  // point we know that the PC is inside a valid page.
+  const uint32_t iword = m_ram.load32(pc);
+
+  const uint32_t page_no = pc >> LOG2_DECODED_PAGE_SIZE;
+  auto& dir = m_decoded_dirs[page_no >> LOG2_DECODED_PAGES_PER_DIR];
+  if (!dir) {
+    dir.reset(new decoded_dir_t());
+  }
+  auto& page = (*dir)[page_no & (DECODED_PAGES_PER_DIR - 1u)];
+  if (!page) {
+    page.reset(new decoded_page_t());
+    mark_code_page(page_no, CODE_PAGE_DECODED);
+    m_last_page_no = ~0u;
+  }
+  auto& instr = (*page)[(pc & (DECODED_PAGE_SIZE - 1u)) >> 2u];
+  instr = decode(iword);
+  instr.handler = resolve_handler(instr);
+  return instr;
+}
+
+uint16_t cpu_t::resolve_handler(const decoded_instr_t& /* instr */) const {
+  // The default implementation does not use handlers.
+  return 0u;
+}
+
+void cpu_t::translated_code_modified(const uint32_t /* addr */) {
+  // The default implementation does not translate code.
+}
+
+void cpu_t::flush_translations() {
+  // The default implementation does not translate code.
+}
+
+void cpu_t::code_modified(const uint32_t addr) {
+  if (m_code_sync != nullptr) {
+    m_code_sync->post(m_hart_id, addr);
+  }
+  invalidate_code(addr);
+}
+
+void cpu_t::apply_forwarded_stores() {
+  if (m_code_sync->take(m_hart_id, m_forwarded_stores)) {
+    // Too many stores to track: Invalidate all code (without freeing any decoded pages).
+    for (auto& dir : m_decoded_dirs) {
+      if (dir) {
+        for (auto& page : *dir) {
+          if (page) {
+            for (auto& instr : *page) {
+              instr.valid = false;
+            }
+          }
+        }
+      }
+    }
+    flush_translations();
+  } else {
+    for (const auto addr : m_forwarded_stores) {
+      if (m_code_pages[addr >> LOG2_DECODED_PAGE_SIZE] != 0u) {
+        invalidate_code(addr);
+      }
+    }
+  }
+}
+
+void cpu_t::invalidate_code(const uint32_t addr) {
+  const uint32_t page_no = addr >> LOG2_DECODED_PAGE_SIZE;
+  auto* page = decoded_page(page_no);
+  if (page != nullptr) {
+    (*page)[(addr & (DECODED_PAGE_SIZE - 1u)) >> 2u].valid = false;
+  }
+  if ((m_code_pages[page_no] & CODE_PAGE_TRANSLATED) != 0u) {
+    translated_code_modified(addr);
+  }
+}
+
+void cpu_t::invalidate_decoded(const uint32_t addr, const uint32_t size) {
+  if (size == 0u) {
+    return;
+  }
+
+  // Only visit the words of pages that hold decoded or translated code.
+  const uint64_t end = static_cast<uint64_t>(addr) + size;
+  uint64_t word_addr = addr & ~UINT64_C(3);
+  while (word_addr < end) {
+    const uint64_t page_end = std::min(end, (word_addr | (DECODED_PAGE_SIZE - 1u)) + 1u);
+    const auto page_no = static_cast<uint32_t>(word_addr >> LOG2_DECODED_PAGE_SIZE);
+    if (page_no < m_code_pages.size() && m_code_page_flags[page_no] != 0u) {
+      for (; word_addr < page_end; word_addr += 4u) {
+        code_modified(static_cast<uint32_t>(word_addr));
+      }
+    }
+    word_addr = (page_end + 3u) & ~UINT64_C(3);
+  }
+}
+
+void cpu_t::flush_decoded() {
+  for (auto& dir : m_decoded_dirs) {
+    dir.reset();
+  }
+  m_last_page_no = ~0u;
+  m_last_page = nullptr;
+  std::fill(m_code_pages.begin(), m_code_pages.end(), 0u);
+  flush_translations();
+}
+
+void cpu_t::execute_vector_alu(const decoded_instr_t& instr, const uint32_t count) {
+  // ALU operations have no side effects, so we can skip them if the result is discarded.
+  if (instr.dst_reg == REG_Z) {
+    return;
+  }
+
+  uint32_t* dst = m_vregs[instr.dst_reg].data();
+  const uint32_t* src_a = m_vregs[instr.src_reg_a].data();
+  const uint32_t* src_b = nullptr;
+  uint32_t scalar_b = 0u;
+  if ((instr.vector_mode & 1u) != 0u) {
+    // Folding operations read the upper part of the source vector register.
+    src_b = m_vregs[instr.src_reg_b].data() + (instr.vector_mode == 1u ? m_regs[REG_VL] : 0u);
+  } else {
+    scalar_b = (instr.op_class_C || instr.op_class_D) ? instr.imm : m_regs[instr.src_reg_b];
+  }
+
+  // Note: The elements are processed in order, which gives the same result as processing one
+  // element per cycle when the destination register is also a source register.
+  uint32_t i = execute_alu_simd(instr.ex_op, instr.packed_mode, dst, src_a, src_b, scalar_b, count);
+  for (; i < count; ++i) {
+    dst[i] = execute_alu(
+        instr.ex_op, instr.packed_mode, src_a[i], src_b != nullptr ? src_b[i] : scalar_b);
+  }
+}
+
+void cpu_t::execute_vector_mem(const decoded_instr_t& instr, const uint32_t count) {
+  const uint32_t base_addr = m_regs[instr.src_reg_a];
+  const uint32_t scale = index_scale_factor(instr.packed_mode);
+  const uint32_t stride = instr.op_class_C ? instr.imm : m_regs[instr.reg3];
+  const bool gather_scatter = (instr.vector_mode == 3u);
+  const uint32_t* offsets = m_vregs[instr.src_reg_b].data();
+  const uint32_t* store_data = m_vregs[instr.src_reg_c].data();
+  uint32_t* dst = (instr.dst_reg != REG_Z) ? m_vregs[instr.dst_reg].data() : nullptr;
+
+  uint32_t addr_offset = 0u;
+  for (uint32_t i = 0u; i < count; ++i) {
+    const uint32_t addr = base_addr + (gather_scatter ? offsets[i] : addr_offset) * scale;
+    addr_offset += stride;
+
+    uint32_t mem_result = 0u;
+    switch (instr.mem_op) {
+      case MEM_OP_LOAD8:
+        mem_result = m_ram.load8signed(addr);
+        break;
+      case MEM_OP_LOADU8:
+        mem_result = m_ram.load8(addr);
+        break;
+      case MEM_OP_LOAD16:
+        mem_result = m_ram.load16signed(addr);
+        break;
+      case MEM_OP_LOADU16:
+        mem_result = m_ram.load16(addr);
+        break;
+      case MEM_OP_LOAD32:
+        mem_result = m_ram.load32(addr);
+        break;
+      case MEM_OP_LDEA:
+        mem_result = addr;
+        break;
+      case MEM_OP_STORE8:
+        m_ram.store8(addr, store_data[i]);
+        invalidate_decoded(addr);
+        break;
+      case MEM_OP_STORE16:
+        m_ram.store16(addr, store_data[i]);
+        invalidate_decoded(addr);
+        break;
+      case MEM_OP_STORE32:
+        m_ram.store32(addr, store_data[i]);
+        invalidate_decoded(addr);
+        break;
+    }
+    if (dst != nullptr) {
+      dst[i] = mem_result;
+    }
+  }
 }
 
 void cpu_t::dump_ram(const uint32_t begin, const uint32_t end, const std::string& file_name) {
@@ -94,8 +767,65 @@ void cpu_t::dump_ram(const uint32_t begin, const uint32_t end, const std::string
   file.close();
 }
 
+uint32_t cpu_t::cpuid32(const uint32_t a, const uint32_t b) {
+  switch (a) {
+    case 0x00000000u:
+      // Number of vector elements
+      if (b == 0x00000000u) {
+        return NUM_VECTOR_ELEMENTS;
+      } else if (b == 0x00000001u) {
+        return LOG2_NUM_VECTOR_ELEMENTS;
+      } else {
+        return 0u;
+      }
+
+    case 0x00000001u:
+      if (b == 0x00000000u) {
+        // CPU features:
+        //   VEC (vector processor)     = 1 << 0
+        //   PO (packed operations)     = 1 << 1
+        //   MUL (integer mul)          = 1 << 2
+        //   DIV (integer mul)          = 1 << 3
+        //   SA (saturating arithmetic) = 1 << 4
+        //   FP (floating point)        = 1 << 5
+        //   SQRT (float sqrt)          = 1 << 6
+        return 0x0000007fu;
+      } else {
+        return 0u;
+      }
+
+    case 0x00000002u:
+      if (b == 0x00000000u) {
+        // Hart ID (the ID of this CPU core)
+        return t_hart_id;
+      } else if (b == 0x00000001u) {
+        // Number of harts
+        return t_num_harts;
+      } else {
+        return 0u;
+      }
+
+    default:
+      return 0u;
+  }
+}
+
+std::string cpu_t::register_dump() const {
+  std::string dump("\n");
+  for (int i = 1; i <= 25; ++i) {
+    dump += "S" + as_dec(i) + ": " + as_hex32(m_regs[i]) + "\n";
+  }
+  dump += "FP: " + as_hex32(m_regs[REG_FP]) + "\n";
+  dump += "TP: " + as_hex32(m_regs[REG_TP]) + "\n";
+  dump += "SP: " + as_hex32(m_regs[REG_SP]) + "\n";
+  dump += "VL: " + as_hex32(m_regs[REG_VL]) + "\n";
+  dump += "LR: " + as_hex32(m_regs[REG_LR]) + "\n";
+  dump += "PC: " + as_hex32(m_regs[REG_PC]) + "\n";
+  return dump;
+}
+
 void cpu_t::append_debug_trace(const debug_trace_t& trace) {
-  if (!(m_trace_file.is_open() && trace.valid)) {
+  if (!(m_trace_writer.is_open() && trace.valid)) {
     return;
   }
 
@@ -132,7 +862,6 @@ void cpu_t::append_debug_trace(const debug_trace_t& trace) {
     buf[19] = static_cast<uint8_t>(trace.src_c >> 24);
   }
 
-  m_trace_file.write(reinterpret_cast<const char*>(&buf[0]), sizeof(buf));
-  m_trace_file.flush();
+  m_trace_writer.write_record(&buf[0], trace.cycle);
 }
 
@@ -20,17 +20,80 @@
 #ifndef SIM_CPU_HPP_
 #define SIM_CPU_HPP_
 
+#include "event_scheduler.hpp"
+#include "json_writer.hpp"
+#include "profiler.hpp"
 #include "ram.hpp"
 #include "syscalls.hpp"
+#include "timing_model.hpp"
+#include "trace_filter.hpp"
+#include "trace_writer.hpp"
 
 #include <array>
 #include <atomic>
 #include <cstdint>
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 /// @brief A CPU core instance.
 class cpu_t {
 public:
+  /// @brief Code invalidation between harts that share the same RAM.
+  ///
+  /// Each hart has its own decoded instruction cache (and translated code). Stores to pages that
+  /// hold code for any hart are forwarded to the other harts, which invalidate the modified code at
+  /// their next synchronization point (see sync_code()).
+  class code_sync_t {
+  public:
+    /// @brief Constructor for code_sync_t.
+    /// @param ram The shared RAM.
+    /// @param num_harts The number of harts that share the RAM.
+    code_sync_t(const ram_t& ram, const uint32_t num_harts);
+
+    /// @brief Get the per page code flags (non-zero if any hart has code in the page).
+    const uint8_t* code_pages() const {
+      return reinterpret_cast<const uint8_t*>(m_code_pages.get());
+    }
+
+    /// @brief Mark a page as holding code.
+    void mark_code_page(const uint32_t page_no) {
+      m_code_pages[page_no].store(1u, std::memory_order_release);
+    }
+
+    /// @brief Forward a store to code to all harts except the sender.
+    void post(const uint32_t sender, const uint32_t addr);
+
+    /// @brief Check if there are forwarded stores for a hart.
+    bool pending(const uint32_t hart_id) const {
+      return m_mailboxes[hart_id].pending.load(std::memory_order_acquire);
+    }
+
+    /// @brief Take the forwarded stores for a hart.
+    /// @param hart_id The receiving hart.
+    /// @param addrs The addresses of the stores (swapped with the mailbox).
+    /// @returns true if too many stores were forwarded, and all code must be invalidated.
+    bool take(const uint32_t hart_id, std::vector<uint32_t>& addrs);
+
+  private:
+    // Beyond this many forwarded stores, the receiver invalidates all code instead.
+    static const size_t MAX_FORWARDED_STORES = 1024u;
+
+    struct mailbox_t {
+      std::mutex mutex;
+      std::vector<uint32_t> addrs;
+      bool overflow = false;
+      std::atomic_bool pending{false};
+    };
+
+    // The flags are also read as plain bytes (e.g. from translated code).
+    static_assert(sizeof(std::atomic<uint8_t>) == 1u, "Unsupported atomic layout");
+    std::unique_ptr<std::atomic<uint8_t>[]> m_code_pages;
+    std::unique_ptr<mailbox_t[]> m_mailboxes;
+    const uint32_t m_num_harts;
+  };
+
   virtual ~cpu_t();
 
   /// @brief Reset the CPU state.
@@ -39,13 +102,79 @@ public:
   /// @brief Terminate the CPU execution (can be called from another thread).
   void terminate();
 
+  /// @brief Set the hart (hardware thread) identity of this CPU core.
+  ///
+  /// The identity is reported to the running program through the CPUID instruction.
+  /// @param hart_id The ID of this hart (0 for the first hart).
+  /// @param num_harts The total number of harts that share the RAM.
+  void set_hart(const uint32_t hart_id, const uint32_t num_harts);
+
+  /// @brief Keep the code caches of harts that share RAM coherent.
+  /// @param code_sync The shared code invalidation state (nullptr for a single hart). This must be
+  /// set before the harts start running.
+  void set_code_sync(code_sync_t* code_sync);
+
+  /// @brief Make the GETTIMEMICROS simulator routine return simulated time.
+  /// @param cpu_clk The simulated CPU clock frequency (Hz), or zero to use the host time.
+  void set_virtual_clock(const uint32_t cpu_clk) {
+    m_syscalls.set_virtual_clock(cpu_clk);
+  }
+
+  /// @brief Get the hart ID of this CPU core.
+  uint32_t hart_id() const {
+    return m_hart_id;
+  }
+
   /// @brief Start running code at a given memory address.
   /// @param max_cycles The maximum number of cycles to simulate (-1 = no limit).
   /// @returns The program return code (the argument to exit()).
   virtual uint32_t run(const int64_t max_cycles) = 0;
 
   /// @brief Dump CPU stats from the last run.
-  void dump_stats();
+  virtual void dump_stats();
+
+  /// @brief Get the number of fetched instructions in the last run.
+  uint64_t fetched_instr_count() const {
+    return m_fetched_instr_count;
+  }
+
+  /// @brief Get the number of CPU cycles in the last run.
+  uint64_t total_cycle_count() const {
+    return m_total_cycle_count;
+  }
+
+  /// @brief Get the address where execution starts.
+  static uint32_t reset_pc() {
+    return RESET_PC;
+  }
+
+  /// @brief Enable per-PC profiling.
+  /// @param profiler The profiler to use (nullptr disables profiling). Only the simple CPU
+  /// implementation collects profiling data.
+  void set_profiler(profiler_t* profiler) {
+    m_profiler = profiler;
+  }
+
+  /// @brief Set the event scheduler that drives the devices.
+  /// @param events The event scheduler to service between quanta (nullptr for none). The events
+  /// are called from the thread that runs the CPU.
+  void set_event_scheduler(event_scheduler_t* events) {
+    m_events = events;
+  }
+
+  /// @brief Get the name of an EX operation.
+  static std::string ex_op_name(const uint32_t ex_op);
+
+  /// @brief Print the instruction mix statistics from the last run.
+  void dump_instr_mix() const;
+
+  /// @brief Write CPU stats from the last run as JSON object members.
+  /// @param json The JSON writer (the members are added to the current object).
+  virtual void write_stats(json_writer_t& json) const;
+
+  /// @brief Write the instruction mix statistics from the last run as JSON object members.
+  /// @param json The JSON writer (the members are added to the current object).
+  void write_instr_mix(json_writer_t& json) const;
 
   /// @brief Dump RAM contents.
   void dump_ram(const uint32_t begin, const uint32_t end, const std::string& file_name);
@@ -54,6 +183,14 @@ protected:
   // This constructor is called from derived classes.
   cpu_t(ram_t& ram);
 
+  /// @brief Clear the run stats.
+  void clear_stats();
+
+  /// @brief Make the hart identity of this core visible to CPUID on the calling thread.
+  ///
+  /// Each hart runs in its own host thread, so this is called at the start of run().
+  void bind_hart_to_thread() const;
+
   // Register configuration.
   static const uint32_t NUM_REGS = 32u;
   static const uint32_t LOG2_NUM_VECTOR_ELEMENTS = 4u;  // Must be at least 4
@@ -170,8 +307,37 @@ protected:
   // One vector register.
   using vreg_t = std::array<uint32_t, NUM_VECTOR_ELEMENTS>;
 
+  // Pre-decoded instruction (everything in the ID stage that only depends on the instruction word).
+  struct decoded_instr_t {
+    uint32_t imm;               // Sign extended immediate (imm15 for class C, imm21 for class D).
+    uint32_t ex_op;             // EX operation.
+    uint16_t handler;           // Implementation specific handler (see resolve_handler()).
+    uint8_t mem_op;             // MEM operation.
+    uint8_t packed_mode;        // Packed operation mode.
+    uint8_t vector_mode;        // Vector mode (0 = scalar, 1 = folding, 2/3 = vector).
+    uint8_t reg1;               // Register field 1 (branch condition / jump base register).
+    uint8_t reg3;               // Register field 3 (vector stride register).
+    uint8_t src_reg_a;          // Source register A (zero for none).
+    uint8_t src_reg_b;          // Source register B (zero for none).
+    uint8_t src_reg_c;          // Source register C (zero for none).
+    uint8_t dst_reg;            // Destination register (zero for none).
+    uint8_t condition;          // Branch condition (b[cc] only).
+    exec_unit_t exec_unit;      // Execution unit (for timing models).
+    bool op_class_C;            // Encoding class C (reg, reg, imm15).
+    bool op_class_D;            // Encoding class D (reg, imm21).
+    bool is_bcc;                // Conditional branch.
+    bool is_j;                  // Jump (j/jl).
+    bool is_subroutine_branch;  // Jump and link (jl).
+    bool is_mem_op;             // Memory load/store operation.
+    bool reg1_is_src;           // reg1 is used as source operand C.
+    bool reg2_is_src;           // reg2 is used as source operand A.
+    bool reg3_is_src;           // reg3 is used as source operand B.
+    bool valid;                 // The record holds a decoded instruction.
+  };
+
   // Debug trace struct.
   struct debug_trace_t {
+    uint64_t cycle;
     bool valid;
     bool src_a_valid;
     bool src_b_valid;
@@ -182,12 +348,224 @@ protected:
     uint32_t src_c;
   };
 
+  // Instruction mix statistics (counted once per issued instruction, not per vector element).
+  struct instr_mix_t {
+    static const uint32_t NUM_EX_OPS = 0x8000u;
+
+    std::vector<uint64_t> ex_ops;          // ALU instructions, indexed by ex_op (if enabled).
+    std::array<uint64_t, 16u> mem_ops;     // Memory instructions, indexed by mem_op.
+    std::array<uint64_t, 4u> packed_modes;
+    std::array<uint64_t, 4u> vector_modes;
+    uint64_t branches_taken;
+    uint64_t branches_not_taken;
+    uint64_t jumps;
+    uint64_t subroutine_calls;
+  };
+
+  /// @brief Count an issued instruction in the instruction mix statistics.
+  ///
+  /// Conditional branches are counted separately by the CPU implementation, since the outcome is
+  /// only known after the branch has been resolved.
+  /// @param instr The decoded instruction.
+  void count_instr_mix(const decoded_instr_t& instr) {
+    if (instr.is_j) {
+      ++(instr.is_subroutine_branch ? m_instr_mix.subroutine_calls : m_instr_mix.jumps);
+    } else if (instr.is_mem_op) {
+      ++m_instr_mix.mem_ops[instr.mem_op & 15u];
+    } else if (!instr.is_bcc) {
+      ++m_instr_mix.ex_ops[instr.ex_op & (instr_mix_t::NUM_EX_OPS - 1u)];
+    }
+    ++m_instr_mix.packed_modes[instr.packed_mode & 3u];
+    ++m_instr_mix.vector_modes[instr.vector_mode & 3u];
+  }
+
+  /// @brief Get CPU information (the CPUID instruction).
+  static uint32_t cpuid32(const uint32_t a, const uint32_t b);
+
+  /// @brief Perform an EX stage ALU operation (defined in alu.hpp).
+  /// @param ex_op The EX operation.
+  /// @param packed_mode The packed operation mode.
+  /// @param src_a Source operand A.
+  /// @param src_b Source operand B.
+  /// @returns the result of the operation.
+  static uint32_t execute_alu(const uint32_t ex_op,
+                              const uint32_t packed_mode,
+                              const uint32_t src_a,
+                              const uint32_t src_b);
+
+  /// @brief Perform a vector ALU operation using host SIMD instructions (defined in alu_simd.hpp).
+  ///
+  /// Only common operations have SIMD implementations, and only whole host vectors are processed.
+  /// @param src_b Source vector B, or nullptr if @c scalar_b should be used for all elements.
+  /// @param count The number of elements to process.
+  /// @returns the number of (leading) elements that were processed. The remaining elements must be
+  /// processed with execute_alu().
+  static uint32_t execute_alu_simd(const uint32_t ex_op,
+                                   const uint32_t packed_mode,
+                                   uint32_t* dst,
+                                   const uint32_t* src_a,
+                                   const uint32_t* src_b,
+                                   const uint32_t scalar_b,
+                                   const uint32_t count);
+
+  /// @brief Execute the first @c count elements of a vector ALU operation.
+  /// @param instr The decoded vector instruction.
+  /// @param count The number of elements to process.
+  void execute_vector_alu(const decoded_instr_t& instr, const uint32_t count);
+
+  /// @brief Execute the first @c count elements of a vector memory operation.
+  /// @param instr The decoded vector instruction.
+  /// @param count The number of elements to process.
+  void execute_vector_mem(const decoded_instr_t& instr, const uint32_t count);
+
+  /// @brief Get a printable dump of the scalar registers.
+  std::string register_dump() const;
+
+  /// @brief Decode an instruction word.
+  /// @param iword The instruction word.
+  /// @returns the decoded instruction.
+  static decoded_instr_t decode(const uint32_t iword);
+
+  /// @brief Fetch a decoded instruction from the instruction cache.
+  ///
+  /// If the instruction is not in the cache, it is loaded from RAM and decoded.
+  /// @param pc The address of the instruction.
+  /// @returns the decoded instruction.
+  const decoded_instr_t& fetch_decoded(const uint32_t pc) {
+    const uint32_t page_no = pc >> LOG2_DECODED_PAGE_SIZE;
+    if (page_no != m_last_page_no) {
+      m_last_page = decoded_page(page_no);
+      m_last_page_no = page_no;
+    }
+    if ((pc & 3u) == 0u) {
+      auto* page = m_last_page;
+      if (page != nullptr) {
+        const auto& instr = (*page)[(pc & (DECODED_PAGE_SIZE - 1u)) >> 2u];
+        if (instr.valid) {
+          ++m_decoded_hit_count;
+          return instr;
+        }
+      }
+    }
+    return decode_and_cache(pc);
+  }
+
+  /// @brief Invalidate any decoded instruction at the given address.
+  ///
+  /// This must be called whenever the CPU writes to memory, to support self modifying code.
+  /// @param addr The memory address that was written to.
+  void invalidate_decoded(const uint32_t addr) {
+    const uint32_t page_no = addr >> LOG2_DECODED_PAGE_SIZE;
+    if (page_no < m_code_pages.size() && m_code_page_flags[page_no] != 0u) {
+      code_modified(addr);
+    }
+  }
+
+  /// @brief Invalidate any decoded instructions in the given address range.
+  /// @param addr The start of the memory range that was written to.
+  /// @param size The size of the memory range, in bytes.
+  void invalidate_decoded(const uint32_t addr, const uint32_t size);
+
+  /// @brief Invalidate the decoded (and translated) instruction at the given address.
+  ///
+  /// The store is also forwarded to the other harts (if any).
+  void code_modified(const uint32_t addr);
+
+  /// @brief Apply stores to code that other harts have forwarded to this hart.
+  ///
+  /// This must be called regularly from the thread that runs the CPU, e.g. before fetching an
+  /// instruction, at taken branches or between translated blocks.
+  void sync_code() {
+    if (m_code_sync != nullptr && m_code_sync->pending(m_hart_id)) {
+      apply_forwarded_stores();
+    }
+  }
+
+  /// @brief Invalidate the code at the stores that other harts have forwarded to this hart.
+  void apply_forwarded_stores();
+
+  /// @brief Invalidate the decoded (and translated) instruction at the given address, for this
+  /// hart only.
+  void invalidate_code(const uint32_t addr);
+
+  /// @brief Mark a page as holding code.
+  /// @param page_no The page number.
+  /// @param flag CODE_PAGE_DECODED or CODE_PAGE_TRANSLATED.
+  void mark_code_page(const uint32_t page_no, const uint8_t flag) {
+    m_code_pages[page_no] |= flag;
+    if (m_code_sync != nullptr) {
+      m_code_sync->mark_code_page(page_no);
+    }
+  }
+
+  /// @brief Invalidate all decoded instructions.
+  void flush_decoded();
+
+  /// @brief Load, decode and cache the instruction at the given address.
+  const decoded_instr_t& decode_and_cache(const uint32_t pc);
+
+  /// @brief Select an implementation specific handler for a decoded instruction.
+  ///
+  /// This is called once for every instruction that is added to the decoded instruction cache.
+  /// @param instr The decoded instruction.
+  /// @returns the handler index, which is stored in the decoded instruction record.
+  virtual uint16_t resolve_handler(const decoded_instr_t& instr) const;
+
+  /// @brief Called when the CPU writes to an address in a page that holds translated code.
+  /// @param addr The memory address that was written to.
+  virtual void translated_code_modified(const uint32_t addr);
+
+  /// @brief Called when all decoded instructions are invalidated.
+  virtual void flush_translations();
+
   /// @brief Append a single debug trace record to the trace file.
   /// @param trace The trace record.
   void append_debug_trace(const debug_trace_t& trace);
 
   // Debug trace file.
-  std::ofstream m_trace_file;
+  trace_writer_t m_trace_writer;
+  trace_filter_t m_trace_filter;
+
+  // Profiler (nullptr if profiling is disabled).
+  profiler_t* m_profiler = nullptr;
+
+  // Device event scheduler (nullptr if there are no devices).
+  event_scheduler_t* m_events = nullptr;
+
+  // Pre-decoded instruction cache, organized in lazily allocated pages. The pages are found
+  // through a two-level table, whose second level is also allocated lazily.
+  static const uint32_t LOG2_DECODED_PAGE_SIZE = 12u;
+  static const uint32_t DECODED_PAGE_SIZE = 1u << LOG2_DECODED_PAGE_SIZE;
+  static const uint32_t LOG2_DECODED_PAGES_PER_DIR = 10u;
+  static const uint32_t DECODED_PAGES_PER_DIR = 1u << LOG2_DECODED_PAGES_PER_DIR;
+  using decoded_page_t = std::array<decoded_instr_t, DECODED_PAGE_SIZE / 4u>;
+  using decoded_dir_t = std::array<std::unique_ptr<decoded_page_t>, DECODED_PAGES_PER_DIR>;
+  std::vector<std::unique_ptr<decoded_dir_t>> m_decoded_dirs;
+
+  // The most recently fetched decoded page (pages are only freed by flush_decoded()).
+  uint32_t m_last_page_no = ~0u;
+  decoded_page_t* m_last_page = nullptr;
+
+  /// @brief Get a decoded page (nullptr if the page has not been allocated).
+  decoded_page_t* decoded_page(const uint32_t page_no) const {
+    const uint32_t dir_no = page_no >> LOG2_DECODED_PAGES_PER_DIR;
+    if (dir_no < m_decoded_dirs.size()) {
+      const auto* dir = m_decoded_dirs[dir_no].get();
+      if (dir != nullptr) {
+        return (*dir)[page_no & (DECODED_PAGES_PER_DIR - 1u)].get();
+      }
+    }
+    return nullptr;
+  }
+
+  // Per page code flags (one byte per decoded page).
+  static const uint8_t CODE_PAGE_DECODED = 1u;     // The page has decoded instructions.
+  static const uint8_t CODE_PAGE_TRANSLATED = 2u;  // The page has translated instructions.
+  std::vector<uint8_t> m_code_pages;
+
+  // The per page flags that stores are checked against: m_code_pages for a single hart, or the
+  // flags of all harts (see code_sync_t).
+  const uint8_t* m_code_page_flags;
 
   // Memory interface.
   ram_t& m_ram;
@@ -202,11 +580,35 @@ protected:
   std::array<vreg_t, NUM_VECTOR_REGS> m_vregs;
 
   // Run stats.
-  uint32_t m_fetched_instr_count;
-  uint32_t m_vector_loop_count;
-  uint32_t m_total_cycle_count;
+  uint64_t m_fetched_instr_count;
+  uint64_t m_vector_loop_count;
+  uint64_t m_total_cycle_count;
+  uint64_t m_decoded_hit_count;
+
+  // Instruction mix statistics (only collected when enabled).
+  bool m_instr_mix_enabled = false;
+  instr_mix_t m_instr_mix;
 
   std::atomic_bool m_terminate_requested;
+
+  // Hart identity.
+  uint32_t m_hart_id = 0u;
+  uint32_t m_num_harts = 1u;
+
+  // Code invalidation between harts (nullptr for a single hart).
+  code_sync_t* m_code_sync = nullptr;
+  std::vector<uint32_t> m_forwarded_stores;
+
+private:
+  template <typename V>
+  static uint32_t execute_alu_simd(const uint32_t ex_op,
+                                   const uint32_t packed_mode,
+                                   uint32_t* dst,
+                                   const uint32_t* src_a,
+                                   const uint32_t* src_b,
+                                   const uint32_t scalar_b,
+                                   const uint32_t count,
+                                   const uint32_t start);
 };
 
 #endif  // SIM_CPU_HPP_
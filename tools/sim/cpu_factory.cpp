@@ -0,0 +1,118 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#include "cpu_factory.hpp"
+
+#include "config.hpp"
+#include "cpu_fast.hpp"
+#include "cpu_rec.hpp"
+#include "cpu_simple.hpp"
+
+#ifdef ENABLE_JIT
+#include "cpu_jit.hpp"
+#endif
+
+#include <iostream>
+
+namespace {
+const char* cpu_type_name(const config_t::cpu_type_t cpu_type) {
+  switch (cpu_type) {
+    case config_t::cpu_type_t::FAST:
+      return "fast";
+    case config_t::cpu_type_t::JIT:
+      return "jit";
+    case config_t::cpu_type_t::REC:
+      return "rec";
+    default:
+      return "simple";
+  }
+}
+}  // namespace
+
+std::unique_ptr<cpu_t> create_cpu(ram_t& ram) {
+  auto cpu_type = config_t::instance().cpu_type();
+
+  // Only the simple CPU implementation supports debug traces.
+  if (cpu_type != config_t::cpu_type_t::SIMPLE && config_t::instance().trace_enabled()) {
+    std::cerr << "Warning: The " << cpu_type_name(cpu_type)
+              << " CPU does not support tracing. Using the simple CPU.\n";
+    cpu_type = config_t::cpu_type_t::SIMPLE;
+  }
+
+  // Only the simple CPU implementation supports profiling.
+  if (cpu_type != config_t::cpu_type_t::SIMPLE && config_t::instance().profile_enabled()) {
+    std::cerr << "Warning: The " << cpu_type_name(cpu_type)
+              << " CPU does not support profiling. Using the simple CPU.\n";
+    cpu_type = config_t::cpu_type_t::SIMPLE;
+  }
+
+  // Only the simple CPU implementation has timing and cache models.
+  const bool cache_enabled =
+      !config_t::instance().icache_spec().empty() || !config_t::instance().dcache_spec().empty();
+  if (cpu_type != config_t::cpu_type_t::SIMPLE &&
+      (config_t::instance().timing_enabled() || cache_enabled)) {
+    std::cerr << "Warning: The " << cpu_type_name(cpu_type)
+              << " CPU does not support timing or cache models. Using the simple CPU.\n";
+    cpu_type = config_t::cpu_type_t::SIMPLE;
+  }
+
+  // Only the simple CPU implementation collects branch predictor statistics.
+  if (cpu_type != config_t::cpu_type_t::SIMPLE && config_t::instance().branch_stats_enabled()) {
+    std::cerr << "Warning: The " << cpu_type_name(cpu_type)
+              << " CPU does not collect branch statistics. Using the simple CPU.\n";
+    cpu_type = config_t::cpu_type_t::SIMPLE;
+  }
+
+  // Only the simple CPU implementation collects instruction mix statistics.
+  if (cpu_type != config_t::cpu_type_t::SIMPLE && config_t::instance().instr_mix_enabled()) {
+    std::cerr << "Warning: The " << cpu_type_name(cpu_type)
+              << " CPU does not collect instruction mix statistics. Using the simple CPU.\n";
+    cpu_type = config_t::cpu_type_t::SIMPLE;
+  }
+
+#ifndef ENABLE_JIT
+  if (cpu_type == config_t::cpu_type_t::JIT) {
+    std::cerr << "Warning: The jit CPU is not supported on this host. Using the fast CPU.\n";
+    cpu_type = config_t::cpu_type_t::FAST;
+  }
+#endif
+
+  if (cpu_type == config_t::cpu_type_t::REC && cpu_rec_t::program() == nullptr) {
+    std::cerr << "Warning: No recompiled program was built into the simulator. Using the fast "
+                 "CPU.\n";
+    cpu_type = config_t::cpu_type_t::FAST;
+  }
+
+  // Remember the selected implementation, so that any warnings are only printed once (e.g. when
+  // creating several harts).
+  config_t::instance().set_cpu_type(cpu_type);
+
+  switch (cpu_type) {
+#ifdef ENABLE_JIT
+    case config_t::cpu_type_t::JIT:
+      return std::unique_ptr<cpu_t>(new cpu_jit_t(ram));
+#endif
+    case config_t::cpu_type_t::REC:
+      return std::unique_ptr<cpu_t>(new cpu_rec_t(ram));
+    case config_t::cpu_type_t::FAST:
+      return std::unique_ptr<cpu_t>(new cpu_fast_t(ram));
+    default:
+      return std::unique_ptr<cpu_t>(new cpu_simple_t(ram));
+  }
+}
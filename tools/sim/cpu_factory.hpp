@@ -0,0 +1,37 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef SIM_CPU_FACTORY_HPP_
+#define SIM_CPU_FACTORY_HPP_
+
+#include "cpu.hpp"
+#include "ram.hpp"
+
+#include <memory>
+
+/// @brief Create a CPU instance.
+///
+/// The CPU implementation is selected by the configuration. If the selected implementation does
+/// not support the requested features (or the host machine), a compatible implementation is used
+/// instead.
+/// @param ram The RAM to use for the CPU instance.
+/// @returns a new CPU instance.
+std::unique_ptr<cpu_t> create_cpu(ram_t& ram);
+
+#endif  // SIM_CPU_FACTORY_HPP_
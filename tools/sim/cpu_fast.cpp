@@ -0,0 +1,593 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#include "cpu_fast.hpp"
+
+#include "alu_simd.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <limits>
+
+// Use computed goto ("labels as values") for dispatching handlers if the compiler supports it.
+// Otherwise fall back to a switch statement.
+#if defined(__GNUC__)
+#define CPU_FAST_COMPUTED_GOTO
+#endif
+
+// ALU operations that have specialized handlers, as (EX operation, packed mode) pairs. Operations
+// that do not support packed modes have a single entry.
+#define CPU_FAST_ALU_OPS(X)                    \
+  X(CPUID, 0)                                  \
+  X(LDHI, 0)                                   \
+  X(LDHIO, 0)                                  \
+  X(ADDPCHI, 0)                                \
+  X(OR, 0)                                     \
+  X(NOR, 0)                                    \
+  X(AND, 0)                                    \
+  X(BIC, 0)                                    \
+  X(XOR, 0)                                    \
+  X(ADD, 0) X(ADD, 1) X(ADD, 2)                \
+  X(SUB, 0) X(SUB, 1) X(SUB, 2)                \
+  X(SEQ, 0) X(SEQ, 1) X(SEQ, 2)                \
+  X(SNE, 0) X(SNE, 1) X(SNE, 2)                \
+  X(SLT, 0) X(SLT, 1) X(SLT, 2)                \
+  X(SLTU, 0) X(SLTU, 1) X(SLTU, 2)             \
+  X(SLE, 0) X(SLE, 1) X(SLE, 2)                \
+  X(SLEU, 0) X(SLEU, 1) X(SLEU, 2)             \
+  X(MIN, 0) X(MIN, 1) X(MIN, 2)                \
+  X(MAX, 0) X(MAX, 1) X(MAX, 2)                \
+  X(MINU, 0) X(MINU, 1) X(MINU, 2)             \
+  X(MAXU, 0) X(MAXU, 1) X(MAXU, 2)             \
+  X(ASR, 0) X(ASR, 1) X(ASR, 2)                \
+  X(LSL, 0) X(LSL, 1) X(LSL, 2)                \
+  X(LSR, 0) X(LSR, 1) X(LSR, 2)                \
+  X(SHUF, 0)                                   \
+  X(CLZ, 0) X(CLZ, 1) X(CLZ, 2)                \
+  X(REV, 0) X(REV, 1) X(REV, 2)                \
+  X(PACKB, 0)                                  \
+  X(PACKH, 0)                                  \
+  X(ADDS, 0) X(ADDS, 1) X(ADDS, 2)             \
+  X(ADDSU, 0) X(ADDSU, 1) X(ADDSU, 2)          \
+  X(ADDH, 0) X(ADDH, 1) X(ADDH, 2)             \
+  X(ADDHU, 0) X(ADDHU, 1) X(ADDHU, 2)          \
+  X(SUBS, 0) X(SUBS, 1) X(SUBS, 2)             \
+  X(SUBSU, 0) X(SUBSU, 1) X(SUBSU, 2)          \
+  X(SUBH, 0) X(SUBH, 1) X(SUBH, 2)             \
+  X(SUBHU, 0) X(SUBHU, 1) X(SUBHU, 2)          \
+  X(MULQ, 0) X(MULQ, 1) X(MULQ, 2)             \
+  X(MUL, 0) X(MUL, 1) X(MUL, 2)                \
+  X(MULHI, 0) X(MULHI, 1) X(MULHI, 2)          \
+  X(MULHIU, 0) X(MULHIU, 1) X(MULHIU, 2)       \
+  X(DIV, 0) X(DIV, 1) X(DIV, 2)                \
+  X(DIVU, 0) X(DIVU, 1) X(DIVU, 2)             \
+  X(REM, 0) X(REM, 1) X(REM, 2)                \
+  X(REMU, 0) X(REMU, 1) X(REMU, 2)             \
+  X(ITOF, 0) X(ITOF, 1) X(ITOF, 2)             \
+  X(UTOF, 0) X(UTOF, 1) X(UTOF, 2)             \
+  X(FTOI, 0) X(FTOI, 1) X(FTOI, 2)             \
+  X(FTOU, 0) X(FTOU, 1) X(FTOU, 2)             \
+  X(FTOIR, 0) X(FTOIR, 1) X(FTOIR, 2)          \
+  X(FTOUR, 0) X(FTOUR, 1) X(FTOUR, 2)          \
+  X(FADD, 0) X(FADD, 1) X(FADD, 2)             \
+  X(FSUB, 0) X(FSUB, 1) X(FSUB, 2)             \
+  X(FMUL, 0) X(FMUL, 1) X(FMUL, 2)             \
+  X(FDIV, 0) X(FDIV, 1) X(FDIV, 2)             \
+  X(FSQRT, 0) X(FSQRT, 1) X(FSQRT, 2)          \
+  X(FSEQ, 0) X(FSEQ, 1) X(FSEQ, 2)             \
+  X(FSNE, 0) X(FSNE, 1) X(FSNE, 2)             \
+  X(FSLT, 0) X(FSLT, 1) X(FSLT, 2)             \
+  X(FSLE, 0) X(FSLE, 1) X(FSLE, 2)             \
+  X(FSNAN, 0) X(FSNAN, 1) X(FSNAN, 2)          \
+  X(FMIN, 0) X(FMIN, 1) X(FMIN, 2)             \
+  X(FMAX, 0) X(FMAX, 1) X(FMAX, 2)
+
+// All other handlers.
+#define CPU_FAST_OTHER_HANDLERS(X)                                    \
+  X(ALU_GENERIC_RR)                                                   \
+  X(ALU_GENERIC_RI)                                                   \
+  X(ALU_GENERIC_VEC)                                                  \
+  X(LOAD8_RR) X(LOAD8_RI)                                             \
+  X(LOAD16_RR) X(LOAD16_RI)                                           \
+  X(LOAD32_RR) X(LOAD32_RI)                                           \
+  X(LOADU8_RR) X(LOADU8_RI)                                           \
+  X(LOADU16_RR) X(LOADU16_RI)                                         \
+  X(LDEA_RR) X(LDEA_RI)                                               \
+  X(STORE8_RR) X(STORE8_RI)                                           \
+  X(STORE16_RR) X(STORE16_RI)                                         \
+  X(STORE32_RR) X(STORE32_RI)                                         \
+  X(MEM_GENERIC)                                                      \
+  X(VECTOR_MEM)                                                       \
+  X(BZ) X(BNZ) X(BS) X(BNS) X(BLT) X(BGE) X(BLE) X(BGT)               \
+  X(J)                                                                \
+  X(JL)
+
+namespace {
+
+// Handler IDs. The ALU handlers come in groups of three: register + register, register +
+// immediate and vector.
+enum handler_t : uint16_t {
+#define CPU_FAST_ENUM_OTHER(name) H_##name,
+#define CPU_FAST_ENUM_ALU(op, pm) H_##op##_##pm##_RR, H_##op##_##pm##_RI, H_##op##_##pm##_VEC,
+  CPU_FAST_OTHER_HANDLERS(CPU_FAST_ENUM_OTHER) CPU_FAST_ALU_OPS(CPU_FAST_ENUM_ALU)
+#undef CPU_FAST_ENUM_ALU
+#undef CPU_FAST_ENUM_OTHER
+      NUM_HANDLERS
+};
+
+const uint16_t ALU_FORM_RR = 0u;
+const uint16_t ALU_FORM_RI = 1u;
+const uint16_t ALU_FORM_VEC = 2u;
+
+}  // namespace
+
+template <uint32_t EX_OP, uint32_t PACKED_MODE>
+void cpu_fast_t::vector_alu(uint32_t* dst,
+                            const uint32_t* src_a,
+                            const uint32_t* src_b,
+                            const uint32_t scalar_b,
+                            const uint32_t count) {
+  // Note: The elements are processed in order, which gives the same result as cpu_simple_t when
+  // the destination register is also a source register.
+  uint32_t i = execute_alu_simd(EX_OP, PACKED_MODE, dst, src_a, src_b, scalar_b, count);
+  if (src_b != nullptr) {
+    for (; i < count; ++i) {
+      dst[i] = execute_alu(EX_OP, PACKED_MODE, src_a[i], src_b[i]);
+    }
+  } else {
+    for (; i < count; ++i) {
+      dst[i] = execute_alu(EX_OP, PACKED_MODE, src_a[i], scalar_b);
+    }
+  }
+}
+
+uint16_t cpu_fast_t::resolve_handler(const decoded_instr_t& instr) const {
+  // Branches.
+  if (instr.is_bcc) {
+    return static_cast<uint16_t>(H_BZ + (instr.condition - 0x30u));
+  }
+  if (instr.is_j) {
+    return instr.is_subroutine_branch ? H_JL : H_J;
+  }
+
+  const bool is_vector_op = (instr.vector_mode != 0u);
+  const bool src_b_is_imm = instr.op_class_C || instr.op_class_D;
+
+  // Memory operations.
+  if (instr.is_mem_op) {
+    if (is_vector_op) {
+      return H_VECTOR_MEM;
+    }
+    switch (instr.mem_op) {
+      case MEM_OP_LOAD8:
+        return src_b_is_imm ? H_LOAD8_RI : H_LOAD8_RR;
+      case MEM_OP_LOAD16:
+        return src_b_is_imm ? H_LOAD16_RI : H_LOAD16_RR;
+      case MEM_OP_LOAD32:
+        return src_b_is_imm ? H_LOAD32_RI : H_LOAD32_RR;
+      case MEM_OP_LOADU8:
+        return src_b_is_imm ? H_LOADU8_RI : H_LOADU8_RR;
+      case MEM_OP_LOADU16:
+        return src_b_is_imm ? H_LOADU16_RI : H_LOADU16_RR;
+      case MEM_OP_LDEA:
+        return src_b_is_imm ? H_LDEA_RI : H_LDEA_RR;
+      case MEM_OP_STORE8:
+        return src_b_is_imm ? H_STORE8_RI : H_STORE8_RR;
+      case MEM_OP_STORE16:
+        return src_b_is_imm ? H_STORE16_RI : H_STORE16_RR;
+      case MEM_OP_STORE32:
+        return src_b_is_imm ? H_STORE32_RI : H_STORE32_RR;
+      default:
+        return H_MEM_GENERIC;
+    }
+  }
+
+  // ALU operations.
+  const uint16_t form = is_vector_op ? ALU_FORM_VEC : (src_b_is_imm ? ALU_FORM_RI : ALU_FORM_RR);
+
+  // Packed mode 3 is treated as no packed mode (see execute_alu()).
+  const uint32_t packed_mode = (instr.packed_mode == 3u) ? PACKED_NONE : instr.packed_mode;
+#define CPU_FAST_MATCH_ALU(op, pm)                          \
+  if (instr.ex_op == EX_OP_##op && packed_mode == (pm)) { \
+    return static_cast<uint16_t>(H_##op##_##pm##_RR + form); \
+  }
+  CPU_FAST_ALU_OPS(CPU_FAST_MATCH_ALU)
+#undef CPU_FAST_MATCH_ALU
+
+  // Operations that do not support packed modes ignore the packed mode.
+#define CPU_FAST_MATCH_ALU(op, pm)                        \
+  if (instr.ex_op == EX_OP_##op && (pm) == PACKED_NONE) { \
+    return static_cast<uint16_t>(H_##op##_##pm##_RR + form); \
+  }
+  CPU_FAST_ALU_OPS(CPU_FAST_MATCH_ALU)
+#undef CPU_FAST_MATCH_ALU
+
+  // Unknown operation.
+  return static_cast<uint16_t>(H_ALU_GENERIC_RR + form);
+}
+
+uint32_t cpu_fast_t::run(const int64_t max_cycles) {
+  bind_hart_to_thread();
+  m_syscalls.clear();
+  m_regs[REG_PC] = RESET_PC;
+  clear_stats();
+
+  // The RAM contents may have changed since the last run.
+  flush_decoded();
+
+  // Note: Like cpu_simple_t we always execute at least one cycle.
+  const uint64_t cycle_limit = (max_cycles >= 0)
+                                   ? static_cast<uint64_t>(std::max(max_cycles, int64_t(1)))
+                                   : std::numeric_limits<uint64_t>::max();
+
+  // Device events are serviced between calls to execute(), which stops at the next event. Vector
+  // operations are only cut short at the cycle limit of the run (see interpret()).
+  m_cycle_limit = cycle_limit;
+  try {
+    do {
+      uint64_t event_limit = cycle_limit;
+      if (m_events != nullptr) {
+        m_events->run_until(m_total_cycle_count);
+        event_limit = std::min(event_limit, m_events->next_event_cycle());
+      }
+      execute(event_limit);
+    } while (m_events != nullptr && !m_syscalls.terminate() && !m_terminate_requested &&
+             m_total_cycle_count < cycle_limit);
+  } catch (std::exception& e) {
+    throw std::runtime_error(e.what() + register_dump());
+  }
+
+  if (m_total_cycle_count >= cycle_limit) {
+    m_terminate_requested = true;
+  }
+
+  return m_syscalls.exit_code();
+}
+
+void cpu_fast_t::execute(const uint64_t cycle_limit) {
+  interpret(cycle_limit, false);
+}
+
+void cpu_fast_t::interpret(const uint64_t cycle_limit, const bool single_block) {
+  // Local copies of the run state.
+  auto* regs = m_regs.data();
+  uint32_t pc = regs[REG_PC];
+  const decoded_instr_t* d = nullptr;
+  uint64_t limit = cycle_limit;
+
+  // An interrupted vector operation can not be resumed, so vector operations may run past the
+  // cycle limit unless the run is about to end.
+  uint64_t vector_limit = m_cycle_limit;
+  uint64_t cycles = m_total_cycle_count;
+  uint64_t fetched_instr_count = m_fetched_instr_count;
+  const uint64_t first_fetched_instr_count = fetched_instr_count;
+  uint64_t vector_loop_count = m_vector_loop_count;
+  uint64_t decoded_hit_count = 0u;
+  void (*vector_alu_fn)(uint32_t*, const uint32_t*, const uint32_t*, uint32_t, uint32_t) = nullptr;
+
+  const auto update_stats = [&]() {
+    m_total_cycle_count = cycles;
+    m_fetched_instr_count = fetched_instr_count;
+    m_vector_loop_count = vector_loop_count;
+    m_decoded_hit_count += decoded_hit_count;
+    decoded_hit_count = 0u;
+  };
+
+#ifdef CPU_FAST_COMPUTED_GOTO
+#define CPU_FAST_LABEL_OTHER(name) &&L_##name,
+#define CPU_FAST_LABEL_ALU(op, pm) \
+  &&L_##op##_##pm##_RR, &&L_##op##_##pm##_RI, &&L_##op##_##pm##_VEC,
+  static const void* const s_handlers[NUM_HANDLERS] = {
+      CPU_FAST_OTHER_HANDLERS(CPU_FAST_LABEL_OTHER) CPU_FAST_ALU_OPS(CPU_FAST_LABEL_ALU)};
+#undef CPU_FAST_LABEL_ALU
+#undef CPU_FAST_LABEL_OTHER
+#define HANDLER(name) L_##name:
+#define DISPATCH() goto* s_handlers[d->handler]
+#else
+#define HANDLER(name) case H_##name:
+#define DISPATCH() goto dispatch
+#endif
+
+// Continue with the next sequential instruction. If it is in the same decoded page we can take a
+// shortcut, otherwise we go through the regular fetch logic.
+#define NEXT_INSTRUCTION()                                      \
+  do {                                                          \
+    pc += 4u;                                                   \
+    ++d;                                                        \
+    if (((pc & (DECODED_PAGE_SIZE - 1u)) == 0u) || !d->valid) { \
+      goto fetch;                                               \
+    }                                                           \
+    if (cycles >= limit) {                                      \
+      goto done;                                                \
+    }                                                           \
+    ++decoded_hit_count;                                        \
+    ++fetched_instr_count;                                      \
+    regs[REG_PC] = pc;                                          \
+    DISPATCH();                                                 \
+  } while (false)
+
+#define WRITE_SCALAR(value)    \
+  do {                         \
+    regs[d->dst_reg] = value;  \
+    regs[REG_Z] = 0u;          \
+  } while (false)
+
+#define ALU_HANDLERS(op, pm)                                                              \
+  HANDLER(op##_##pm##_RR) {                                                               \
+    WRITE_SCALAR(execute_alu(EX_OP_##op, pm, regs[d->src_reg_a], regs[d->src_reg_b]));   \
+    ++cycles;                                                                             \
+    NEXT_INSTRUCTION();                                                                   \
+  }                                                                                       \
+  HANDLER(op##_##pm##_RI) {                                                               \
+    WRITE_SCALAR(execute_alu(EX_OP_##op, pm, regs[d->src_reg_a], d->imm));                \
+    ++cycles;                                                                             \
+    NEXT_INSTRUCTION();                                                                   \
+  }                                                                                       \
+  HANDLER(op##_##pm##_VEC) {                                                              \
+    vector_alu_fn = &vector_alu<EX_OP_##op, pm>;                                          \
+    goto vector_alu_op;                                                                   \
+  }
+
+#define MEM_ADDR_RR() (regs[d->src_reg_a] + regs[d->src_reg_b] * index_scale_factor(d->packed_mode))
+#define MEM_ADDR_RI() (regs[d->src_reg_a] + d->imm)
+
+#define LOAD_HANDLER(name, form, load_fn)           \
+  HANDLER(name##_##form) {                          \
+    WRITE_SCALAR(m_ram.load_fn(MEM_ADDR_##form())); \
+    ++cycles;                                       \
+    NEXT_INSTRUCTION();                             \
+  }
+
+#define STORE_HANDLER(name, form, store_fn)        \
+  HANDLER(name##_##form) {                         \
+    const uint32_t addr = MEM_ADDR_##form();       \
+    m_ram.store_fn(addr, regs[d->src_reg_c]);      \
+    invalidate_decoded(addr);                      \
+    ++cycles;                                      \
+    NEXT_INSTRUCTION();                            \
+  }
+
+#define BRANCH_HANDLER(name, condition)                  \
+  HANDLER(name) {                                        \
+    const uint32_t x = regs[d->reg1];                    \
+    ++cycles;                                            \
+    if (condition) {                                     \
+      pc += d->imm << 2u;                                \
+      goto fetch;                                        \
+    }                                                    \
+    NEXT_INSTRUCTION();                                  \
+  }
+
+  try {
+  fetch:
+    if (single_block && fetched_instr_count != first_fetched_instr_count) {
+      goto done;
+    }
+    if (cycles >= limit || m_terminate_requested) {
+      goto done;
+    }
+    sync_code();
+
+    // Simulator routine call handling.
+    // Simulator routines start at PC = 0xffff0000.
+    if ((pc & 0xffff0000u) == 0xffff0000u) {
+      regs[REG_PC] = pc;
+      const uint32_t routine_no = (pc - 0xffff0000u) >> 2u;
+      m_syscalls.call(routine_no, m_regs, cycles);
+      invalidate_decoded(m_syscalls.written_addr(), m_syscalls.written_size());
+
+      // Simulate jmp lr.
+      pc = regs[REG_LR];
+
+      // Like cpu_simple_t, execute one more cycle before terminating.
+      if (m_syscalls.terminate()) {
+        limit = std::min(limit, cycles + 1u);
+        vector_limit = limit;
+      }
+    }
+
+    regs[REG_PC] = pc;
+    d = &fetch_decoded(pc);
+
+    // We terminate the simulation when we encounter a jump to address zero.
+    if (pc == 0x00000000u) {
+      regs[1] = 1;
+      m_syscalls.call(static_cast<uint32_t>(syscalls_t::routine_t::EXIT), m_regs, cycles);
+      limit = std::min(limit, cycles + 1u);
+      vector_limit = limit;
+    }
+
+    ++fetched_instr_count;
+    DISPATCH();
+
+#ifndef CPU_FAST_COMPUTED_GOTO
+  dispatch:
+    switch (d->handler) {
+#endif
+
+      // ALU operations.
+      CPU_FAST_ALU_OPS(ALU_HANDLERS)
+
+      HANDLER(ALU_GENERIC_RR) {
+        WRITE_SCALAR(execute_alu(d->ex_op, d->packed_mode, regs[d->src_reg_a], regs[d->src_reg_b]));
+        ++cycles;
+        NEXT_INSTRUCTION();
+      }
+
+      HANDLER(ALU_GENERIC_RI) {
+        WRITE_SCALAR(execute_alu(d->ex_op, d->packed_mode, regs[d->src_reg_a], d->imm));
+        ++cycles;
+        NEXT_INSTRUCTION();
+      }
+
+      HANDLER(ALU_GENERIC_VEC) {
+        vector_alu_fn = nullptr;
+        goto vector_alu_op;
+      }
+
+      // Memory operations.
+      LOAD_HANDLER(LOAD8, RR, load8signed)
+      LOAD_HANDLER(LOAD8, RI, load8signed)
+      LOAD_HANDLER(LOAD16, RR, load16signed)
+      LOAD_HANDLER(LOAD16, RI, load16signed)
+      LOAD_HANDLER(LOAD32, RR, load32)
+      LOAD_HANDLER(LOAD32, RI, load32)
+      LOAD_HANDLER(LOADU8, RR, load8)
+      LOAD_HANDLER(LOADU8, RI, load8)
+      LOAD_HANDLER(LOADU16, RR, load16)
+      LOAD_HANDLER(LOADU16, RI, load16)
+      STORE_HANDLER(STORE8, RR, store8)
+      STORE_HANDLER(STORE8, RI, store8)
+      STORE_HANDLER(STORE16, RR, store16)
+      STORE_HANDLER(STORE16, RI, store16)
+      STORE_HANDLER(STORE32, RR, store32)
+      STORE_HANDLER(STORE32, RI, store32)
+
+      HANDLER(LDEA_RR) {
+        WRITE_SCALAR(MEM_ADDR_RR());
+        ++cycles;
+        NEXT_INSTRUCTION();
+      }
+
+      HANDLER(LDEA_RI) {
+        WRITE_SCALAR(MEM_ADDR_RI());
+        ++cycles;
+        NEXT_INSTRUCTION();
+      }
+
+      HANDLER(MEM_GENERIC) {
+        // Undefined memory operations do not access memory, but the result (zero) is written to
+        // the destination register.
+        WRITE_SCALAR(0u);
+        ++cycles;
+        NEXT_INSTRUCTION();
+      }
+
+      HANDLER(VECTOR_MEM) {
+        const uint32_t vector_len = regs[REG_VL] & (2 * NUM_VECTOR_ELEMENTS - 1);
+        if (vector_len == 0u) {
+          goto vector_nop;
+        }
+        const uint32_t count =
+            static_cast<uint32_t>(std::min<uint64_t>(vector_len, vector_limit - cycles));
+
+        execute_vector_mem(*d, count);
+
+        cycles += count;
+        vector_loop_count += count - 1u;
+        if (count < vector_len) {
+          goto done;
+        }
+        NEXT_INSTRUCTION();
+      }
+
+      // Branches.
+      BRANCH_HANDLER(BZ, x == 0u)
+      BRANCH_HANDLER(BNZ, x != 0u)
+      BRANCH_HANDLER(BS, x == 0xffffffffu)
+      BRANCH_HANDLER(BNS, x != 0xffffffffu)
+      BRANCH_HANDLER(BLT, (x & 0x80000000u) != 0u)
+      BRANCH_HANDLER(BGE, (x & 0x80000000u) == 0u)
+      BRANCH_HANDLER(BLE, ((x & 0x80000000u) != 0u) || (x == 0u))
+      BRANCH_HANDLER(BGT, ((x & 0x80000000u) == 0u) && (x != 0u))
+
+      HANDLER(J) {
+        ++cycles;
+        pc = regs[d->reg1] + (d->imm << 2u);
+        goto fetch;
+      }
+
+      HANDLER(JL) {
+        const uint32_t target = regs[d->reg1] + (d->imm << 2u);
+        regs[REG_LR] = pc + 4u;
+        ++cycles;
+        pc = target;
+        goto fetch;
+      }
+
+#ifndef CPU_FAST_COMPUTED_GOTO
+    }
+#endif
+
+  vector_alu_op : {
+    const uint32_t vector_len = regs[REG_VL] & (2 * NUM_VECTOR_ELEMENTS - 1);
+    if (vector_len == 0u) {
+      goto vector_nop;
+    }
+    const uint32_t count =
+        static_cast<uint32_t>(std::min<uint64_t>(vector_len, vector_limit - cycles));
+
+    // ALU operations have no side effects, so we can skip them if the result is discarded.
+    if (d->dst_reg != REG_Z) {
+      uint32_t* dst = m_vregs[d->dst_reg].data();
+      const uint32_t* src_a = m_vregs[d->src_reg_a].data();
+      const uint32_t* src_b = nullptr;
+      uint32_t scalar_b = 0u;
+      if ((d->vector_mode & 1u) != 0u) {
+        // Folding operations read the upper part of the source vector register.
+        src_b = m_vregs[d->src_reg_b].data() + (d->vector_mode == 1u ? regs[REG_VL] : 0u);
+      } else {
+        scalar_b = (d->op_class_C || d->op_class_D) ? d->imm : regs[d->src_reg_b];
+      }
+      if (vector_alu_fn != nullptr) {
+        vector_alu_fn(dst, src_a, src_b, scalar_b, count);
+      } else {
+        for (uint32_t i = 0u; i < count; ++i) {
+          dst[i] = execute_alu(
+              d->ex_op, d->packed_mode, src_a[i], src_b != nullptr ? src_b[i] : scalar_b);
+        }
+      }
+    }
+
+    cycles += count;
+    vector_loop_count += count - 1u;
+    if (count < vector_len) {
+      goto done;
+    }
+    NEXT_INSTRUCTION();
+  }
+
+  vector_nop:
+    // A vector operation with zero length is a no-op that does not consume any cycles.
+    if (m_syscalls.terminate() || m_terminate_requested) {
+      pc += 4u;
+      goto done;
+    }
+    NEXT_INSTRUCTION();
+
+  done:
+    regs[REG_PC] = pc;
+    update_stats();
+  } catch (...) {
+    update_stats();
+    throw;
+  }
+
+#undef BRANCH_HANDLER
+#undef STORE_HANDLER
+#undef LOAD_HANDLER
+#undef MEM_ADDR_RI
+#undef MEM_ADDR_RR
+#undef ALU_HANDLERS
+#undef WRITE_SCALAR
+#undef NEXT_INSTRUCTION
+#undef BEGIN_INSTRUCTION
+#undef DISPATCH
+#undef HANDLER
+}
@@ -0,0 +1,70 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef SIM_CPU_FAST_HPP_
+#define SIM_CPU_FAST_HPP_
+
+#include "cpu.hpp"
+
+/// @brief A fast implementation of a CPU core.
+///
+/// This implementation is a direct-threaded interpreter. Each instruction in the decoded
+/// instruction cache is bound to a handler that is specialized for its operation (e.g. the EX
+/// operation and packed mode), and the handlers jump directly to one another without going through
+/// any pipeline stages. The architectural state and the run stats are identical to those of
+/// cpu_simple_t, but no debug trace is produced.
+class cpu_fast_t : public cpu_t {
+public:
+  /// @brief Constructor for cpu_fast_t.
+  ///
+  /// @param ram The RAM to use for this CPU instance.
+  cpu_fast_t(ram_t& ram) : cpu_t(ram) {
+  }
+
+  uint32_t run(const int64_t max_cycles) override;
+
+protected:
+  uint16_t resolve_handler(const decoded_instr_t& instr) const override;
+
+  /// @brief Execute instructions, starting at the current PC.
+  ///
+  /// Execution continues until the program terminates, until termination is requested or until
+  /// the cycle count reaches @c cycle_limit.
+  /// @param cycle_limit Stop when the total cycle count reaches this value.
+  virtual void execute(const uint64_t cycle_limit);
+
+  /// @brief Interpret instructions, starting at the current PC.
+  /// @param cycle_limit Stop when the total cycle count reaches this value.
+  /// @param single_block Stop before the first non-sequential instruction fetch (e.g. after a
+  /// taken branch or when crossing a decoded page boundary).
+  void interpret(const uint64_t cycle_limit, const bool single_block);
+
+  // The cycle limit of the current run.
+  uint64_t m_cycle_limit = 0u;
+
+private:
+  template <uint32_t EX_OP, uint32_t PACKED_MODE>
+  static void vector_alu(uint32_t* dst,
+                         const uint32_t* src_a,
+                         const uint32_t* src_b,
+                         const uint32_t scalar_b,
+                         const uint32_t count);
+};
+
+#endif  // SIM_CPU_FAST_HPP_
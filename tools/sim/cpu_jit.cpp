@@ -0,0 +1,914 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#include "cpu_jit.hpp"
+
+#include "alu.hpp"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+// Register usage in translated code:
+//   rbx - Pointer to the guest scalar registers (m_regs).
+//   rbp - Pointer to the context.
+//   r12 - Remaining cycle budget.
+//   r13 - Pointer to the guest RAM.
+//   r14 - Size of the guest RAM.
+//   r15 - Pointer to the per page code flags (m_code_page_flags).
+//   rax, rcx, rdx, rsi, rdi - Scratch registers.
+//
+// All of the pinned registers are callee saved in the System V AMD64 ABI, so we can call C++
+// helper functions from translated code without saving any state.
+
+struct cpu_jit_t::context_t {
+  uint32_t* regs;             // Guest scalar registers.
+  uint8_t* ram;               // Guest RAM.
+  uint64_t ram_size;          // Size of the guest RAM.
+  const uint8_t* code_pages;  // Per page code flags.
+  int64_t budget;             // Remaining cycle budget.
+  cpu_jit_t* cpu;             // The CPU instance (for helper calls).
+  uint32_t next_pc;           // PC to continue at (set on exit).
+  uint32_t exit_reason;       // Why the translated code exited (set on exit).
+  uint8_t* exit_slot;         // Chainable jump that caused the exit, or nullptr (set on exit).
+};
+
+namespace {
+
+// Reasons for exiting from translated code.
+const uint32_t EXIT_CONTINUE = 0u;   // Continue at next_pc (possibly chaining exit_slot).
+const uint32_t EXIT_INTERPRET = 1u;  // Interpret the instruction at next_pc (e.g. memory fault).
+const uint32_t EXIT_BUDGET = 2u;     // Not enough cycle budget for the block at next_pc.
+
+// Context offsets, as used by the trampolines.
+const uint8_t CTX_REGS = 0u;
+const uint8_t CTX_RAM = 8u;
+const uint8_t CTX_RAM_SIZE = 16u;
+const uint8_t CTX_CODE_PAGES = 24u;
+const uint8_t CTX_BUDGET = 32u;
+const uint8_t CTX_CPU = 40u;
+const uint8_t CTX_NEXT_PC = 48u;
+const uint8_t CTX_EXIT_REASON = 52u;
+const uint8_t CTX_EXIT_SLOT = 56u;
+
+// Host registers (only the low eight registers are used as operands).
+enum host_reg_t : uint8_t { RAX = 0u, RCX = 1u, RDX = 2u, RSI = 6u, RDI = 7u };
+
+// Host condition codes.
+enum cond_t : uint8_t {
+  CC_B = 0x2u,
+  CC_AE = 0x3u,
+  CC_E = 0x4u,
+  CC_NE = 0x5u,
+  CC_BE = 0x6u,
+  CC_A = 0x7u,
+  CC_S = 0x8u,
+  CC_NS = 0x9u,
+  CC_L = 0xcu,
+  CC_GE = 0xdu,
+  CC_LE = 0xeu,
+  CC_G = 0xfu
+};
+
+// Host ALU operations ("op r/m32, r32" opcodes and "op r/m32, imm32" extensions).
+const uint8_t OP_ADD = 0x01u;
+const uint8_t OP_OR = 0x09u;
+const uint8_t OP_AND = 0x21u;
+const uint8_t OP_SUB = 0x29u;
+const uint8_t OP_XOR = 0x31u;
+const uint8_t OP_CMP = 0x39u;
+const uint8_t EXT_ADD = 0u;
+const uint8_t EXT_OR = 1u;
+const uint8_t EXT_CMP = 7u;
+
+// Host shift operations (opcode extensions).
+const uint8_t SHIFT_SHL = 4u;
+const uint8_t SHIFT_SHR = 5u;
+const uint8_t SHIFT_SAR = 7u;
+
+/// @brief A minimal x86-64 machine code emitter.
+class emitter_t {
+public:
+  emitter_t(uint8_t* ptr, const uint8_t* end) : m_ptr(ptr), m_end(end) {
+  }
+
+  uint8_t* pos() const {
+    return m_ptr;
+  }
+
+  bool overflow() const {
+    return m_overflow;
+  }
+
+  void u8(const uint32_t x) {
+    if (m_ptr < m_end) {
+      *m_ptr++ = static_cast<uint8_t>(x);
+    } else {
+      m_overflow = true;
+    }
+  }
+
+  void u32(const uint32_t x) {
+    for (int i = 0; i < 4; ++i) {
+      u8(x >> (8 * i));
+    }
+  }
+
+  void u64(const uint64_t x) {
+    u32(static_cast<uint32_t>(x));
+    u32(static_cast<uint32_t>(x >> 32));
+  }
+
+  void bytes(const std::initializer_list<uint8_t> x) {
+    for (auto b : x) {
+      u8(b);
+    }
+  }
+
+  // mov r32, imm32
+  void mov_imm(const host_reg_t r, const uint32_t imm) {
+    if (imm == 0u) {
+      alu_rr(OP_XOR, r, r);
+    } else {
+      u8(0xb8u + r);
+      u32(imm);
+    }
+  }
+
+  // mov r64, imm64
+  void mov_imm64(const host_reg_t r, const uint64_t imm) {
+    u8(0x48u);
+    u8(0xb8u + r);
+    u64(imm);
+  }
+
+  // mov r32, [rbx + 4 * guest_reg]
+  void load_guest(const host_reg_t r, const uint32_t guest_reg) {
+    bytes({0x8bu, static_cast<uint8_t>(0x43u | (r << 3)), static_cast<uint8_t>(4u * guest_reg)});
+  }
+
+  // mov [rbx + 4 * guest_reg], r32
+  void store_guest(const uint32_t guest_reg, const host_reg_t r) {
+    bytes({0x89u, static_cast<uint8_t>(0x43u | (r << 3)), static_cast<uint8_t>(4u * guest_reg)});
+  }
+
+  // mov dword [rbx + 4 * guest_reg], imm32
+  void store_guest_imm(const uint32_t guest_reg, const uint32_t imm) {
+    bytes({0xc7u, 0x43u, static_cast<uint8_t>(4u * guest_reg)});
+    u32(imm);
+  }
+
+  // op dst, src
+  void alu_rr(const uint8_t op, const host_reg_t dst, const host_reg_t src) {
+    bytes({op, static_cast<uint8_t>(0xc0u | (src << 3) | dst)});
+  }
+
+  // op r32, imm32
+  void alu_ri(const uint8_t ext, const host_reg_t r, const uint32_t imm) {
+    bytes({0x81u, static_cast<uint8_t>(0xc0u | (ext << 3) | r)});
+    u32(imm);
+  }
+
+  // mov dst, src
+  void mov_rr(const host_reg_t dst, const host_reg_t src) {
+    bytes({0x89u, static_cast<uint8_t>(0xc0u | (src << 3) | dst)});
+  }
+
+  // not r32
+  void not_r(const host_reg_t r) {
+    bytes({0xf7u, static_cast<uint8_t>(0xd0u | r)});
+  }
+
+  // neg r32
+  void neg_r(const host_reg_t r) {
+    bytes({0xf7u, static_cast<uint8_t>(0xd8u | r)});
+  }
+
+  // test a, b
+  void test_rr(const host_reg_t a, const host_reg_t b) {
+    bytes({0x85u, static_cast<uint8_t>(0xc0u | (b << 3) | a)});
+  }
+
+  // imul dst, src
+  void imul_rr(const host_reg_t dst, const host_reg_t src) {
+    bytes({0x0fu, 0xafu, static_cast<uint8_t>(0xc0u | (dst << 3) | src)});
+  }
+
+  // shl/shr/sar r32, cl
+  void shift_cl(const uint8_t ext, const host_reg_t r) {
+    bytes({0xd3u, static_cast<uint8_t>(0xc0u | (ext << 3) | r)});
+  }
+
+  // shl/shr/sar r32, imm8
+  void shift_imm(const uint8_t ext, const host_reg_t r, const uint8_t count) {
+    bytes({0xc1u, static_cast<uint8_t>(0xc0u | (ext << 3) | r), count});
+  }
+
+  // cmov<cc> dst, src
+  void cmov(const cond_t cc, const host_reg_t dst, const host_reg_t src) {
+    bytes({0x0fu,
+           static_cast<uint8_t>(0x40u | cc),
+           static_cast<uint8_t>(0xc0u | (dst << 3) | src)});
+  }
+
+  // eax = cc ? 0xffffffff : 0
+  void set_mask(const cond_t cc) {
+    bytes({0x0fu, static_cast<uint8_t>(0x90u | cc), 0xc0u});  // set<cc> al
+    bytes({0x0fu, 0xb6u, 0xc0u});                             // movzx eax, al
+    neg_r(RAX);
+  }
+
+  // add/sub/cmp r12, imm32
+  void add_r12(const uint32_t imm) {
+    bytes({0x49u, 0x81u, 0xc4u});
+    u32(imm);
+  }
+  void sub_r12(const uint32_t imm) {
+    bytes({0x49u, 0x81u, 0xecu});
+    u32(imm);
+  }
+  void cmp_r12(const uint32_t imm) {
+    bytes({0x49u, 0x81u, 0xfcu});
+    u32(imm);
+  }
+
+  // j<cc> rel32 (returns the location of the rel32 field, for patching).
+  uint8_t* jcc(const cond_t cc) {
+    bytes({0x0fu, static_cast<uint8_t>(0x80u | cc)});
+    u32(0u);
+    return m_ptr - 4;
+  }
+
+  // jmp rel32 (returns the location of the rel32 field, for patching).
+  uint8_t* jmp() {
+    u8(0xe9u);
+    u32(0u);
+    return m_ptr - 4;
+  }
+
+  void jmp_to(const uint8_t* target) {
+    patch(jmp(), target);
+  }
+
+  // mov rax, imm64; call rax
+  void call(const void* fn) {
+    mov_imm64(RAX, reinterpret_cast<uint64_t>(fn));
+    bytes({0xffu, 0xd0u});
+  }
+
+  /// @brief Set the target of a rel32 jump.
+  void patch(uint8_t* field, const uint8_t* target) {
+    if (!m_overflow) {
+      patch_rel32(field, target);
+    }
+  }
+
+  static void patch_rel32(uint8_t* field, const uint8_t* target) {
+    const auto rel = static_cast<int32_t>(target - (field + 4));
+    std::memcpy(field, &rel, sizeof(rel));
+  }
+
+private:
+  uint8_t* m_ptr;
+  const uint8_t* m_end;
+  bool m_overflow = false;
+};
+
+}  // namespace
+
+cpu_jit_t::cpu_jit_t(ram_t& ram) : cpu_fast_t(ram) {
+  void* code = mmap(nullptr,
+                    CODE_CACHE_SIZE,
+                    PROT_READ | PROT_WRITE | PROT_EXEC,
+                    MAP_PRIVATE | MAP_ANONYMOUS,
+                    -1,
+                    0);
+  if (code != MAP_FAILED) {
+    m_code = static_cast<uint8_t*>(code);
+    generate_trampolines();
+  }
+}
+
+cpu_jit_t::~cpu_jit_t() {
+  if (m_code != nullptr) {
+    munmap(m_code, CODE_CACHE_SIZE);
+  }
+}
+
+void cpu_jit_t::dump_stats() {
+  cpu_fast_t::dump_stats();
+
+  const double native_ratio =
+      static_cast<double>(m_native_instr_count) / static_cast<double>(m_fetched_instr_count);
+  std::cout << " Translated blocks:    " << m_translated_block_count << " ("
+            << m_translated_instr_count << " instructions)\n";
+  std::cout << " Native instructions:  " << m_native_instr_count << " (" << (100.0 * native_ratio)
+            << "%)\n";
+  std::cout << " Code cache flushes:   " << m_code_cache_flush_count << "\n";
+}
+
+void cpu_jit_t::write_stats(json_writer_t& json) const {
+  cpu_fast_t::write_stats(json);
+  json.value("translated_blocks", m_translated_block_count);
+  json.value("translated_instructions", m_translated_instr_count);
+  json.value("native_instructions", m_native_instr_count);
+  json.value("code_cache_flushes", m_code_cache_flush_count);
+}
+
+void cpu_jit_t::execute(const uint64_t cycle_limit) {
+  // Without an executable code cache we can only interpret.
+  if (m_code == nullptr) {
+    interpret(cycle_limit, false);
+    return;
+  }
+
+  static_assert(offsetof(context_t, regs) == CTX_REGS, "Bad context layout");
+  static_assert(offsetof(context_t, ram) == CTX_RAM, "Bad context layout");
+  static_assert(offsetof(context_t, ram_size) == CTX_RAM_SIZE, "Bad context layout");
+  static_assert(offsetof(context_t, code_pages) == CTX_CODE_PAGES, "Bad context layout");
+  static_assert(offsetof(context_t, budget) == CTX_BUDGET, "Bad context layout");
+  static_assert(offsetof(context_t, cpu) == CTX_CPU, "Bad context layout");
+  static_assert(offsetof(context_t, next_pc) == CTX_NEXT_PC, "Bad context layout");
+  static_assert(offsetof(context_t, exit_reason) == CTX_EXIT_REASON, "Bad context layout");
+  static_assert(offsetof(context_t, exit_slot) == CTX_EXIT_SLOT, "Bad context layout");
+
+  context_t ctx;
+  ctx.regs = m_regs.data();
+  ctx.ram = m_ram.data();
+  ctx.ram_size = m_ram.direct_size();
+  ctx.code_pages = m_code_page_flags;
+  ctx.budget = 0;
+  ctx.cpu = this;
+  ctx.next_pc = 0u;
+  ctx.exit_reason = EXIT_CONTINUE;
+  ctx.exit_slot = nullptr;
+
+  // The chainable jump that caused the last exit (if any).
+  uint8_t* chain_slot = nullptr;
+  uint32_t chain_generation = 0u;
+
+  while (!m_syscalls.terminate() && !m_terminate_requested &&
+         m_total_cycle_count < cycle_limit) {
+    sync_code();
+    if (m_flush_pending) {
+      flush_code_cache();
+    }
+
+    const uint8_t* block = get_block(m_regs[REG_PC]);
+    if (block == nullptr) {
+      chain_slot = nullptr;
+      interpret(cycle_limit, true);
+      continue;
+    }
+
+    // Chain the previous block to this block, unless the code cache was flushed in between. With
+    // several harts, blocks are not chained so that code modified by other harts is noticed here.
+    if (chain_slot != nullptr && chain_generation == m_code_generation && m_code_sync == nullptr) {
+      emitter_t::patch_rel32(chain_slot, block);
+    }
+    chain_slot = nullptr;
+
+    // Run translated code until we exit from it.
+    const uint64_t cycles_left = cycle_limit - m_total_cycle_count;
+    const int64_t budget = static_cast<int64_t>(std::min<uint64_t>(cycles_left, MAX_BUDGET));
+    ctx.budget = budget;
+    m_enter(&ctx, block);
+
+    // Each translated instruction takes exactly one cycle.
+    const uint32_t executed = static_cast<uint32_t>(budget - ctx.budget);
+    m_total_cycle_count += executed;
+    m_fetched_instr_count += executed;
+    m_native_instr_count += executed;
+    m_regs[REG_PC] = ctx.next_pc;
+
+    if (ctx.exit_reason == EXIT_CONTINUE) {
+      chain_slot = ctx.exit_slot;
+      chain_generation = m_code_generation;
+    } else {
+      interpret(cycle_limit, true);
+    }
+  }
+}
+
+void cpu_jit_t::translated_code_modified(const uint32_t addr) {
+  const auto it = m_translated_words.find(addr >> LOG2_DECODED_PAGE_SIZE);
+  if (it != m_translated_words.end() && it->second.test((addr & (DECODED_PAGE_SIZE - 1u)) >> 2u)) {
+    m_flush_pending = true;
+  }
+}
+
+void cpu_jit_t::flush_translations() {
+  m_flush_pending = true;
+}
+
+bool cpu_jit_t::can_translate(const decoded_instr_t& instr) {
+  // Vector operations are left to the interpreter.
+  if (instr.vector_mode != 0u) {
+    return false;
+  }
+
+  if (instr.is_mem_op) {
+    switch (instr.mem_op) {
+      case MEM_OP_LOAD8:
+      case MEM_OP_LOAD16:
+      case MEM_OP_LOAD32:
+      case MEM_OP_LOADU8:
+      case MEM_OP_LOADU16:
+      case MEM_OP_LDEA:
+      case MEM_OP_STORE8:
+      case MEM_OP_STORE16:
+      case MEM_OP_STORE32:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  // All scalar ALU operations and branches can be translated.
+  return true;
+}
+
+void cpu_jit_t::generate_trampolines() {
+  emitter_t e(m_code, m_code + CODE_CACHE_SIZE);
+
+  // void enter(context_t* ctx, const uint8_t* block)
+  m_enter = reinterpret_cast<void (*)(context_t*, const uint8_t*)>(e.pos());
+  e.bytes({0x53u, 0x55u, 0x41u, 0x54u, 0x41u, 0x55u, 0x41u, 0x56u, 0x41u, 0x57u});  // push ...
+  e.bytes({0x48u, 0x83u, 0xecu, 0x08u});                                          // sub rsp, 8
+  e.bytes({0x48u, 0x89u, 0xfdu});                                                 // mov rbp, rdi
+  e.bytes({0x48u, 0x8bu, 0x5du, CTX_REGS});        // mov rbx, [rbp + CTX_REGS]
+  e.bytes({0x4cu, 0x8bu, 0x6du, CTX_RAM});         // mov r13, [rbp + CTX_RAM]
+  e.bytes({0x4cu, 0x8bu, 0x75u, CTX_RAM_SIZE});    // mov r14, [rbp + CTX_RAM_SIZE]
+  e.bytes({0x4cu, 0x8bu, 0x7du, CTX_CODE_PAGES});  // mov r15, [rbp + CTX_CODE_PAGES]
+  e.bytes({0x4cu, 0x8bu, 0x65u, CTX_BUDGET});      // mov r12, [rbp + CTX_BUDGET]
+  e.bytes({0xffu, 0xe6u});                         // jmp rsi
+
+  // Common exit: eax = next PC, edx = exit reason, rcx = exit slot.
+  m_exit_code = e.pos();
+  e.bytes({0x89u, 0x45u, CTX_NEXT_PC});            // mov [rbp + CTX_NEXT_PC], eax
+  e.bytes({0x89u, 0x55u, CTX_EXIT_REASON});        // mov [rbp + CTX_EXIT_REASON], edx
+  e.bytes({0x48u, 0x89u, 0x4du, CTX_EXIT_SLOT});   // mov [rbp + CTX_EXIT_SLOT], rcx
+  e.bytes({0x4cu, 0x89u, 0x65u, CTX_BUDGET});      // mov [rbp + CTX_BUDGET], r12
+  e.bytes({0x48u, 0x83u, 0xc4u, 0x08u});           // add rsp, 8
+  e.bytes({0x41u, 0x5fu, 0x41u, 0x5eu, 0x41u, 0x5du, 0x41u, 0x5cu, 0x5du, 0x5bu});  // pop ...
+  e.u8(0xc3u);                                                                    // ret
+
+  m_code_ptr = e.pos();
+}
+
+const uint8_t* cpu_jit_t::get_block(const uint32_t pc) {
+  const auto it = m_blocks.find(pc);
+  if (it != m_blocks.end()) {
+    return it->second;
+  }
+  const uint8_t* block = translate_block(pc);
+  m_blocks[pc] = block;
+  return block;
+}
+
+const uint8_t* cpu_jit_t::translate_block(const uint32_t block_pc) {
+  // Never translate simulator routines or the program exit address (PC = 0).
+  if (block_pc == 0x00000000u || (block_pc & 0xffff0000u) == 0xffff0000u || (block_pc & 3u) != 0u ||
+      !m_ram.valid_range(block_pc, 4u)) {
+    return nullptr;
+  }
+
+  // Make room for the block first, since flushing the code cache clears the translation marks.
+  if (static_cast<size_t>((m_code + CODE_CACHE_SIZE) - m_code_ptr) < MAX_BLOCK_CODE_SIZE) {
+    flush_code_cache();
+  }
+
+  // Collect the instructions of the block. All inspected instruction words are marked as
+  // translated so that we detect if they are modified.
+  std::vector<decoded_instr_t> instrs;
+  uint32_t pc = block_pc;
+  while (instrs.size() < MAX_BLOCK_INSTRS && pc != 0x00000000u &&
+         (pc & 0xffff0000u) != 0xffff0000u && m_ram.valid_range(pc, 4u)) {
+    const uint32_t page_no = pc >> LOG2_DECODED_PAGE_SIZE;
+    mark_code_page(page_no, CODE_PAGE_TRANSLATED);
+    m_translated_words[page_no].set((pc & (DECODED_PAGE_SIZE - 1u)) >> 2u);
+
+    const auto instr = decode(m_ram.load32(pc));
+    if (!can_translate(instr)) {
+      break;
+    }
+    instrs.push_back(instr);
+    pc += 4u;
+
+    // End the block at branches and decoded page boundaries.
+    if (instr.is_bcc || instr.is_j || (pc & (DECODED_PAGE_SIZE - 1u)) == 0u) {
+      break;
+    }
+  }
+  if (instrs.empty()) {
+    return nullptr;
+  }
+
+  emitter_t e(m_code_ptr, m_code_ptr + MAX_BLOCK_CODE_SIZE);
+  const uint8_t* exit_code = m_exit_code;
+  const uint8_t* block = e.pos();
+  const auto num_instrs = static_cast<uint32_t>(instrs.size());
+
+  // Load a guest register into a host register.
+  const auto load_reg = [&e](const host_reg_t r, const uint32_t reg, const uint32_t ipc) {
+    if (reg == REG_Z) {
+      e.mov_imm(r, 0u);
+    } else if (reg == REG_PC) {
+      e.mov_imm(r, ipc);
+    } else {
+      e.load_guest(r, reg);
+    }
+  };
+
+  // Exit with a constant PC.
+  const auto emit_exit = [&e, exit_code](const uint32_t next_pc, const uint32_t reason) {
+    e.mov_imm(RAX, next_pc);
+    e.mov_imm(RDX, reason);
+    e.mov_imm(RCX, 0u);
+    e.jmp_to(exit_code);
+  };
+
+  // Exit to a constant PC through a jump that can later be patched to go directly to the target
+  // block.
+  const auto emit_chain_exit = [&e, exit_code](const uint32_t next_pc) {
+    uint8_t* slot = e.jmp();
+    e.patch(slot, e.pos());
+    e.mov_imm(RAX, next_pc);
+    e.mov_imm(RDX, EXIT_CONTINUE);
+    e.mov_imm64(RCX, reinterpret_cast<uint64_t>(slot));
+    e.jmp_to(exit_code);
+  };
+
+  // Out of line code for faulting memory accesses and stores to code pages.
+  struct stub_t {
+    uint8_t* jump;
+    uint8_t* resume;
+    uint32_t index;
+  };
+  std::vector<stub_t> fault_stubs;
+  std::vector<stub_t> code_store_stubs;
+
+  // Check the cycle budget for the entire block up front.
+  e.cmp_r12(num_instrs);
+  uint8_t* budget_jump = e.jcc(CC_L);
+  e.sub_r12(num_instrs);
+
+  for (uint32_t k = 0u; k < num_instrs; ++k) {
+    const auto& d = instrs[k];
+    const uint32_t ipc = block_pc + 4u * k;
+    const bool src_b_is_imm = d.op_class_C || d.op_class_D;
+
+    if (d.is_bcc) {
+      load_reg(RAX, d.reg1, ipc);
+      cond_t cc;
+      switch (d.condition) {
+        case 0x30u:  // bz
+          e.test_rr(RAX, RAX);
+          cc = CC_E;
+          break;
+        case 0x31u:  // bnz
+          e.test_rr(RAX, RAX);
+          cc = CC_NE;
+          break;
+        case 0x32u:  // bs
+          e.alu_ri(EXT_CMP, RAX, 0xffffffffu);
+          cc = CC_E;
+          break;
+        case 0x33u:  // bns
+          e.alu_ri(EXT_CMP, RAX, 0xffffffffu);
+          cc = CC_NE;
+          break;
+        case 0x34u:  // blt
+          e.test_rr(RAX, RAX);
+          cc = CC_S;
+          break;
+        case 0x35u:  // bge
+          e.test_rr(RAX, RAX);
+          cc = CC_NS;
+          break;
+        case 0x36u:  // ble
+          e.test_rr(RAX, RAX);
+          cc = CC_LE;
+          break;
+        default:  // bgt
+          e.test_rr(RAX, RAX);
+          cc = CC_G;
+      }
+      uint8_t* taken_jump = e.jcc(cc);
+      emit_chain_exit(ipc + 4u);
+      e.patch(taken_jump, e.pos());
+      emit_chain_exit(ipc + (d.imm << 2u));
+    } else if (d.is_j) {
+      if (d.reg1 == REG_PC || d.reg1 == REG_Z) {
+        // Direct jump.
+        const uint32_t base = (d.reg1 == REG_PC) ? ipc : 0u;
+        if (d.is_subroutine_branch) {
+          e.store_guest_imm(REG_LR, ipc + 4u);
+        }
+        emit_chain_exit(base + (d.imm << 2u));
+      } else {
+        // Indirect jump (the target block is looked up by the dispatcher).
+        e.load_guest(RAX, d.reg1);
+        if (d.imm != 0u) {
+          e.alu_ri(EXT_ADD, RAX, d.imm << 2u);
+        }
+        if (d.is_subroutine_branch) {
+          e.store_guest_imm(REG_LR, ipc + 4u);
+        }
+        e.mov_imm(RDX, EXIT_CONTINUE);
+        e.mov_imm(RCX, 0u);
+        e.jmp_to(exit_code);
+      }
+    } else if (d.is_mem_op) {
+      // Address generation: eax = a + b * scale.
+      load_reg(RAX, d.src_reg_a, ipc);
+      if (src_b_is_imm) {
+        if (d.imm != 0u) {
+          e.alu_ri(EXT_ADD, RAX, d.imm);
+        }
+      } else {
+        load_reg(RCX, d.src_reg_b, ipc);
+        // lea eax, [rax + rcx * scale]
+        e.bytes({0x8du, 0x04u, static_cast<uint8_t>((d.packed_mode << 6) | 0x08u)});
+      }
+
+      if (d.mem_op == MEM_OP_LDEA) {
+        if (d.dst_reg != REG_Z && d.dst_reg != REG_PC) {
+          e.store_guest(d.dst_reg, RAX);
+        }
+        continue;
+      }
+
+      // Range and alignment checks (like ram_t), falling back to the interpreter on failure.
+      const bool is_store = (d.mem_op >= MEM_OP_STORE8);
+      const uint32_t size = 1u << ((d.mem_op & 3u) - 1u);
+      if (size > 1u) {
+        e.bytes({0xa8u, static_cast<uint8_t>(size - 1u)});  // test al, size - 1
+        fault_stubs.push_back(stub_t{e.jcc(CC_NE), nullptr, k});
+      }
+      e.bytes({0x48u, 0x8du, 0x50u, static_cast<uint8_t>(size - 1u)});  // lea rdx, [rax + size - 1]
+      e.bytes({0x4cu, 0x39u, 0xf2u});                                    // cmp rdx, r14
+      fault_stubs.push_back(stub_t{e.jcc(CC_AE), nullptr, k});
+
+      if (is_store) {
+        load_reg(RCX, d.src_reg_c, ipc);
+        switch (d.mem_op) {
+          case MEM_OP_STORE8:
+            e.bytes({0x41u, 0x88u, 0x4cu, 0x05u, 0x00u});  // mov [r13 + rax], cl
+            break;
+          case MEM_OP_STORE16:
+            e.bytes({0x66u, 0x41u, 0x89u, 0x4cu, 0x05u, 0x00u});  // mov [r13 + rax], cx
+            break;
+          default:
+            e.bytes({0x41u, 0x89u, 0x4cu, 0x05u, 0x00u});  // mov [r13 + rax], ecx
+        }
+
+        // Stores to pages that hold decoded or translated code must invalidate the code.
+        e.mov_rr(RDX, RAX);
+        e.shift_imm(SHIFT_SHR, RDX, LOG2_DECODED_PAGE_SIZE);
+        e.bytes({0x41u, 0x80u, 0x3cu, 0x17u, 0x00u});  // cmp byte [r15 + rdx], 0
+        uint8_t* jump = e.jcc(CC_NE);
+        code_store_stubs.push_back(stub_t{jump, e.pos(), k});
+      } else {
+        switch (d.mem_op) {
+          case MEM_OP_LOAD8:
+            e.bytes({0x41u, 0x0fu, 0xbeu, 0x44u, 0x05u, 0x00u});  // movsx eax, byte [r13 + rax]
+            break;
+          case MEM_OP_LOADU8:
+            e.bytes({0x41u, 0x0fu, 0xb6u, 0x44u, 0x05u, 0x00u});  // movzx eax, byte [r13 + rax]
+            break;
+          case MEM_OP_LOAD16:
+            e.bytes({0x41u, 0x0fu, 0xbfu, 0x44u, 0x05u, 0x00u});  // movsx eax, word [r13 + rax]
+            break;
+          case MEM_OP_LOADU16:
+            e.bytes({0x41u, 0x0fu, 0xb7u, 0x44u, 0x05u, 0x00u});  // movzx eax, word [r13 + rax]
+            break;
+          default:
+            e.bytes({0x41u, 0x8bu, 0x44u, 0x05u, 0x00u});  // mov eax, [r13 + rax]
+        }
+        if (d.dst_reg != REG_Z && d.dst_reg != REG_PC) {
+          e.store_guest(d.dst_reg, RAX);
+        }
+      }
+    } else {
+      // ALU operations have no side effects, so we can skip them if the result is discarded.
+      if (d.dst_reg == REG_Z || d.dst_reg == REG_PC) {
+        continue;
+      }
+
+      load_reg(RAX, d.src_reg_a, ipc);
+      if (src_b_is_imm) {
+        e.mov_imm(RCX, d.imm);
+      } else {
+        load_reg(RCX, d.src_reg_b, ipc);
+      }
+
+      // Operations that are not packed (or that use packed mode 3) are translated inline.
+      const bool is_word = (d.packed_mode == PACKED_NONE || d.packed_mode == 3u);
+      host_reg_t result = RAX;
+      bool inlined = true;
+      switch (d.ex_op) {
+        case EX_OP_LDHI:
+          e.shift_imm(SHIFT_SHL, RCX, 11u);
+          result = RCX;
+          break;
+        case EX_OP_LDHIO:
+          e.shift_imm(SHIFT_SHL, RCX, 11u);
+          e.alu_ri(EXT_OR, RCX, 0x7ffu);
+          result = RCX;
+          break;
+        case EX_OP_ADDPCHI:
+          e.shift_imm(SHIFT_SHL, RCX, 11u);
+          e.alu_rr(OP_ADD, RAX, RCX);
+          break;
+        case EX_OP_OR:
+          e.alu_rr(OP_OR, RAX, RCX);
+          break;
+        case EX_OP_NOR:
+          e.alu_rr(OP_OR, RAX, RCX);
+          e.not_r(RAX);
+          break;
+        case EX_OP_AND:
+          e.alu_rr(OP_AND, RAX, RCX);
+          break;
+        case EX_OP_BIC:
+          e.not_r(RCX);
+          e.alu_rr(OP_AND, RAX, RCX);
+          break;
+        case EX_OP_XOR:
+          e.alu_rr(OP_XOR, RAX, RCX);
+          break;
+        default:
+          inlined = false;
+      }
+
+      if (!inlined && is_word) {
+        inlined = true;
+        switch (d.ex_op) {
+          case EX_OP_ADD:
+            e.alu_rr(OP_ADD, RAX, RCX);
+            break;
+          case EX_OP_SUB:
+            // Note: sub computes b - a.
+            e.alu_rr(OP_SUB, RCX, RAX);
+            result = RCX;
+            break;
+          case EX_OP_SEQ:
+            e.alu_rr(OP_CMP, RAX, RCX);
+            e.set_mask(CC_E);
+            break;
+          case EX_OP_SNE:
+            e.alu_rr(OP_CMP, RAX, RCX);
+            e.set_mask(CC_NE);
+            break;
+          case EX_OP_SLT:
+            e.alu_rr(OP_CMP, RAX, RCX);
+            e.set_mask(CC_L);
+            break;
+          case EX_OP_SLTU:
+            e.alu_rr(OP_CMP, RAX, RCX);
+            e.set_mask(CC_B);
+            break;
+          case EX_OP_SLE:
+            e.alu_rr(OP_CMP, RAX, RCX);
+            e.set_mask(CC_LE);
+            break;
+          case EX_OP_SLEU:
+            e.alu_rr(OP_CMP, RAX, RCX);
+            e.set_mask(CC_BE);
+            break;
+          case EX_OP_MIN:
+            e.alu_rr(OP_CMP, RAX, RCX);
+            e.cmov(CC_GE, RAX, RCX);
+            break;
+          case EX_OP_MAX:
+            e.alu_rr(OP_CMP, RAX, RCX);
+            e.cmov(CC_LE, RAX, RCX);
+            break;
+          case EX_OP_MINU:
+            e.alu_rr(OP_CMP, RAX, RCX);
+            e.cmov(CC_AE, RAX, RCX);
+            break;
+          case EX_OP_MAXU:
+            e.alu_rr(OP_CMP, RAX, RCX);
+            e.cmov(CC_BE, RAX, RCX);
+            break;
+          case EX_OP_ASR:
+            e.shift_cl(SHIFT_SAR, RAX);
+            break;
+          case EX_OP_LSL:
+            e.shift_cl(SHIFT_SHL, RAX);
+            break;
+          case EX_OP_LSR:
+            e.shift_cl(SHIFT_SHR, RAX);
+            break;
+          case EX_OP_MUL:
+            e.imul_rr(RAX, RCX);
+            break;
+          default:
+            inlined = false;
+        }
+      }
+
+      if (!inlined) {
+        // eax = alu_helper(ex_op, packed_mode, eax, ecx)
+        e.mov_rr(RDX, RAX);
+        e.mov_imm(RDI, d.ex_op);
+        e.mov_imm(RSI, d.packed_mode);
+        e.call(reinterpret_cast<const void*>(&alu_helper));
+      }
+
+      e.store_guest(d.dst_reg, result);
+    }
+  }
+
+  // Blocks that do not end with a branch continue with the next instruction.
+  const auto& last = instrs.back();
+  if (!last.is_bcc && !last.is_j) {
+    emit_chain_exit(block_pc + 4u * num_instrs);
+  }
+
+  // Out of cycle budget: let the dispatcher handle the block.
+  e.patch(budget_jump, e.pos());
+  emit_exit(block_pc, EXIT_BUDGET);
+
+  // Memory faults: Refund the cycles for the remaining instructions and let the interpreter
+  // execute (and report) the faulting instruction.
+  for (const auto& stub : fault_stubs) {
+    e.patch(stub.jump, e.pos());
+    e.add_r12(num_instrs - stub.index);
+    emit_exit(block_pc + 4u * stub.index, EXIT_INTERPRET);
+  }
+
+  // Stores to code pages: Invalidate the code, and exit if any translated code was modified.
+  for (const auto& stub : code_store_stubs) {
+    e.patch(stub.jump, e.pos());
+    e.bytes({0x48u, 0x8bu, 0x7du, CTX_CPU});  // mov rdi, [rbp + CTX_CPU]
+    e.mov_rr(RSI, RAX);
+    e.call(reinterpret_cast<const void*>(&store_helper));
+    e.test_rr(RAX, RAX);
+    e.patch(e.jcc(CC_E), stub.resume);
+    const uint32_t remaining = num_instrs - stub.index - 1u;
+    if (remaining != 0u) {
+      e.add_r12(remaining);
+    }
+    emit_exit(block_pc + 4u * (stub.index + 1u), EXIT_CONTINUE);
+  }
+
+  if (e.overflow()) {
+    throw std::runtime_error("JIT block code size exceeded");
+  }
+  m_code_ptr = e.pos();
+
+  ++m_translated_block_count;
+  m_translated_instr_count += num_instrs;
+
+  return block;
+}
+
+void cpu_jit_t::flush_code_cache() {
+  m_blocks.clear();
+  for (const auto& page : m_translated_words) {
+    m_code_pages[page.first] &= static_cast<uint8_t>(~CODE_PAGE_TRANSLATED);
+  }
+  m_translated_words.clear();
+
+  // Start over, right after the trampolines.
+  generate_trampolines();
+
+  m_flush_pending = false;
+  ++m_code_generation;
+  ++m_code_cache_flush_count;
+}
+
+uint32_t cpu_jit_t::alu_helper(const uint32_t ex_op,
+                               const uint32_t packed_mode,
+                               const uint32_t src_a,
+                               const uint32_t src_b) {
+  return execute_alu(ex_op, packed_mode, src_a, src_b);
+}
+
+uint32_t cpu_jit_t::store_helper(cpu_jit_t* cpu, const uint32_t addr) {
+  cpu->code_modified(addr);
+  return cpu->m_flush_pending ? 1u : 0u;
+}
@@ -0,0 +1,115 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef SIM_CPU_JIT_HPP_
+#define SIM_CPU_JIT_HPP_
+
+#include "cpu_fast.hpp"
+
+#include <bitset>
+#include <unordered_map>
+#include <vector>
+
+/// @brief A CPU core that translates guest code to x86-64 machine code.
+///
+/// Guest basic blocks are translated to host code the first time that they are executed, and are
+/// stored in an executable code cache. The scalar registers live in the register array of the CPU
+/// (which is pinned to a host register during execution), and blocks that end with a direct
+/// branch (b[cc], or j/jl relative to PC) are chained together so that they can jump directly to
+/// one another. Instructions that are not translated (e.g. vector operations and simulator
+/// routine calls) are executed by the cpu_fast_t interpreter.
+///
+/// Run stats are identical to those of cpu_fast_t, except for the decoded instruction cache hits.
+class cpu_jit_t : public cpu_fast_t {
+public:
+  /// @brief Constructor for cpu_jit_t.
+  ///
+  /// @param ram The RAM to use for this CPU instance.
+  cpu_jit_t(ram_t& ram);
+  ~cpu_jit_t() override;
+
+  void dump_stats() override;
+  void write_stats(json_writer_t& json) const override;
+
+protected:
+  void execute(const uint64_t cycle_limit) override;
+  void translated_code_modified(const uint32_t addr) override;
+  void flush_translations() override;
+
+private:
+  struct context_t;
+
+  // Code cache configuration.
+  static const size_t CODE_CACHE_SIZE = 32u * 1024u * 1024u;
+  static const size_t MAX_BLOCK_CODE_SIZE = 64u * 1024u;
+  static const uint32_t MAX_BLOCK_INSTRS = 256u;
+
+  // Maximum number of cycles to run before returning to the dispatcher.
+  static const int64_t MAX_BUDGET = 1000000;
+
+  /// @brief Check if a decoded instruction can be translated.
+  static bool can_translate(const decoded_instr_t& instr);
+
+  /// @brief Generate the entry and exit trampolines at the start of the code cache.
+  void generate_trampolines();
+
+  /// @brief Get the translated block for the given PC, translating it if necessary.
+  /// @returns the block entry point, or nullptr if the code at the PC can not be translated.
+  const uint8_t* get_block(const uint32_t pc);
+
+  /// @brief Translate a block of guest code.
+  /// @returns the block entry point, or nullptr if the code at the PC can not be translated.
+  const uint8_t* translate_block(const uint32_t block_pc);
+
+  /// @brief Drop all translated code.
+  void flush_code_cache();
+
+  // Helper functions that are called from translated code.
+  static uint32_t alu_helper(const uint32_t ex_op,
+                             const uint32_t packed_mode,
+                             const uint32_t src_a,
+                             const uint32_t src_b);
+  static uint32_t store_helper(cpu_jit_t* cpu, const uint32_t addr);
+
+  // Executable code cache.
+  uint8_t* m_code = nullptr;
+  uint8_t* m_code_ptr = nullptr;
+  const uint8_t* m_exit_code = nullptr;
+  void (*m_enter)(context_t*, const uint8_t*) = nullptr;
+
+  // Translated blocks (nullptr for code that can not be translated).
+  std::unordered_map<uint32_t, const uint8_t*> m_blocks;
+
+  // Translated instruction words, per page.
+  std::unordered_map<uint32_t, std::bitset<DECODED_PAGE_SIZE / 4u>> m_translated_words;
+
+  // The code cache must be flushed before executing any more translated code.
+  bool m_flush_pending = false;
+
+  // Incremented every time that the code cache is flushed.
+  uint32_t m_code_generation = 0u;
+
+  // JIT stats.
+  uint64_t m_translated_block_count = 0u;
+  uint64_t m_translated_instr_count = 0u;
+  uint64_t m_native_instr_count = 0u;
+  uint64_t m_code_cache_flush_count = 0u;
+};
+
+#endif  // SIM_CPU_JIT_HPP_
@@ -0,0 +1,188 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#include "cpu_rec.hpp"
+
+#include "alu.hpp"
+#include "config.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+const cpu_rec_t::program_t* s_program = nullptr;
+}  // namespace
+
+bool cpu_rec_t::register_program(const program_t* program) {
+  s_program = program;
+  config_t::instance().set_cpu_type(config_t::cpu_type_t::REC);
+  return true;
+}
+
+const cpu_rec_t::program_t* cpu_rec_t::program() {
+  return s_program;
+}
+
+cpu_rec_t::cpu_rec_t(ram_t& ram) : cpu_fast_t(ram) {
+  if (s_program != nullptr) {
+    for (uint32_t i = 0u; i < s_program->num_blocks; ++i) {
+      m_blocks[s_program->blocks[i].pc] = i;
+    }
+    m_enabled.resize(s_program->num_blocks, 0u);
+  }
+}
+
+void cpu_rec_t::dump_stats() {
+  cpu_fast_t::dump_stats();
+
+  const auto num_enabled = std::count(m_enabled.begin(), m_enabled.end(), 1u);
+  const double native_ratio =
+      static_cast<double>(m_native_instr_count) / static_cast<double>(m_fetched_instr_count);
+  std::cout << " Recompiled blocks:    " << m_blocks.size() << " (" << num_enabled << " enabled)\n";
+  std::cout << " Native instructions:  " << m_native_instr_count << " (" << (100.0 * native_ratio)
+            << "%)\n";
+}
+
+void cpu_rec_t::write_stats(json_writer_t& json) const {
+  cpu_fast_t::write_stats(json);
+  const auto num_enabled = std::count(m_enabled.begin(), m_enabled.end(), 1u);
+  json.value("recompiled_blocks", static_cast<uint64_t>(m_blocks.size()));
+  json.value("enabled_blocks", static_cast<uint64_t>(num_enabled));
+  json.value("native_instructions", m_native_instr_count);
+}
+
+void cpu_rec_t::execute(const uint64_t cycle_limit) {
+  if (s_program == nullptr) {
+    interpret(cycle_limit, false);
+    return;
+  }
+
+  context_t ctx;
+  ctx.regs = m_regs.data();
+  ctx.ram = m_ram.data();
+  ctx.ram_size = m_ram.direct_size();
+  ctx.code_pages = m_code_page_flags;
+  ctx.enabled = m_enabled.data();
+  ctx.cpu = this;
+  ctx.budget = 0;
+  ctx.next_pc = 0u;
+  ctx.status = STATUS_CONTINUE;
+
+  while (!m_syscalls.terminate() && !m_terminate_requested &&
+         m_total_cycle_count < cycle_limit) {
+    sync_code();
+    if (m_verify_pending) {
+      verify_program();
+    }
+
+    block_fn_t fn = nullptr;
+    const auto it = m_blocks.find(m_regs[REG_PC]);
+    if (it != m_blocks.end() && m_enabled[it->second] != 0u) {
+      fn = s_program->blocks[it->second].fn;
+    }
+    if (fn == nullptr) {
+      interpret(cycle_limit, true);
+      continue;
+    }
+
+    // Run recompiled code until it returns to the dispatcher.
+    const uint64_t cycles_left = cycle_limit - m_total_cycle_count;
+    const int64_t budget = static_cast<int64_t>(std::min<uint64_t>(cycles_left, MAX_BUDGET));
+    ctx.budget = budget;
+    ctx.status = STATUS_CONTINUE;
+    next_t next{fn};
+    while (next.fn != nullptr) {
+      next = next.fn(ctx);
+
+      // Blocks check if they are enabled on entry, so code that was modified by other harts is
+      // disabled before the next block runs.
+      sync_code();
+      if (m_verify_pending) {
+        verify_program();
+      }
+    }
+
+    // Each recompiled instruction takes exactly one cycle.
+    const uint32_t executed = static_cast<uint32_t>(budget - ctx.budget);
+    m_total_cycle_count += executed;
+    m_fetched_instr_count += executed;
+    m_native_instr_count += executed;
+    m_regs[REG_PC] = ctx.next_pc;
+
+    if (ctx.status != STATUS_CONTINUE) {
+      interpret(cycle_limit, true);
+    }
+  }
+}
+
+void cpu_rec_t::translated_code_modified(const uint32_t addr) {
+  // Re-verify all blocks that may contain the modified word (blocks are sorted by PC).
+  const auto* blocks = s_program->blocks;
+  const auto* it = std::upper_bound(
+      blocks, blocks + s_program->num_blocks, addr, [](const uint32_t a, const block_t& b) {
+        return a < b.pc;
+      });
+  while (it != blocks && addr - (it - 1)->pc < 4u * MAX_BLOCK_INSTRS) {
+    --it;
+    verify_block(static_cast<uint32_t>(it - blocks));
+  }
+}
+
+void cpu_rec_t::flush_translations() {
+  // The RAM contents may have changed (e.g. a new program was loaded).
+  m_verify_pending = true;
+}
+
+void cpu_rec_t::verify_program() {
+  m_verify_pending = false;
+
+  uint32_t num_disabled = 0u;
+  for (uint32_t i = 0u; i < s_program->num_blocks; ++i) {
+    verify_block(i);
+    num_disabled += (m_enabled[i] != 0u) ? 0u : 1u;
+  }
+  if (num_disabled > 0u && config_t::instance().verbose()) {
+    std::cerr << "Warning: " << num_disabled << " of " << s_program->num_blocks
+              << " recompiled blocks do not match the program.\n";
+  }
+
+  // Stores to the recompiled code must be checked.
+  const uint32_t begin = s_program->code_begin;
+  const auto end = static_cast<uint32_t>(std::min<uint64_t>(s_program->code_end, m_ram.size()));
+  for (uint32_t addr = begin; addr < end; addr += DECODED_PAGE_SIZE) {
+    mark_code_page(addr >> LOG2_DECODED_PAGE_SIZE, CODE_PAGE_TRANSLATED);
+  }
+  if (begin < end) {
+    mark_code_page((end - 1u) >> LOG2_DECODED_PAGE_SIZE, CODE_PAGE_TRANSLATED);
+  }
+}
+
+void cpu_rec_t::verify_block(const uint32_t index) {
+  const auto& block = s_program->blocks[index];
+  bool match = m_ram.valid_range(block.pc, 4u * block.num_instrs);
+  for (uint32_t i = 0u; match && i < block.num_instrs; ++i) {
+    const uint32_t addr = block.pc + 4u * i;
+    match = (m_ram.load32(addr) == s_program->code[(addr - s_program->code_begin) >> 2u]);
+  }
+  const uint8_t enabled = match ? 1u : 0u;
+  if (m_enabled[index] != 0u && enabled == 0u) {
+    m_blocks_disabled = true;
+  }
+  m_enabled[index] = enabled;
+}
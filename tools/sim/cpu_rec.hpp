@@ -0,0 +1,206 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef SIM_CPU_REC_HPP_
+#define SIM_CPU_REC_HPP_
+
+#include "cpu_fast.hpp"
+
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+/// @brief A CPU core that runs a statically recompiled guest program.
+///
+/// The guest program is translated to C++ ahead of time by the mr32rec tool (see recompiler.hpp),
+/// with one function per basic block, and the generated code is compiled into the simulator. The
+/// generated translation unit registers the program with register_program() during static
+/// initialization.
+///
+/// Execution starts in the recompiled code when the current PC is the start of a recompiled
+/// block. Everything else (vector operations, simulator routine calls, unknown indirect jump
+/// targets and faulting memory accesses) is executed by the cpu_fast_t interpreter. If the guest
+/// code in RAM does not match the recompiled code (e.g. a different program file was loaded, or
+/// the program modified its own code), the recompiled code is disabled.
+///
+/// Run stats are identical to those of cpu_fast_t, except for the decoded instruction cache hits.
+class cpu_rec_t : public cpu_fast_t {
+public:
+  struct context_t;
+  struct next_t;
+
+  /// @brief A recompiled block function.
+  /// @returns the next block function to call, or nullptr to return to the dispatcher (in which
+  /// case context_t::next_pc holds the next PC).
+  using block_fn_t = next_t (*)(context_t& c);
+
+  struct next_t {
+    block_fn_t fn;
+  };
+
+  /// @brief The state that recompiled code operates on.
+  struct context_t {
+    uint32_t* regs;             // Guest scalar registers.
+    uint8_t* ram;               // Guest RAM.
+    uint64_t ram_size;          // Size of the guest RAM.
+    const uint8_t* code_pages;  // Per page code flags.
+    const uint8_t* enabled;     // Per block enable flags (zero if the guest code was modified).
+    cpu_rec_t* cpu;             // The CPU instance.
+    int64_t budget;             // Remaining cycle budget.
+    uint32_t next_pc;           // PC to continue at when returning to the dispatcher.
+    uint32_t status;            // Why the recompiled code returned to the dispatcher.
+  };
+
+  // Reasons for returning from recompiled code to the dispatcher.
+  static const uint32_t STATUS_CONTINUE = 0u;   // Continue at next_pc.
+  static const uint32_t STATUS_INTERPRET = 1u;  // Interpret the code at next_pc.
+
+  // Maximum number of instructions per block.
+  static const uint32_t MAX_BLOCK_INSTRS = 256u;
+
+  /// @brief A recompiled block.
+  struct block_t {
+    uint32_t pc;          // Guest address of the first instruction.
+    uint32_t num_instrs;  // Number of instructions.
+    block_fn_t fn;        // Block function.
+  };
+
+  /// @brief A recompiled program.
+  struct program_t {
+    uint32_t code_begin;   // Start of the recompiled code range.
+    uint32_t code_end;     // End of the recompiled code range (exclusive).
+    const uint32_t* code;  // The instruction words that the program was recompiled from.
+    const block_t* blocks;  // The blocks, sorted by PC.
+    uint32_t num_blocks;
+  };
+
+  /// @brief Register the recompiled program.
+  ///
+  /// This also makes cpu_rec_t the default CPU implementation.
+  /// @returns true.
+  static bool register_program(const program_t* program);
+
+  /// @brief Get the registered recompiled program.
+  /// @returns the program, or nullptr if no program has been registered.
+  static const program_t* program();
+
+  /// @brief Constructor for cpu_rec_t.
+  ///
+  /// @param ram The RAM to use for this CPU instance.
+  cpu_rec_t(ram_t& ram);
+
+  void dump_stats() override;
+  void write_stats(json_writer_t& json) const override;
+
+  // Helper functions for recompiled code.
+
+  static uint32_t alu(const uint32_t ex_op,
+                      const uint32_t packed_mode,
+                      const uint32_t src_a,
+                      const uint32_t src_b) {
+    return execute_alu(ex_op, packed_mode, src_a, src_b);
+  }
+
+  static bool valid(const context_t& c, const uint32_t addr, const uint32_t size) {
+    return ((addr & (size - 1u)) == 0u) && (static_cast<uint64_t>(addr) + size <= c.ram_size);
+  }
+
+  static uint32_t load8(const context_t& c, const uint32_t addr) {
+    return c.ram[addr];
+  }
+
+  static uint32_t load8signed(const context_t& c, const uint32_t addr) {
+    return static_cast<uint32_t>(static_cast<int32_t>(static_cast<int8_t>(c.ram[addr])));
+  }
+
+  static uint32_t load16(const context_t& c, const uint32_t addr) {
+    uint16_t x;
+    std::memcpy(&x, &c.ram[addr], sizeof(x));
+    return convert_endianity(x);
+  }
+
+  static uint32_t load16signed(const context_t& c, const uint32_t addr) {
+    return static_cast<uint32_t>(static_cast<int32_t>(static_cast<int16_t>(load16(c, addr))));
+  }
+
+  static uint32_t load32(const context_t& c, const uint32_t addr) {
+    uint32_t x;
+    std::memcpy(&x, &c.ram[addr], sizeof(x));
+    return convert_endianity(x);
+  }
+
+  static void store8(context_t& c, const uint32_t addr, const uint32_t value) {
+    c.ram[addr] = static_cast<uint8_t>(value);
+  }
+
+  static void store16(context_t& c, const uint32_t addr, const uint32_t value) {
+    const uint16_t x = convert_endianity(static_cast<uint16_t>(value));
+    std::memcpy(&c.ram[addr], &x, sizeof(x));
+  }
+
+  static void store32(context_t& c, const uint32_t addr, const uint32_t value) {
+    const uint32_t x = convert_endianity(value);
+    std::memcpy(&c.ram[addr], &x, sizeof(x));
+  }
+
+  /// @brief Check if a store may have modified code.
+  /// @returns true if recompiled code was modified, and the current block must not continue.
+  static bool is_code_store(context_t& c, const uint32_t addr) {
+    if (c.code_pages[addr >> LOG2_DECODED_PAGE_SIZE] == 0u) {
+      return false;
+    }
+    c.cpu->m_blocks_disabled = false;
+    c.cpu->code_modified(addr);
+    return c.cpu->m_blocks_disabled;
+  }
+
+protected:
+  void execute(const uint64_t cycle_limit) override;
+  void translated_code_modified(const uint32_t addr) override;
+  void flush_translations() override;
+
+private:
+  // Maximum number of cycles to run before returning to the dispatcher.
+  static const int64_t MAX_BUDGET = 1000000;
+
+  /// @brief Check that the guest code in RAM matches the recompiled program.
+  void verify_program();
+
+  /// @brief Enable or disable a block depending on if the guest code in RAM matches the block.
+  void verify_block(const uint32_t index);
+
+  friend class recompiler_t;
+
+  // Recompiled blocks (indices into the block table of the program), by PC.
+  std::unordered_map<uint32_t, uint32_t> m_blocks;
+
+  // Per block enable flags.
+  std::vector<uint8_t> m_enabled;
+
+  // The guest code must be verified before running any more recompiled code.
+  bool m_verify_pending = true;
+
+  // Set when a block is disabled.
+  bool m_blocks_disabled = false;
+
+  // Stats.
+  uint64_t m_native_instr_count = 0u;
+};
+
+#endif  // SIM_CPU_REC_HPP_
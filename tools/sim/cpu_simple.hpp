@@ -20,7 +20,12 @@
 #ifndef SIM_CPU_SIMPLE_HPP_
 #define SIM_CPU_SIMPLE_HPP_
 
+#include "branch_predictor.hpp"
+#include "cache_model.hpp"
 #include "cpu.hpp"
+#include "timing_model.hpp"
+
+#include <memory>
 
 /// @brief A simple implementation of a CPU core.
 ///
@@ -30,13 +35,49 @@ public:
   /// @brief Constructor for cpu_simple_t.
   ///
   /// @param ram The RAM to use for this CPU instance.
-  cpu_simple_t(ram_t& ram) : cpu_t(ram) {
-  }
+  cpu_simple_t(ram_t& ram);
 
   uint32_t run(const int64_t max_cycles) override;
+  void dump_stats() override;
+  void write_stats(json_writer_t& json) const override;
 
 private:
-  uint32_t cpuid32(const uint32_t a, const uint32_t b);
+  /// @brief Inform the timing model about an issued instruction.
+  /// @param instr The decoded instruction.
+  void issue_timing(const decoded_instr_t& instr);
+
+  /// @brief Count memory accesses for the memory traffic stats.
+  /// @param mem_op The memory operation.
+  /// @param count The number of accesses (vector elements).
+  void count_mem_accesses(const uint32_t mem_op, const uint32_t count) {
+    if (mem_op == MEM_OP_LDEA) {
+      return;
+    }
+    const uint32_t bytes = count << ((mem_op & 3u) - 1u);  // 1, 2 or 4 bytes per access.
+    if ((mem_op & 8u) != 0u) {
+      m_store_count += count;
+      m_store_bytes += bytes;
+    } else {
+      m_load_count += count;
+      m_load_bytes += bytes;
+    }
+  }
+
+  // Memory traffic stats.
+  uint64_t m_load_count = 0u;
+  uint64_t m_load_bytes = 0u;
+  uint64_t m_store_count = 0u;
+  uint64_t m_store_bytes = 0u;
+
+  // Timing model (nullptr if disabled).
+  std::unique_ptr<timing_model_t> m_timing;
+
+  // L1 cache models (nullptr if disabled).
+  std::unique_ptr<cache_model_t> m_icache;
+  std::unique_ptr<cache_model_t> m_dcache;
+
+  // Branch predictor statistics (nullptr if disabled).
+  std::unique_ptr<branch_stats_t> m_branch_stats;
 };
 
 #endif  // SIM_CPU_SIMPLE_HPP_
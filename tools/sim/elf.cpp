@@ -0,0 +1,243 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#include "elf.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+// ELF constants.
+const uint32_t ELF_MAGIC = 0x464c457fu;  // "\x7fELF" as a little endian word.
+const uint8_t ELFCLASS32 = 1u;
+const uint8_t ELFDATA2LSB = 1u;
+const uint16_t EM_MRISC32 = 0xc001u;
+const uint32_t PT_LOAD = 1u;
+const uint32_t PF_X = 1u;
+const uint32_t SHT_SYMTAB = 2u;
+const uint32_t SHF_EXECINSTR = 4u;
+const uint16_t SHN_UNDEF = 0u;
+const uint16_t SHN_LORESERVE = 0xff00u;
+const uint8_t STT_NOTYPE = 0u;
+const uint8_t STT_OBJECT = 1u;
+const uint8_t STT_FUNC = 2u;
+
+const uint32_t ELF_HEADER_SIZE = 52u;
+const uint32_t PROGRAM_HEADER_SIZE = 32u;
+const uint32_t SECTION_HEADER_SIZE = 40u;
+const uint32_t SYMBOL_SIZE = 16u;
+
+uint16_t get16(const std::vector<uint8_t>& buf, const size_t offset) {
+  return static_cast<uint16_t>(static_cast<uint32_t>(buf[offset]) |
+                               (static_cast<uint32_t>(buf[offset + 1u]) << 8));
+}
+
+uint32_t get32(const std::vector<uint8_t>& buf, const size_t offset) {
+  return static_cast<uint32_t>(buf[offset]) | (static_cast<uint32_t>(buf[offset + 1u]) << 8) |
+         (static_cast<uint32_t>(buf[offset + 2u]) << 16) |
+         (static_cast<uint32_t>(buf[offset + 3u]) << 24);
+}
+
+std::vector<uint8_t> read_bytes(std::ifstream& f, const uint64_t offset, const uint64_t size) {
+  std::vector<uint8_t> buf(static_cast<size_t>(size));
+  f.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+  f.read(reinterpret_cast<char*>(buf.data()), static_cast<std::streamsize>(size));
+  if (!f.good()) {
+    throw std::runtime_error("Premature end of ELF file.");
+  }
+  return buf;
+}
+
+// Describes a section (only the fields that we need).
+struct section_t {
+  uint32_t type;
+  uint32_t flags;
+  uint32_t offset;
+  uint32_t size;
+  uint32_t link;
+  uint32_t entsize;
+};
+}  // namespace
+
+void symbol_table_t::add(const elf_symbol_t& symbol) {
+  m_symbols.push_back(symbol);
+}
+
+void symbol_table_t::sort() {
+  std::stable_sort(m_symbols.begin(),
+                   m_symbols.end(),
+                   [](const elf_symbol_t& a, const elf_symbol_t& b) { return a.addr < b.addr; });
+}
+
+const elf_symbol_t* symbol_table_t::find_function(const uint32_t addr) const {
+  // Find the first symbol above addr, and search backwards for a function.
+  auto it = std::upper_bound(
+      m_symbols.begin(), m_symbols.end(), addr, [](const uint32_t a, const elf_symbol_t& sym) {
+        return a < sym.addr;
+      });
+  while (it != m_symbols.begin()) {
+    --it;
+    if (it->is_function) {
+      return &*it;
+    }
+  }
+  return nullptr;
+}
+
+bool elf_file_t::is_elf_file(const char* file_name) {
+  std::ifstream f(file_name, std::fstream::in | std::fstream::binary);
+  std::vector<uint8_t> magic(4u);
+  f.read(reinterpret_cast<char*>(magic.data()), 4);
+  return f.good() && get32(magic, 0u) == ELF_MAGIC;
+}
+
+elf_file_t::elf_file_t(const char* file_name) : m_file_name(file_name) {
+  std::ifstream f(file_name, std::fstream::in | std::fstream::binary);
+  if (!f.good()) {
+    throw std::runtime_error("Unable to open the ELF file.");
+  }
+
+  // Read the file header.
+  const auto hdr = read_bytes(f, 0u, ELF_HEADER_SIZE);
+  if (get32(hdr, 0u) != ELF_MAGIC) {
+    throw std::runtime_error("Not an ELF file.");
+  }
+  if (hdr[4] != ELFCLASS32 || hdr[5] != ELFDATA2LSB) {
+    throw std::runtime_error("Not a 32-bit little endian ELF file.");
+  }
+  if (get16(hdr, 18u) != EM_MRISC32) {
+    throw std::runtime_error("Not an MRISC32 ELF file.");
+  }
+  m_entry = get32(hdr, 24u);
+  const uint32_t phoff = get32(hdr, 28u);
+  const uint32_t shoff = get32(hdr, 32u);
+  const uint16_t phentsize = get16(hdr, 42u);
+  const uint16_t phnum = get16(hdr, 44u);
+  const uint16_t shentsize = get16(hdr, 46u);
+  const uint16_t shnum = get16(hdr, 48u);
+
+  // Read the program headers and collect the loadable segments.
+  if (phnum > 0u && phentsize < PROGRAM_HEADER_SIZE) {
+    throw std::runtime_error("Invalid ELF program header size.");
+  }
+  const auto phdrs = read_bytes(f, phoff, static_cast<uint64_t>(phnum) * phentsize);
+  for (uint32_t i = 0u; i < phnum; ++i) {
+    const size_t ph = static_cast<size_t>(i) * phentsize;
+    if (get32(phdrs, ph) != PT_LOAD) {
+      continue;
+    }
+    segment_t segment;
+    segment.file_offset = get32(phdrs, ph + 4u);
+    segment.addr = get32(phdrs, ph + 12u);  // p_paddr (the load address).
+    segment.file_size = get32(phdrs, ph + 16u);
+    segment.mem_size = get32(phdrs, ph + 20u);
+    segment.executable = (get32(phdrs, ph + 24u) & PF_X) != 0u;
+    if (segment.mem_size < segment.file_size) {
+      throw std::runtime_error("Invalid ELF segment size.");
+    }
+    if (segment.mem_size > 0u) {
+      m_segments.push_back(segment);
+    }
+  }
+
+  // Read the section headers.
+  if (shnum == 0u) {
+    return;
+  }
+  if (shentsize < SECTION_HEADER_SIZE) {
+    throw std::runtime_error("Invalid ELF section header size.");
+  }
+  const auto shdrs = read_bytes(f, shoff, static_cast<uint64_t>(shnum) * shentsize);
+  std::vector<section_t> sections(shnum);
+  for (uint32_t i = 0u; i < shnum; ++i) {
+    const size_t sh = static_cast<size_t>(i) * shentsize;
+    sections[i].type = get32(shdrs, sh + 4u);
+    sections[i].flags = get32(shdrs, sh + 8u);
+    sections[i].offset = get32(shdrs, sh + 16u);
+    sections[i].size = get32(shdrs, sh + 20u);
+    sections[i].link = get32(shdrs, sh + 24u);
+    sections[i].entsize = get32(shdrs, sh + 36u);
+  }
+
+  // Read the symbol table (if any).
+  for (const auto& symtab : sections) {
+    if (symtab.type != SHT_SYMTAB || symtab.link >= shnum || symtab.entsize < SYMBOL_SIZE) {
+      continue;
+    }
+    const auto& strtab = sections[symtab.link];
+    const auto syms = read_bytes(f, symtab.offset, symtab.size);
+    const auto strs = read_bytes(f, strtab.offset, strtab.size);
+    for (size_t sym = 0u; sym + SYMBOL_SIZE <= syms.size(); sym += symtab.entsize) {
+      const uint32_t name_idx = get32(syms, sym);
+      const uint8_t type = syms[sym + 12u] & 15u;
+      const uint16_t shndx = get16(syms, sym + 14u);
+      if (shndx == SHN_UNDEF || shndx >= SHN_LORESERVE || shndx >= shnum ||
+          name_idx >= strs.size()) {
+        continue;
+      }
+      if (type != STT_NOTYPE && type != STT_OBJECT && type != STT_FUNC) {
+        continue;
+      }
+
+      // Skip assembler local labels (e.g. ".L12").
+      const auto* name_begin = reinterpret_cast<const char*>(&strs[name_idx]);
+      const auto name_end = std::find(strs.begin() + name_idx, strs.end(), 0u) - strs.begin();
+      std::string name(name_begin, static_cast<size_t>(name_end) - name_idx);
+      if (name.empty() || name.compare(0u, 2u, ".L") == 0) {
+        continue;
+      }
+
+      // Plain labels (e.g. from assembly language code) in executable sections are considered
+      // to be functions.
+      elf_symbol_t symbol;
+      symbol.name = std::move(name);
+      symbol.addr = get32(syms, sym + 4u);
+      symbol.size = get32(syms, sym + 8u);
+      symbol.is_function =
+          type == STT_FUNC ||
+          (type == STT_NOTYPE && (sections[shndx].flags & SHF_EXECINSTR) != 0u);
+      m_symbols.add(symbol);
+    }
+  }
+  m_symbols.sort();
+}
+
+uint64_t elf_file_t::load(ram_t& ram) const {
+  uint64_t total_bytes_read = 0u;
+  for (const auto& segment : m_segments) {
+    // Check that the whole segment, including the BSS part, fits in RAM.
+    if (static_cast<uint64_t>(segment.addr) + segment.mem_size > ram.size()) {
+      std::ostringstream ss;
+      ss << "The ELF segment @ 0x" << std::hex << segment.addr << " does not fit in RAM.";
+      throw std::runtime_error(ss.str());
+    }
+    if (segment.file_size > 0u) {
+      const auto bytes_read =
+          ram.load_file(m_file_name.c_str(), segment.file_offset, segment.addr, segment.file_size);
+      if (bytes_read != segment.file_size) {
+        throw std::runtime_error("Premature end of ELF file.");
+      }
+      total_bytes_read += bytes_read;
+    }
+  }
+  return total_bytes_read;
+}
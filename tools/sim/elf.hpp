@@ -0,0 +1,113 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef SIM_ELF_HPP_
+#define SIM_ELF_HPP_
+
+#include "ram.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// @brief A symbol from the symbol table of an ELF file.
+struct elf_symbol_t {
+  std::string name;
+  uint32_t addr;
+  uint32_t size;
+  bool is_function;
+};
+
+/// @brief A symbol table, sorted by address.
+class symbol_table_t {
+public:
+  /// @brief Add a symbol to the table.
+  void add(const elf_symbol_t& symbol);
+
+  /// @brief Sort the symbols by address (must be called after all symbols have been added).
+  void sort();
+
+  /// @brief Find the function that contains a given address.
+  /// @param addr The address to look up.
+  /// @returns the closest function symbol at or below addr, or nullptr if there is none.
+  const elf_symbol_t* find_function(const uint32_t addr) const;
+
+  const std::vector<elf_symbol_t>& symbols() const {
+    return m_symbols;
+  }
+
+  bool empty() const {
+    return m_symbols.empty();
+  }
+
+private:
+  std::vector<elf_symbol_t> m_symbols;
+};
+
+/// @brief An elf32-mrisc32 executable file.
+///
+/// ELF format interpreted according to:
+/// https://en.wikipedia.org/wiki/Executable_and_Linkable_Format
+class elf_file_t {
+public:
+  /// @brief A loadable (PT_LOAD) segment.
+  struct segment_t {
+    uint64_t file_offset;
+    uint32_t addr;
+    uint32_t file_size;
+    uint32_t mem_size;
+    bool executable;
+  };
+
+  /// @brief Read the headers and the symbol table of an ELF file.
+  /// @param file_name The name of the ELF file.
+  /// @throws std::runtime_error if the file is not a valid elf32-mrisc32 file.
+  explicit elf_file_t(const char* file_name);
+
+  /// @brief Check if a file is an ELF file.
+  static bool is_elf_file(const char* file_name);
+
+  /// @brief Load all the segments into RAM.
+  ///
+  /// The file contents of each segment are loaded with ram_t::load_file(). The BSS part of a
+  /// segment (beyond its file size) is not written to, since the RAM is zero-filled on first
+  /// access.
+  /// @returns the total number of bytes that were loaded from the file.
+  uint64_t load(ram_t& ram) const;
+
+  uint32_t entry() const {
+    return m_entry;
+  }
+
+  const std::vector<segment_t>& segments() const {
+    return m_segments;
+  }
+
+  const symbol_table_t& symbols() const {
+    return m_symbols;
+  }
+
+private:
+  std::string m_file_name;
+  uint32_t m_entry = 0u;
+  std::vector<segment_t> m_segments;
+  symbol_table_t m_symbols;
+};
+
+#endif  // SIM_ELF_HPP_
@@ -0,0 +1,89 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#include "event_scheduler.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
+void event_scheduler_t::clear() {
+  for (auto& slot : m_slots) {
+    slot.clear();
+  }
+  m_next_cycle = NEVER;
+  m_current_cycle = 0u;
+}
+
+void event_scheduler_t::schedule(const uint64_t cycle, callback_t callback) {
+  const uint64_t event_cycle = std::max(cycle, m_current_cycle);
+  m_slots[slot_no(event_cycle) & (NUM_SLOTS - 1u)].push_back({event_cycle, std::move(callback)});
+  m_next_cycle = std::min(m_next_cycle, event_cycle);
+}
+
+void event_scheduler_t::fire_events(const uint64_t cycle) {
+  std::vector<callback_t> due;
+  while (m_next_cycle <= cycle) {
+    // Take the events for the next cycle out of the wheel before calling them, since the callbacks
+    // may schedule new events.
+    const uint64_t event_cycle = m_next_cycle;
+    auto& slot = m_slots[slot_no(event_cycle) & (NUM_SLOTS - 1u)];
+    size_t num_kept = 0u;
+    for (size_t i = 0u; i < slot.size(); ++i) {
+      if (slot[i].cycle == event_cycle) {
+        due.push_back(std::move(slot[i].callback));
+      } else {
+        if (num_kept != i) {
+          slot[num_kept] = std::move(slot[i]);
+        }
+        ++num_kept;
+      }
+    }
+    slot.resize(num_kept);
+    m_current_cycle = event_cycle;
+    m_next_cycle = find_next_cycle(event_cycle);
+
+    for (auto& callback : due) {
+      callback(event_cycle);
+    }
+    due.clear();
+  }
+}
+
+uint64_t event_scheduler_t::find_next_cycle(const uint64_t from) const {
+  // Walk one revolution of the wheel, starting at the slot for the given cycle. The first slot
+  // that holds an event for the current revolution has the next event. Events for later
+  // revolutions are only used if there are no events in the current revolution.
+  uint64_t next_later_cycle = NEVER;
+  const uint64_t first_slot_no = slot_no(from);
+  for (uint64_t no = first_slot_no; no < first_slot_no + NUM_SLOTS; ++no) {
+    uint64_t next_cycle = NEVER;
+    for (const auto& event : m_slots[no & (NUM_SLOTS - 1u)]) {
+      if (slot_no(event.cycle) == no) {
+        next_cycle = std::min(next_cycle, event.cycle);
+      } else {
+        next_later_cycle = std::min(next_later_cycle, event.cycle);
+      }
+    }
+    if (next_cycle != NEVER) {
+      return next_cycle;
+    }
+  }
+  return next_later_cycle;
+}
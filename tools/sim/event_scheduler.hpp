@@ -0,0 +1,90 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef SIM_EVENT_SCHEDULER_HPP_
+#define SIM_EVENT_SCHEDULER_HPP_
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/// @brief A discrete event scheduler, keyed by the simulated CPU cycle.
+///
+/// Devices (e.g. frame counters and timers) post events that fire at a given cycle. The CPU
+/// services the scheduler between quanta, so events are called from the CPU thread, in cycle
+/// order, at deterministic points in simulated time. Events that are scheduled for the same cycle
+/// are called in the order that they were scheduled.
+///
+/// Pending events are kept in a timing wheel with NUM_SLOTS slots that cover SLOT_CYCLES cycles
+/// each. Events that are more than one revolution of the wheel into the future stay in their slot
+/// until the wheel comes around to them.
+class event_scheduler_t {
+public:
+  /// @brief An event callback. The argument is the cycle for which the event was scheduled.
+  using callback_t = std::function<void(const uint64_t cycle)>;
+
+  /// @brief The cycle of the next event when there are no pending events.
+  static const uint64_t NEVER = UINT64_MAX;
+
+  /// @brief Remove all pending events and rewind the scheduler to cycle zero.
+  void clear();
+
+  /// @brief Schedule an event.
+  /// @param cycle The cycle when the event fires. Events in the past fire as soon as possible.
+  /// @param callback The function to call when the event fires.
+  void schedule(const uint64_t cycle, callback_t callback);
+
+  /// @brief Get the cycle of the next pending event (NEVER if there are no pending events).
+  uint64_t next_event_cycle() const {
+    return m_next_cycle;
+  }
+
+  /// @brief Fire all events that are due at or before a given cycle.
+  /// @param cycle The current cycle.
+  void run_until(const uint64_t cycle) {
+    if (cycle >= m_next_cycle) {
+      fire_events(cycle);
+    }
+    m_current_cycle = cycle;
+  }
+
+private:
+  static const uint32_t LOG2_SLOT_CYCLES = 10u;
+  static const uint32_t LOG2_NUM_SLOTS = 10u;
+  static const uint32_t NUM_SLOTS = 1u << LOG2_NUM_SLOTS;
+
+  struct event_t {
+    uint64_t cycle;
+    callback_t callback;
+  };
+
+  static uint64_t slot_no(const uint64_t cycle) {
+    return cycle >> LOG2_SLOT_CYCLES;
+  }
+
+  void fire_events(const uint64_t cycle);
+  uint64_t find_next_cycle(const uint64_t from) const;
+
+  std::array<std::vector<event_t>, NUM_SLOTS> m_slots;
+  uint64_t m_next_cycle = NEVER;
+  uint64_t m_current_cycle = 0u;
+};
+
+#endif  // SIM_EVENT_SCHEDULER_HPP_
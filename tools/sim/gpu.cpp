@@ -32,7 +32,6 @@ const uint32_t MMIO_GPU_ADDR = MMIO_GPU_BASE + 0u;       // Start of the framebu
 const uint32_t MMIO_GPU_WIDTH = MMIO_GPU_BASE + 4u;      // Width of the framebuffer (in pixels).
 const uint32_t MMIO_GPU_HEIGHT = MMIO_GPU_BASE + 8u;     // Height of the framebuffer (in pixels).
 const uint32_t MMIO_GPU_DEPTH = MMIO_GPU_BASE + 12u;     // Number of bits per pixel.
-const uint32_t MMIO_GPU_FRAME_NO = MMIO_GPU_BASE + 32u;  // Current frame number (32 bits).
 
 const GLchar* VERTEX_SRC =
     "#version 150\n"
@@ -346,8 +345,4 @@ void gpu_t::paint(const int actual_fb_width, const int actual_fb_height) {
   glDrawArrays(GL_TRIANGLES, 0, 6);  // 6 vertices -> 2 triangles
   glDisableVertexAttribArray(0);
   check_gl_error();
-
-  // Update the frame number.
-  ++m_frame_no;
-  m_ram.store32(MMIO_GPU_FRAME_NO, m_frame_no);
 }
@@ -0,0 +1,34 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef SIM_HEX_STRING_HPP_
+#define SIM_HEX_STRING_HPP_
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+/// @brief Format a 32-bit value as a hexadecimal string (e.g. "0x0000abcd").
+inline std::string as_hex32(const uint32_t x) {
+  char str[16];
+  std::snprintf(str, sizeof(str), "0x%08x", x);
+  return std::string(&str[0]);
+}
+
+#endif  // SIM_HEX_STRING_HPP_
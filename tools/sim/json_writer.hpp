@@ -0,0 +1,103 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef SIM_JSON_WRITER_HPP_
+#define SIM_JSON_WRITER_HPP_
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/// @brief A minimal streaming JSON writer (for statistics output).
+///
+/// Objects are nested with begin_object() / end_object(), and each value is written as a named
+/// member of the current object. Keys and strings are not escaped, so they must not contain quotes
+/// or control characters.
+class json_writer_t {
+public:
+  explicit json_writer_t(std::ostream& out) : m_out(out) {
+  }
+
+  /// @brief Start a new object.
+  /// @param key The member name of the object (nullptr for the top level object).
+  void begin_object(const char* key = nullptr) {
+    if (key != nullptr) {
+      begin_member(key);
+    }
+    m_out << "{";
+    m_first_member.push_back(true);
+  }
+
+  /// @brief End the current object.
+  void end_object() {
+    m_first_member.pop_back();
+    m_out << "\n" << indent() << "}";
+    if (m_first_member.empty()) {
+      m_out << "\n";
+    }
+  }
+
+  void value(const std::string& key, const uint64_t x) {
+    begin_member(key);
+    m_out << x;
+  }
+
+  void value(const std::string& key, const uint32_t x) {
+    value(key, static_cast<uint64_t>(x));
+  }
+
+  void value(const std::string& key, const int x) {
+    begin_member(key);
+    m_out << x;
+  }
+
+  void value(const std::string& key, const double x) {
+    // JSON has no representation for NaN or infinity.
+    char str[32];
+    std::snprintf(str, sizeof(str) - 1, "%.6g", std::isfinite(x) ? x : 0.0);
+    begin_member(key);
+    m_out << str;
+  }
+
+  void value(const std::string& key, const char* x) {
+    begin_member(key);
+    m_out << "\"" << x << "\"";
+  }
+
+private:
+  void begin_member(const std::string& key) {
+    if (!m_first_member.back()) {
+      m_out << ",";
+    }
+    m_first_member.back() = false;
+    m_out << "\n" << indent() << "\"" << key << "\": ";
+  }
+
+  std::string indent() const {
+    return std::string(2u * m_first_member.size(), ' ');
+  }
+
+  std::ostream& m_out;
+  std::vector<bool> m_first_member;
+};
+
+#endif  // SIM_JSON_WRITER_HPP_
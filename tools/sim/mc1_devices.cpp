@@ -0,0 +1,68 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#include "mc1_devices.hpp"
+
+mc1_devices_t::mc1_devices_t(ram_t& ram, event_scheduler_t& events)
+    : m_events(events), m_sys_regs(SYS_NUM_REGS), m_gpu_regs(GPU_NUM_REGS) {
+  // System registers. The remaining registers (e.g. SEGDISP* and LEDS) are writable.
+  m_sys_regs.set(SYS_CLKCNTLO, 0u, true);
+  m_sys_regs.set(SYS_CLKCNTHI, 0u, true);
+  m_sys_regs.set(SYS_CPUCLK, CPU_CLK, true);
+  m_sys_regs.set(SYS_VRAMSIZE, 128u * 1024u, true);
+  m_sys_regs.set(SYS_XRAMSIZE, 0u, true);
+  m_sys_regs.set(SYS_VIDWIDTH, 1920u, true);
+  m_sys_regs.set(SYS_VIDHEIGHT, 1080u, true);
+  m_sys_regs.set(SYS_VIDFPS, VIDEO_FPS, true);
+  m_sys_regs.set(SYS_VIDFRAMENO, 0u, true);
+  m_sys_regs.set(SYS_VIDY, 0u, true);
+  m_sys_regs.set(SYS_SWITCHES, 4u, true);
+  m_sys_regs.set(SYS_BUTTONS, 0u, true);
+  m_sys_regs.set(SYS_KEYPTR, 0u, true);
+  m_sys_regs.set(SYS_MOUSEPOS, 0u, true);
+  m_sys_regs.set(SYS_MOUSEBTNS, 0u, true);
+
+  // GPU registers. The framebuffer configuration is written by the guest (zero means that the
+  // configured default is used), but the frame number is read-only.
+  m_gpu_regs.set(GPU_FRAME_NO, 0u, true);
+
+  ram.map_device(MMIO_SYS_BASE, m_sys_regs.size(), &m_sys_regs);
+  ram.map_device(MMIO_GPU_BASE, m_gpu_regs.size(), &m_gpu_regs);
+}
+
+void mc1_devices_t::start() {
+  m_frame_no = 0u;
+  m_sys_regs.set(SYS_VIDFRAMENO, 0u, true);
+  m_gpu_regs.set(GPU_FRAME_NO, 0u, true);
+  schedule_next_frame();
+}
+
+void mc1_devices_t::schedule_next_frame() {
+  // Calculate the start of each frame from the frame number, to avoid accumulating rounding
+  // errors.
+  const uint64_t cycle = ((m_frame_no + 1u) * CPU_CLK * 65536u) / VIDEO_FPS;
+  m_events.schedule(cycle, [this](const uint64_t) { next_frame(); });
+}
+
+void mc1_devices_t::next_frame() {
+  ++m_frame_no;
+  m_sys_regs.set(SYS_VIDFRAMENO, static_cast<uint32_t>(m_frame_no), true);
+  m_gpu_regs.set(GPU_FRAME_NO, static_cast<uint32_t>(m_frame_no), true);
+  schedule_next_frame();
+}
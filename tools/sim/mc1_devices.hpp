@@ -0,0 +1,86 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef SIM_MC1_DEVICES_HPP_
+#define SIM_MC1_DEVICES_HPP_
+
+#include "event_scheduler.hpp"
+#include "mmio.hpp"
+#include "ram.hpp"
+
+#include <cstdint>
+
+/// @brief Memory mapped I/O devices of the MC1 computer.
+///
+/// The MC1 system registers are mapped at 0xc0000000 and the GPU configuration registers are
+/// mapped at 0xc0000100. Read-only registers (e.g. CPUCLK and VIDWIDTH) ignore guest writes. The
+/// video frame counters are advanced in simulated time by the event scheduler.
+class mc1_devices_t {
+public:
+  /// @brief The simulated CPU clock frequency (Hz).
+  static const uint32_t CPU_CLK = 70000000u;
+
+  /// @brief Constructor for mc1_devices_t.
+  ///
+  /// The devices are mapped into the address space of the RAM. The RAM must outlive the devices.
+  /// @param ram The RAM to map the devices into.
+  /// @param events The event scheduler that drives simulated time.
+  mc1_devices_t(ram_t& ram, event_scheduler_t& events);
+
+  /// @brief Start the devices at cycle zero.
+  void start();
+
+private:
+  // MC1 system registers.
+  static const uint32_t MMIO_SYS_BASE = 0xc0000000u;
+  static const uint32_t SYS_CLKCNTLO = 0u;
+  static const uint32_t SYS_CLKCNTHI = 4u;
+  static const uint32_t SYS_CPUCLK = 8u;
+  static const uint32_t SYS_VRAMSIZE = 12u;
+  static const uint32_t SYS_XRAMSIZE = 16u;
+  static const uint32_t SYS_VIDWIDTH = 20u;
+  static const uint32_t SYS_VIDHEIGHT = 24u;
+  static const uint32_t SYS_VIDFPS = 28u;
+  static const uint32_t SYS_VIDFRAMENO = 32u;
+  static const uint32_t SYS_VIDY = 36u;
+  static const uint32_t SYS_SWITCHES = 40u;
+  static const uint32_t SYS_BUTTONS = 44u;
+  static const uint32_t SYS_KEYPTR = 48u;
+  static const uint32_t SYS_MOUSEPOS = 52u;
+  static const uint32_t SYS_MOUSEBTNS = 56u;
+  static const uint32_t SYS_NUM_REGS = 64u;
+
+  // GPU configuration registers (see gpu.cpp).
+  static const uint32_t MMIO_GPU_BASE = 0xc0000100u;
+  static const uint32_t GPU_FRAME_NO = 32u;
+  static const uint32_t GPU_NUM_REGS = 64u;
+
+  // Video timing.
+  static const uint32_t VIDEO_FPS = 60u * 65536u;  // 16.16 fixed point.
+
+  void schedule_next_frame();
+  void next_frame();
+
+  event_scheduler_t& m_events;
+  mmio_registers_t m_sys_regs;
+  mmio_registers_t m_gpu_regs;
+  uint64_t m_frame_no = 0u;
+};
+
+#endif  // SIM_MC1_DEVICES_HPP_
@@ -0,0 +1,101 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef SIM_MMIO_HPP_
+#define SIM_MMIO_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/// @brief Interface for memory mapped I/O devices.
+///
+/// A device is mapped into a region of the address space with ram_t::map_device(). Devices are
+/// accessed as 32-bit words (narrower guest accesses are handled by ram_t). The device may be
+/// accessed from several threads (e.g. CPU harts and the GUI thread), so implementations must be
+/// thread safe.
+class mmio_device_t {
+public:
+  virtual ~mmio_device_t() {
+  }
+
+  /// @brief Read a 32-bit word.
+  /// @param offset The word aligned byte offset into the device region.
+  virtual uint32_t read32(const uint32_t offset) = 0;
+
+  /// @brief Write a 32-bit word.
+  /// @param offset The word aligned byte offset into the device region.
+  /// @param value The value to write.
+  virtual void write32(const uint32_t offset, const uint32_t value) = 0;
+};
+
+/// @brief A device with a bank of 32-bit registers.
+///
+/// Registers can be made read-only for the guest, in which case guest writes are ignored. The
+/// device side (e.g. the simulator or the GUI) can always update the registers with set().
+class mmio_registers_t : public mmio_device_t {
+public:
+  /// @brief Constructor for mmio_registers_t.
+  /// @param num_regs The number of 32-bit registers (all registers are initially zero).
+  explicit mmio_registers_t(const uint32_t num_regs)
+      : m_num_regs(num_regs),
+        m_regs(new std::atomic<uint32_t>[num_regs]),
+        m_read_only(new std::atomic<bool>[num_regs]) {
+    for (uint32_t i = 0u; i < num_regs; ++i) {
+      m_regs[i] = 0u;
+      m_read_only[i] = false;
+    }
+  }
+
+  uint32_t read32(const uint32_t offset) override {
+    const uint32_t i = offset >> 2u;
+    return i < m_num_regs ? m_regs[i].load(std::memory_order_acquire) : 0u;
+  }
+
+  void write32(const uint32_t offset, const uint32_t value) override {
+    const uint32_t i = offset >> 2u;
+    if (i < m_num_regs && !m_read_only[i].load(std::memory_order_acquire)) {
+      m_regs[i].store(value, std::memory_order_release);
+    }
+  }
+
+  /// @brief Get the size of the register bank in bytes.
+  uint32_t size() const {
+    return m_num_regs * 4u;
+  }
+
+  /// @brief Set a register value (from the device side).
+  /// @param offset The word aligned byte offset of the register.
+  /// @param value The new value.
+  /// @param read_only True if guest writes to the register shall be ignored.
+  void set(const uint32_t offset, const uint32_t value, const bool read_only = false) {
+    // The device side may run concurrently with the harts, so update the flag before the value
+    // (a guest write must not overwrite a register that has just been made read-only).
+    const uint32_t i = offset >> 2u;
+    m_read_only[i].store(read_only, std::memory_order_release);
+    m_regs[i].store(value, std::memory_order_release);
+  }
+
+private:
+  const uint32_t m_num_regs;
+  std::unique_ptr<std::atomic<uint32_t>[]> m_regs;
+  std::unique_ptr<std::atomic<bool>[]> m_read_only;
+};
+
+#endif  // SIM_MMIO_HPP_
@@ -0,0 +1,146 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#include "ram.hpp"
+#include "recompiler.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+uint32_t str_to_uint32(const char* str) {
+  return static_cast<uint32_t>(std::stoull(std::string(str), nullptr, 0));
+}
+
+void print_help(const char* prg_name) {
+  std::cout << "mr32rec - Statically recompile an MRISC32 program to C++\n";
+  std::cout << "Usage: " << prg_name << " [options] bin-file cpp-file\n";
+  std::cout << "Options:\n";
+  std::cout << "  -h, --help                       Display this information.\n";
+  std::cout << "  -v, --verbose                    Print stats.\n";
+  std::cout << "  -A ADDR, --addr ADDR             Set the program (ROM) start address.\n";
+  std::cout << "\n";
+  std::cout << "The generated C++ file is compiled into mr32sim (see MR32SIM_REC_PROGRAM in\n";
+  std::cout << "CMakeLists.txt), which then runs the recompiled code when the same program is\n";
+  std::cout << "loaded.\n";
+  return;
+}
+}  // namespace
+
+int main(const int argc, const char** argv) {
+  // Parse command line options.
+  const char* bin_file = nullptr;
+  const char* cpp_file = nullptr;
+  uint32_t bin_addr = 0u;
+  bool bin_addr_defined = false;
+  bool verbose = false;
+  try {
+    for (int k = 1; k < argc; ++k) {
+      if (argv[k][0] == '-') {
+        if ((std::strcmp(argv[k], "--help") == 0) || (std::strcmp(argv[k], "-h") == 0)) {
+          print_help(argv[0]);
+          exit(0);
+        } else if ((std::strcmp(argv[k], "-v") == 0) || (std::strcmp(argv[k], "--verbose") == 0)) {
+          verbose = true;
+        } else if ((std::strcmp(argv[k], "-A") == 0) || (std::strcmp(argv[k], "--addr") == 0)) {
+          if (k >= (argc - 1)) {
+            std::cerr << "Missing option for " << argv[k] << "\n";
+            print_help(argv[0]);
+            exit(1);
+          }
+          bin_addr = str_to_uint32(argv[++k]);
+          bin_addr_defined = true;
+        } else {
+          std::cerr << "Error: Unknown option: " << argv[k] << "\n";
+          print_help(argv[0]);
+          exit(1);
+        }
+      } else if (bin_file == nullptr) {
+        bin_file = argv[k];
+      } else if (cpp_file == nullptr) {
+        cpp_file = argv[k];
+      } else {
+        std::cerr << "Error: Too many arguments.\n";
+        print_help(argv[0]);
+        exit(1);
+      }
+    }
+  } catch (...) {
+    std::cerr << "Error: Couldn't parse command line arguments.\n";
+    print_help(argv[0]);
+    exit(1);
+  }
+  if (bin_file == nullptr || cpp_file == nullptr) {
+    std::cerr << "Error: No program file or output file specified.\n";
+    print_help(argv[0]);
+    std::exit(1);
+  }
+
+  try {
+    // Read the program file (the same format as mr32sim uses).
+    std::ifstream f(bin_file, std::fstream::in | std::fstream::binary);
+    if (!f.good()) {
+      throw std::runtime_error("Unable to open the binary file.");
+    }
+    if (!bin_addr_defined) {
+      f.read(reinterpret_cast<char*>(&bin_addr), 4);
+      if (!f.good()) {
+        throw std::runtime_error("Premature end of file.");
+      }
+    }
+    const std::vector<char> data((std::istreambuf_iterator<char>(f)),
+                                 std::istreambuf_iterator<char>());
+    const uint64_t image_end = static_cast<uint64_t>(bin_addr) + data.size();
+    if (image_end > 0x100000000u) {
+      throw std::runtime_error("The program does not fit in the address space.");
+    }
+
+    // Load the program into a RAM that is just large enough.
+    ram_t ram((image_end + 3u) & ~static_cast<uint64_t>(3u));
+    for (size_t i = 0u; i < data.size(); ++i) {
+      ram.store8(bin_addr + static_cast<uint32_t>(i), static_cast<uint8_t>(data[i]));
+    }
+
+    // Recompile the program.
+    recompiler_t recompiler(ram, bin_addr, image_end);
+    recompiler.discover();
+
+    std::ofstream out(cpp_file);
+    if (!out.good()) {
+      throw std::runtime_error("Unable to open the output file.");
+    }
+    recompiler.write_cpp(out, bin_file);
+    if (verbose) {
+      std::cout << "Recompiled " << recompiler.num_blocks() << " blocks from " << bin_file
+                << " into " << cpp_file << "\n";
+    }
+  } catch (std::exception& e) {
+    std::cerr << "Error: " << e.what() << "\n";
+    std::exit(1);
+  }
+
+  return 0;
+}
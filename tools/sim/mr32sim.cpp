@@ -18,7 +18,12 @@
 //--------------------------------------------------------------------------------------------------
 
 #include "config.hpp"
-#include "cpu_simple.hpp"
+#include "cpu_factory.hpp"
+#include "elf.hpp"
+#include "event_scheduler.hpp"
+#include "json_writer.hpp"
+#include "mc1_devices.hpp"
+#include "profiler.hpp"
 #include "ram.hpp"
 
 #ifdef ENABLE_GUI
@@ -28,7 +33,9 @@
 #include "gpu.hpp"
 #endif
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
@@ -36,49 +43,113 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
 #include <thread>
+#include <vector>
 
 namespace {
+// Information about the loaded program.
+struct program_info_t {
+  uint32_t text_begin = 0u;  // Start of the code.
+  uint32_t text_end = 0u;    // End of the code (exclusive).
+  symbol_table_t symbols;
+};
+
+void print_load_info(const char* file_name, const uint64_t bytes_read, const uint32_t addr) {
+  if (config_t::instance().verbose()) {
+    std::cout << "Read " << bytes_read << " bytes from " << file_name << " into RAM @ 0x"
+              << std::hex << std::setw(8) << std::setfill('0') << addr << "\n";
+    std::cout << std::resetiosflags(std::ios::hex);
+  }
+}
+
 void read_bin_file(const char* file_name,
                    ram_t& ram,
                    const bool override_addr,
-                   const uint32_t addr) {
-  std::ifstream f(file_name, std::fstream::in | std::fstream::binary);
-  if (f.bad()) {
-    throw std::runtime_error("Unable to open the binary file.");
-  }
-
+                   const uint32_t addr,
+                   program_info_t& info) {
   // Read the start address.
   uint32_t start_addr;
+  uint64_t file_offset;
   if (!override_addr) {
+    std::ifstream f(file_name, std::fstream::in | std::fstream::binary);
+    if (!f.good()) {
+      throw std::runtime_error("Unable to open the binary file.");
+    }
     f.read(reinterpret_cast<char*>(&start_addr), 4);
     if (!f.good()) {
       throw std::runtime_error("Premature end of file.");
     }
+    file_offset = 4u;
   } else {
     start_addr = addr;
+    file_offset = 0u;
   }
 
-  // Read blocks from the file into RAM.
-  uint32_t current_addr = start_addr;
-  uint32_t total_bytes_read = 0u;
-  while (f.good()) {
-    uint8_t byte;
-    f.read(reinterpret_cast<char*>(&byte), 1);
-    ram.store8(current_addr, byte);
-    const uint32_t bytes_read = f ? 1 : static_cast<uint32_t>(f.gcount());
-    total_bytes_read += bytes_read;
-    current_addr += bytes_read;
+  // Load the rest of the file into RAM.
+  const auto bytes_read = ram.load_file(file_name, file_offset, start_addr);
+  print_load_info(file_name, bytes_read, start_addr);
+
+  // The whole image is considered to be code.
+  info.text_begin = start_addr;
+  info.text_end = static_cast<uint32_t>(
+      std::min<uint64_t>(static_cast<uint64_t>(start_addr) + bytes_read, 0xfffffffcu));
+}
+
+void read_elf_file(const char* file_name, ram_t& ram, program_info_t& info) {
+  const elf_file_t elf(file_name);
+  if (elf.entry() != cpu_t::reset_pc()) {
+    std::cerr << "Warning: The ELF entry point (0x" << std::hex << elf.entry()
+              << ") differs from the CPU reset address (0x" << cpu_t::reset_pc() << ").\n";
+    std::cerr << std::resetiosflags(std::ios::hex);
   }
 
-  f.close();
+  // Load the segments into RAM.
+  const auto bytes_read = elf.load(ram);
   if (config_t::instance().verbose()) {
-    std::cout << "Read " << total_bytes_read << " bytes from " << file_name << " into RAM @ 0x"
-              << std::hex << std::setw(8) << std::setfill('0') << start_addr << "\n";
-    std::cout << std::resetiosflags(std::ios::hex);
+    for (const auto& segment : elf.segments()) {
+      std::cout << "Segment @ 0x" << std::hex << std::setw(8) << std::setfill('0')
+                << segment.addr << std::resetiosflags(std::ios::hex) << ": " << segment.file_size
+                << " bytes from file, " << segment.mem_size << " bytes in memory\n";
+    }
+  }
+  print_load_info(file_name, bytes_read, elf.entry());
+
+  // The text range covers all the executable segments.
+  bool first = true;
+  for (const auto& segment : elf.segments()) {
+    if (segment.executable) {
+      const auto end = segment.addr + segment.mem_size;
+      info.text_begin = first ? segment.addr : std::min(info.text_begin, segment.addr);
+      info.text_end = first ? end : std::max(info.text_end, end);
+      first = false;
+    }
+  }
+
+  // Keep the symbol table.
+  info.symbols = elf.symbols();
+  if (config_t::instance().verbose()) {
+    std::cout << "Read " << info.symbols.symbols().size() << " symbols from " << file_name
+              << "\n";
   }
 }
 
+void load_data_file(const std::string& file_and_addr, ram_t& ram) {
+  // The argument has the form FILE@ADDR.
+  const auto at_pos = file_and_addr.rfind('@');
+  if (at_pos == std::string::npos) {
+    throw std::runtime_error("Invalid data file argument (expected FILE@ADDR): " + file_and_addr);
+  }
+  const auto file_name = file_and_addr.substr(0, at_pos);
+  const auto addr =
+      static_cast<uint32_t>(std::stoull(file_and_addr.substr(at_pos + 1), nullptr, 0));
+
+  const auto bytes_read = ram.load_file(file_name.c_str(), 0u, addr);
+  print_load_info(file_name.c_str(), bytes_read, addr);
+}
+
 uint64_t str_to_uint64(const char* str) {
   return static_cast<uint64_t>(std::stoull(std::string(str), nullptr, 0));
 }
@@ -91,9 +162,69 @@ uint32_t str_to_uint32(const char* str) {
   return static_cast<uint32_t>(str_to_uint64(str));
 }
 
+// Parse a range of the form "A:B".
+void str_to_range(const char* str, uint64_t& first, uint64_t& second) {
+  const std::string s(str);
+  const auto colon_pos = s.find(':');
+  if (colon_pos == std::string::npos) {
+    throw std::invalid_argument("Invalid range");
+  }
+  first = str_to_uint64(s.substr(0, colon_pos).c_str());
+  second = str_to_uint64(s.substr(colon_pos + 1).c_str());
+}
+
+void write_stats_json(const std::string& file_name,
+                      const std::vector<std::unique_ptr<cpu_t>>& cpus,
+                      const ram_t& ram,
+                      const int exit_code,
+                      const double wall_time) {
+  const cpu_t& cpu = *cpus.front();
+  std::ofstream out(file_name);
+  if (!out.good()) {
+    throw std::runtime_error("Unable to open the stats file.");
+  }
+
+  json_writer_t json(out);
+  json.begin_object();
+  json.value("exit_code", exit_code);
+  json.begin_object("cpu");
+  cpu.write_stats(json);
+  json.end_object();
+  if (cpus.size() > 1u) {
+    json.begin_object("harts");
+    for (const auto& hart : cpus) {
+      json.begin_object(std::to_string(hart->hart_id()).c_str());
+      hart->write_stats(json);
+      json.end_object();
+    }
+    json.end_object();
+  }
+  json.begin_object("ram");
+  json.value("touched_pages", ram.touched_pages());
+  json.value("touched_bytes", ram.touched_pages() * ram_t::page_size());
+  json.end_object();
+  if (config_t::instance().instr_mix_enabled()) {
+    json.begin_object("instr_mix");
+    cpu.write_instr_mix(json);
+    json.end_object();
+  }
+  json.begin_object("host");
+  json.value("wall_time_s", wall_time);
+  uint64_t instr_count = 0u;
+  uint64_t cycle_count = 0u;
+  for (const auto& hart : cpus) {
+    instr_count += hart->fetched_instr_count();
+    cycle_count += hart->total_cycle_count();
+  }
+  json.value("simulated_mips", static_cast<double>(instr_count) / wall_time * 1e-6);
+  json.value("simulated_mhz", static_cast<double>(cycle_count) / wall_time * 1e-6);
+  json.end_object();
+  json.end_object();
+}
+
 void print_help(const char* prg_name) {
   std::cout << "mr32sim - An MRISC32 CPU simulator\n";
-  std::cout << "Usage: " << prg_name << " [options] bin-file\n";
+  std::cout << "Usage: " << prg_name << " [options] bin-file|elf-file\n";
   std::cout << "Options:\n";
   std::cout << "  -h, --help                       Display this information.\n";
   std::cout << "  -v, --verbose                    Print stats.\n";
@@ -103,9 +234,28 @@ void print_help(const char* prg_name) {
   std::cout << "  -gh HEIGHT, --gfx-height HEIGHT  Set framebuffer height.\n";
   std::cout << "  -gd DEPTH, --gfx-depth DEPTH     Set framebuffer depht.\n";
   std::cout << "  -t FILE, --trace FILE            Enable debug trace.\n";
+  std::cout << "  --trace-format FMT               Debug trace format (raw or compressed).\n";
+  std::cout << "  --trace-pc FIRST:LAST            Only trace instructions in a PC range.\n";
+  std::cout << "  --trace-cycles BEGIN:END         Only trace cycles in the window [BEGIN, END).\n";
+  std::cout << "  --trace-trigger PC               Start tracing when PC is executed.\n";
+  std::cout << "  --trace-sample N                 Only trace every Nth instruction.\n";
+  std::cout << "  --profile FILE                   Write an execution profile to FILE.\n";
+  std::cout << "  --profile-stacks FILE            Write folded call stacks (for flame graphs).\n";
+  std::cout << "  --instr-mix FILE                 Write the instruction mix (JSON) to FILE.\n";
+  std::cout << "  --stats-json FILE                Write run statistics (JSON) to FILE.\n";
+  std::cout << "  --timing                         Enable the MRISC32-A1 pipeline timing model.\n";
+  std::cout << "  --timing-params FILE             Load timing model parameters from FILE.\n";
+  std::cout << "  --icache SIZE:WAYS:LINE[:POLICY] Enable an L1 instruction cache model.\n";
+  std::cout << "  --dcache SIZE:WAYS:LINE[:POLICY] Enable an L1 data cache model.\n";
+  std::cout << "  --branch-stats                   Evaluate branch predictor models.\n";
   std::cout << "  -R N, --ram-size N               Set the RAM size (in bytes).\n";
+  std::cout << "  --unchecked-ram                  Use guard pages for RAM range checks.\n";
   std::cout << "  -A ADDR, --addr ADDR             Set the program (ROM) start address.\n";
+  std::cout << "  --load FILE@ADDR                 Load a raw data file into RAM @ ADDR.\n";
   std::cout << "  -c CYCLES, --cycles CYCLES       Maximum number of CPU cycles to simulate.\n";
+  std::cout << "  --cpu TYPE                       CPU implementation (simple, fast, jit or rec).\n";
+  std::cout << "  --harts N                        Simulate N CPU cores (harts) that share RAM.\n";
+  std::cout << "  --virtual-time                   Derive the time from the simulated CPU clock.\n";
   return;
 }
 }  // namespace
@@ -117,6 +267,7 @@ int main(const int argc, const char** argv) {
   uint32_t bin_addr = 0u;
   int64_t max_cycles = -1;
   bool bin_addr_defined = false;
+  std::vector<std::string> data_files;
   try {
     for (int k = 1; k < argc; ++k) {
       if (argv[k][0] == '-') {
@@ -164,6 +315,115 @@ int main(const int argc, const char** argv) {
           }
           config_t::instance().set_trace_file_name(std::string(argv[++k]));
           config_t::instance().set_trace_enabled(true);
+        } else if (std::strcmp(argv[k], "--trace-format") == 0) {
+          if (k >= (argc - 1)) {
+            std::cerr << "Missing option for " << argv[k] << "\n";
+            print_help(argv[0]);
+            exit(1);
+          }
+          ++k;
+          if (std::strcmp(argv[k], "raw") == 0) {
+            config_t::instance().set_trace_format(config_t::trace_format_t::RAW);
+          } else if (std::strcmp(argv[k], "compressed") == 0) {
+            config_t::instance().set_trace_format(config_t::trace_format_t::COMPRESSED);
+          } else {
+            std::cerr << "Error: Unknown trace format: " << argv[k] << "\n";
+            print_help(argv[0]);
+            exit(1);
+          }
+        } else if (std::strcmp(argv[k], "--trace-pc") == 0) {
+          if (k >= (argc - 1)) {
+            std::cerr << "Missing option for " << argv[k] << "\n";
+            print_help(argv[0]);
+            exit(1);
+          }
+          uint64_t first;
+          uint64_t last;
+          str_to_range(argv[++k], first, last);
+          config_t::instance().set_trace_pc_range(static_cast<uint32_t>(first),
+                                                  static_cast<uint32_t>(last));
+        } else if (std::strcmp(argv[k], "--trace-cycles") == 0) {
+          if (k >= (argc - 1)) {
+            std::cerr << "Missing option for " << argv[k] << "\n";
+            print_help(argv[0]);
+            exit(1);
+          }
+          uint64_t begin;
+          uint64_t end;
+          str_to_range(argv[++k], begin, end);
+          config_t::instance().set_trace_cycle_window(begin, end);
+        } else if (std::strcmp(argv[k], "--trace-trigger") == 0) {
+          if (k >= (argc - 1)) {
+            std::cerr << "Missing option for " << argv[k] << "\n";
+            print_help(argv[0]);
+            exit(1);
+          }
+          config_t::instance().set_trace_trigger_pc(str_to_uint32(argv[++k]));
+        } else if (std::strcmp(argv[k], "--trace-sample") == 0) {
+          if (k >= (argc - 1)) {
+            std::cerr << "Missing option for " << argv[k] << "\n";
+            print_help(argv[0]);
+            exit(1);
+          }
+          config_t::instance().set_trace_sample_rate(str_to_uint32(argv[++k]));
+        } else if (std::strcmp(argv[k], "--profile") == 0) {
+          if (k >= (argc - 1)) {
+            std::cerr << "Missing option for " << argv[k] << "\n";
+            print_help(argv[0]);
+            exit(1);
+          }
+          config_t::instance().set_profile_file_name(std::string(argv[++k]));
+          config_t::instance().set_profile_enabled(true);
+        } else if (std::strcmp(argv[k], "--profile-stacks") == 0) {
+          if (k >= (argc - 1)) {
+            std::cerr << "Missing option for " << argv[k] << "\n";
+            print_help(argv[0]);
+            exit(1);
+          }
+          config_t::instance().set_profile_stacks_file_name(std::string(argv[++k]));
+          config_t::instance().set_profile_enabled(true);
+        } else if (std::strcmp(argv[k], "--instr-mix") == 0) {
+          if (k >= (argc - 1)) {
+            std::cerr << "Missing option for " << argv[k] << "\n";
+            print_help(argv[0]);
+            exit(1);
+          }
+          config_t::instance().set_instr_mix_file_name(std::string(argv[++k]));
+          config_t::instance().set_instr_mix_enabled(true);
+        } else if (std::strcmp(argv[k], "--timing") == 0) {
+          config_t::instance().set_timing_enabled(true);
+        } else if (std::strcmp(argv[k], "--timing-params") == 0) {
+          if (k >= (argc - 1)) {
+            std::cerr << "Missing option for " << argv[k] << "\n";
+            print_help(argv[0]);
+            exit(1);
+          }
+          config_t::instance().set_timing_params_file_name(std::string(argv[++k]));
+          config_t::instance().set_timing_enabled(true);
+        } else if (std::strcmp(argv[k], "--icache") == 0) {
+          if (k >= (argc - 1)) {
+            std::cerr << "Missing option for " << argv[k] << "\n";
+            print_help(argv[0]);
+            exit(1);
+          }
+          config_t::instance().set_icache_spec(std::string(argv[++k]));
+        } else if (std::strcmp(argv[k], "--dcache") == 0) {
+          if (k >= (argc - 1)) {
+            std::cerr << "Missing option for " << argv[k] << "\n";
+            print_help(argv[0]);
+            exit(1);
+          }
+          config_t::instance().set_dcache_spec(std::string(argv[++k]));
+        } else if (std::strcmp(argv[k], "--branch-stats") == 0) {
+          config_t::instance().set_branch_stats_enabled(true);
+        } else if (std::strcmp(argv[k], "--stats-json") == 0) {
+          if (k >= (argc - 1)) {
+            std::cerr << "Missing option for " << argv[k] << "\n";
+            print_help(argv[0]);
+            exit(1);
+          }
+          config_t::instance().set_stats_json_file_name(std::string(argv[++k]));
+          config_t::instance().set_stats_json_enabled(true);
         } else if ((std::strcmp(argv[k], "-R") == 0) || (std::strcmp(argv[k], "--ram-size") == 0)) {
           if (k >= (argc - 1)) {
             std::cerr << "Missing option for " << argv[k] << "\n";
@@ -171,6 +431,8 @@ int main(const int argc, const char** argv) {
             exit(1);
           }
           config_t::instance().set_ram_size(str_to_uint64(argv[++k]));
+        } else if (std::strcmp(argv[k], "--unchecked-ram") == 0) {
+          config_t::instance().set_unchecked_ram(true);
         } else if ((std::strcmp(argv[k], "-A") == 0) || (std::strcmp(argv[k], "--addr") == 0)) {
           if (k >= (argc - 1)) {
             std::cerr << "Missing option for " << argv[k] << "\n";
@@ -179,6 +441,13 @@ int main(const int argc, const char** argv) {
           }
           bin_addr = str_to_uint32(argv[++k]);
           bin_addr_defined = true;
+        } else if (std::strcmp(argv[k], "--load") == 0) {
+          if (k >= (argc - 1)) {
+            std::cerr << "Missing option for " << argv[k] << "\n";
+            print_help(argv[0]);
+            exit(1);
+          }
+          data_files.emplace_back(argv[++k]);
         } else if ((std::strcmp(argv[k], "-c") == 0) || (std::strcmp(argv[k], "--cycles") == 0)) {
           if (k >= (argc - 1)) {
             std::cerr << "Missing option for " << argv[k] << "\n";
@@ -186,6 +455,35 @@ int main(const int argc, const char** argv) {
             exit(1);
           }
           max_cycles = str_to_int64(argv[++k]);
+        } else if (std::strcmp(argv[k], "--cpu") == 0) {
+          if (k >= (argc - 1)) {
+            std::cerr << "Missing option for " << argv[k] << "\n";
+            print_help(argv[0]);
+            exit(1);
+          }
+          ++k;
+          if (std::strcmp(argv[k], "simple") == 0) {
+            config_t::instance().set_cpu_type(config_t::cpu_type_t::SIMPLE);
+          } else if (std::strcmp(argv[k], "fast") == 0) {
+            config_t::instance().set_cpu_type(config_t::cpu_type_t::FAST);
+          } else if (std::strcmp(argv[k], "jit") == 0) {
+            config_t::instance().set_cpu_type(config_t::cpu_type_t::JIT);
+          } else if (std::strcmp(argv[k], "rec") == 0) {
+            config_t::instance().set_cpu_type(config_t::cpu_type_t::REC);
+          } else {
+            std::cerr << "Error: Unknown CPU type: " << argv[k] << "\n";
+            print_help(argv[0]);
+            exit(1);
+          }
+        } else if (std::strcmp(argv[k], "--harts") == 0) {
+          if (k >= (argc - 1)) {
+            std::cerr << "Missing option for " << argv[k] << "\n";
+            print_help(argv[0]);
+            exit(1);
+          }
+          config_t::instance().set_num_harts(str_to_uint32(argv[++k]));
+        } else if (std::strcmp(argv[k], "--virtual-time") == 0) {
+          config_t::instance().set_virtual_time(true);
         } else {
           std::cerr << "Error: Unknown option: " << argv[k] << "\n";
           print_help(argv[0]);
@@ -209,45 +507,96 @@ int main(const int argc, const char** argv) {
     print_help(argv[0]);
     std::exit(1);
   }
+  if (config_t::instance().num_harts() > 1u && config_t::instance().trace_enabled()) {
+    std::cerr << "Error: Debug traces are not supported with multiple harts.\n";
+    std::exit(1);
+  }
 
   try {
     // Initialize the RAM.
-    ram_t ram(config_t::instance().ram_size());
+    ram_t ram(config_t::instance().ram_size(), config_t::instance().unchecked_ram());
+    if (config_t::instance().unchecked_ram() && !ram.guarded()) {
+      std::cerr << "Warning: Unchecked RAM is not supported on this host (or for this RAM size)."
+                << " Using checked RAM.\n";
+    }
 
     // Load the program file into RAM.
-    read_bin_file(bin_file, ram, bin_addr_defined, bin_addr);
-
-    // HACK: Populate MMIO memory with MC1 fields.
-    const uint32_t MMIO_START = 0xc0000000u;
-    if (config_t::instance().ram_size() >= (MMIO_START + 64)) {
-      ram.store32(MMIO_START + 8, 70000000);     // CPUCLK
-      ram.store32(MMIO_START + 12, 128 * 1024);  // VRAMSIZE
-      ram.store32(MMIO_START + 20, 1920);        // VIDWIDTH
-      ram.store32(MMIO_START + 24, 1080);        // VIDHEIGHT
-      ram.store32(MMIO_START + 28, 60 * 65536);  // VIDFPS
-      ram.store32(MMIO_START + 40, 4);           // SWITCHES
+    program_info_t program_info;
+    if (!bin_addr_defined && elf_file_t::is_elf_file(bin_file)) {
+      read_elf_file(bin_file, ram, program_info);
+    } else {
+      read_bin_file(bin_file, ram, bin_addr_defined, bin_addr, program_info);
     }
 
-    // Initialize the CPU.
-    cpu_simple_t cpu(ram);
+    // Load any extra data files into RAM.
+    for (const auto& data_file : data_files) {
+      load_data_file(data_file, ram);
+    }
+
+    // Map the MC1 memory mapped I/O devices, driven in simulated time.
+    event_scheduler_t events;
+    mc1_devices_t mc1_devices(ram, events);
+    mc1_devices.start();
+
+    // Initialize the CPU cores (harts). All harts share the same RAM, and they all start executing
+    // at the reset PC. The program can use CPUID to tell the harts apart.
+    const uint32_t num_harts = config_t::instance().num_harts();
+    std::vector<std::unique_ptr<cpu_t>> cpus;
+    std::unique_ptr<cpu_t::code_sync_t> code_sync;
+    if (num_harts > 1u) {
+      code_sync.reset(new cpu_t::code_sync_t(ram, num_harts));
+    }
+    for (uint32_t hart_id = 0u; hart_id < num_harts; ++hart_id) {
+      cpus.emplace_back(create_cpu(ram));
+      cpus.back()->set_hart(hart_id, num_harts);
+      cpus.back()->set_code_sync(code_sync.get());
+      if (config_t::instance().virtual_time()) {
+        cpus.back()->set_virtual_clock(mc1_devices_t::CPU_CLK);
+      }
+    }
+    auto& cpu = cpus.front();
+
+    // The first hart drives simulated time for the devices.
+    cpu->set_event_scheduler(&events);
+
+    // Initialize the profiler (only the first hart is profiled).
+    std::unique_ptr<profiler_t> profiler;
+    if (config_t::instance().profile_enabled()) {
+      profiler.reset(new profiler_t(
+          program_info.text_begin, program_info.text_end, cpu_t::reset_pc()));
+      cpu->set_profiler(profiler.get());
+    }
 
     if (config_t::instance().verbose()) {
       std::cout << "------------------------------------------------------------------------\n";
     }
 
-    // Run the CPU in a separate thread.
+    // Run each hart in a separate thread.
+    const auto run_start_time = std::chrono::steady_clock::now();
     std::atomic_bool cpu_done(false);
     uint32_t cpu_exit_code = 0u;
-    std::thread cpu_thread([&cpu_exit_code, &cpu, &cpu_done, max_cycles] {
-      try {
-        // Run until the program returns.
-        cpu_exit_code = cpu.run(max_cycles);
-      } catch (std::exception& e) {
-        std::cerr << "Exception in CPU thread: " << e.what() << "\n";
-        cpu_exit_code = 1u;
-      }
-      cpu_done = true;
-    });
+    std::vector<std::thread> cpu_threads;
+    for (uint32_t hart_id = 0u; hart_id < num_harts; ++hart_id) {
+      cpu_threads.emplace_back([&cpu_exit_code, &cpus, &cpu_done, hart_id, max_cycles] {
+        uint32_t exit_code;
+        try {
+          // Run until the program returns.
+          exit_code = cpus[hart_id]->run(max_cycles);
+        } catch (std::exception& e) {
+          std::cerr << "Exception in CPU thread (hart " << hart_id << "): " << e.what() << "\n";
+          exit_code = 1u;
+        }
+
+        // The simulation is finished when the first hart returns. Stop the other harts.
+        if (hart_id == 0u) {
+          cpu_exit_code = exit_code;
+          for (uint32_t k = 1u; k < cpus.size(); ++k) {
+            cpus[k]->terminate();
+          }
+          cpu_done = true;
+        }
+      });
+    }
 
 #ifdef ENABLE_GUI
     if (config_t::instance().gfx_enabled()) {
@@ -301,7 +650,6 @@ int main(const int argc, const char** argv) {
 
           // Main loop.
           bool simulation_finished = false;
-          uint32_t frame_no = 0;
           while (!glfwWindowShouldClose(window)) {
             // Update the video mode.
             gpu.configure();
@@ -312,10 +660,6 @@ int main(const int argc, const char** argv) {
                   window, static_cast<int>(window_width), static_cast<int>(window_height));
             }
 
-            // Update the frame number (MC1 compat).
-            ram.store32(0xc0000020, frame_no);
-            frame_no += 1u;
-
             // Get the actual window framebuffer size (note: this is important on systems that use
             // coordinate scaling, such as on macos with retina display).
             int actual_fb_width;
@@ -352,23 +696,74 @@ int main(const int argc, const char** argv) {
         std::cerr << "Graphics error: " << e.what() << "\n";
       }
 
-      cpu.terminate();
+      for (auto& hart : cpus) {
+        hart->terminate();
+      }
     }
 #endif  // ENABLE_GUI
 
-    // Wait for the cpu thread to finish.
-    cpu_thread.join();
+    // Wait for the cpu threads to finish.
+    for (auto& cpu_thread : cpu_threads) {
+      cpu_thread.join();
+    }
     const int exit_code = static_cast<int>(cpu_exit_code);
+    const double wall_time =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - run_start_time).count();
 
     if (config_t::instance().verbose()) {
       // Show some stats.
       std::cout << "------------------------------------------------------------------------\n";
       std::cout << "Exit code: " << exit_code << "\n";
-      cpu.dump_stats();
+      for (const auto& hart : cpus) {
+        if (num_harts > 1u) {
+          std::cout << "Hart " << hart->hart_id() << ":\n";
+        }
+        hart->dump_stats();
+        if (config_t::instance().instr_mix_enabled()) {
+          hart->dump_instr_mix();
+        }
+      }
+      const uint64_t touched_pages = ram.touched_pages();
+      std::cout << "RAM:\n";
+      std::cout << " Touched pages:        " << touched_pages << " ("
+                << ((touched_pages * ram_t::page_size()) / 1024u) << " KiB)\n";
+    }
+
+    // Write the profiling results.
+    if (profiler) {
+      const auto& report_file_name = config_t::instance().profile_file_name();
+      if (!report_file_name.empty()) {
+        profiler->write_report(report_file_name, program_info.symbols);
+      }
+      const auto& stacks_file_name = config_t::instance().profile_stacks_file_name();
+      if (!stacks_file_name.empty()) {
+        profiler->write_folded_stacks(stacks_file_name, program_info.symbols);
+      }
+    }
+
+    // Write the instruction mix statistics.
+    if (config_t::instance().instr_mix_enabled()) {
+      std::ofstream out(config_t::instance().instr_mix_file_name());
+      if (!out.good()) {
+        throw std::runtime_error("Unable to open the instruction mix file.");
+      }
+      json_writer_t json(out);
+      json.begin_object();
+      cpu->write_instr_mix(json);
+      json.end_object();
+    }
+
+    // Write the run statistics.
+    if (config_t::instance().stats_json_enabled()) {
+      write_stats_json(
+          config_t::instance().stats_json_file_name(), cpus, ram, exit_code, wall_time);
     }
 
     // Dump some RAM (we use the same range as the MC1 VRAM).
-    cpu.dump_ram(0x40000000u, 0x40040000u, "/tmp/mrisc32_sim_vram.bin");
+    cpu->dump_ram(0x40000000u, 0x40040000u, "/tmp/mrisc32_sim_vram.bin");
+
+    // Destroy the CPUs before exiting, so that the debug trace is completely written.
+    cpus.clear();
 
     std::exit(exit_code);
   } catch (std::exception& e) {
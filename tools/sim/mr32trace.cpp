@@ -0,0 +1,343 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+// A raw debug trace record is five little endian 32-bit words: flags, PC, src A, src B and src C.
+const uint64_t RECORD_SIZE = 5u * 4u;
+
+// The file header of a compressed trace (see trace_format.hpp).
+const char COMPRESSED_MAGIC[8] = {'M', 'R', '3', '2', 'T', 'R', 'C', '1'};
+
+// The number of records that are compared in one go.
+const uint64_t BLOCK_RECORDS = 4096u;
+
+/// @brief A read-only memory mapped raw trace file.
+class trace_file_t {
+public:
+  explicit trace_file_t(const char* file_name) : m_name(file_name) {
+    const int fd = open(file_name, O_RDONLY);
+    struct stat file_stat;
+    if (fd < 0 || fstat(fd, &file_stat) != 0) {
+      throw std::runtime_error("Unable to open " + m_name);
+    }
+    m_size = static_cast<uint64_t>(file_stat.st_size);
+
+    // Compressed traces (--trace-format compressed) can not be compared record by record.
+    char magic[sizeof(COMPRESSED_MAGIC)];
+    if (pread(fd, magic, sizeof(magic), 0) == static_cast<ssize_t>(sizeof(magic)) &&
+        std::memcmp(magic, COMPRESSED_MAGIC, sizeof(magic)) == 0) {
+      close(fd);
+      throw std::runtime_error(m_name + " is a compressed trace (only raw traces are supported, " +
+                               "record the trace with --trace-format raw)");
+    }
+
+    if (m_size > 0u) {
+      void* data = mmap(nullptr, static_cast<size_t>(m_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("Unable to map " + m_name);
+      }
+      madvise(data, static_cast<size_t>(m_size), MADV_SEQUENTIAL);
+      m_data = static_cast<const uint8_t*>(data);
+    }
+    close(fd);
+  }
+
+  ~trace_file_t() {
+    if (m_data != nullptr) {
+      munmap(const_cast<uint8_t*>(m_data), static_cast<size_t>(m_size));
+    }
+  }
+
+  const std::string& name() const {
+    return m_name;
+  }
+
+  uint64_t num_records() const {
+    return m_size / RECORD_SIZE;
+  }
+
+  const uint8_t* record(const uint64_t idx) const {
+    return &m_data[idx * RECORD_SIZE];
+  }
+
+  uint32_t word(const uint64_t idx, const uint32_t word_no) const {
+    const uint8_t* buf = &record(idx)[4u * word_no];
+    return static_cast<uint32_t>(buf[0]) | (static_cast<uint32_t>(buf[1]) << 8) |
+           (static_cast<uint32_t>(buf[2]) << 16) | (static_cast<uint32_t>(buf[3]) << 24);
+  }
+
+  bool valid(const uint64_t idx) const {
+    return (record(idx)[0] & 1u) != 0u;
+  }
+
+  /// @brief Skip defunct records.
+  /// @returns the index of the first valid record at or after idx.
+  uint64_t skip_defunct(uint64_t idx) const {
+    while (idx < num_records() && !valid(idx)) {
+      ++idx;
+    }
+    return idx;
+  }
+
+  /// @brief Count the number of consecutive valid records (up to max_count) starting at idx.
+  uint64_t count_valid(const uint64_t idx, const uint64_t max_count) const {
+    uint64_t count = 0u;
+    while (count < max_count && valid(idx + count)) {
+      ++count;
+    }
+    return count;
+  }
+
+private:
+  std::string m_name;
+  const uint8_t* m_data = nullptr;
+  uint64_t m_size = 0u;
+
+  // The trace file object is non-copyable.
+  trace_file_t(const trace_file_t&) = delete;
+  trace_file_t& operator=(const trace_file_t&) = delete;
+};
+
+// Compare two records in the same way as they are shown (unused operands are ignored).
+bool records_equal(const trace_file_t& a,
+                   const uint64_t idx_a,
+                   const trace_file_t& b,
+                   const uint64_t idx_b) {
+  const uint32_t flags = a.word(idx_a, 0u);
+  if (flags != b.word(idx_b, 0u) || a.word(idx_a, 1u) != b.word(idx_b, 1u)) {
+    return false;
+  }
+  for (uint32_t k = 0u; k < 3u; ++k) {
+    if ((flags & (2u << k)) != 0u && a.word(idx_a, 2u + k) != b.word(idx_b, 2u + k)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Format a record in the same way as mrisc32-trace-tool.py (with operands).
+std::string format_record(const trace_file_t& f, const uint64_t idx) {
+  const uint32_t flags = f.word(idx, 0u);
+  char buf[64];
+  std::snprintf(buf, sizeof(buf), "%08X:", f.word(idx, 1u));
+  std::string str(buf);
+  for (uint32_t k = 0u; k < 3u; ++k) {
+    if ((flags & (2u << k)) != 0u) {
+      std::snprintf(buf, sizeof(buf), " %08X", f.word(idx, 2u + k));
+      str += buf;
+    } else {
+      str += " --------";
+    }
+  }
+  if ((flags & 1u) == 0u) {
+    str += " [defunct]";
+  }
+  return str;
+}
+
+void print_context(const trace_file_t& f,
+                   const uint64_t idx,
+                   const uint64_t context,
+                   const bool skip_defunct) {
+  std::cout << f.name() << ":\n";
+
+  // Find the first record to show (counting only shown records).
+  uint64_t first = idx;
+  for (uint64_t n = 0u; n < context && first > 0u;) {
+    --first;
+    if (!skip_defunct || f.valid(first)) {
+      ++n;
+    }
+  }
+
+  uint64_t n_after = 0u;
+  for (uint64_t i = first; i < f.num_records() && n_after <= context; ++i) {
+    if (skip_defunct && !f.valid(i)) {
+      continue;
+    }
+    std::cout << (i == idx ? "> " : "  ") << "[" << i << "] " << format_record(f, i) << "\n";
+    if (i >= idx) {
+      ++n_after;
+    }
+  }
+  if (idx >= f.num_records()) {
+    std::cout << "> [" << idx << "] <end of trace>\n";
+  }
+}
+
+void print_help(const char* prg_name) {
+  std::cout << "mr32trace - Compare two raw MRISC32 debug trace files\n";
+  std::cout << "Usage: " << prg_name << " [options] trace-file-a trace-file-b\n";
+  std::cout << "Options:\n";
+  std::cout << "  -h, --help                       Display this information.\n";
+  std::cout << "  -c N, --context N                Number of context records (default 5).\n";
+  std::cout << "  -d SIDE, --skip-defunct SIDE     Skip defunct records in a, b or both.\n";
+  std::cout << "\n";
+  std::cout << "The exit code is 0 if the traces are equal, and 1 if they differ.\n";
+  return;
+}
+}  // namespace
+
+int main(const int argc, const char** argv) {
+  // Parse command line options.
+  const char* file_a = nullptr;
+  const char* file_b = nullptr;
+  uint64_t context = 5u;
+  bool skip_defunct_a = false;
+  bool skip_defunct_b = false;
+  try {
+    for (int k = 1; k < argc; ++k) {
+      if (argv[k][0] == '-') {
+        if ((std::strcmp(argv[k], "--help") == 0) || (std::strcmp(argv[k], "-h") == 0)) {
+          print_help(argv[0]);
+          exit(0);
+        } else if ((std::strcmp(argv[k], "-c") == 0) ||
+                   (std::strcmp(argv[k], "--context") == 0)) {
+          if (k >= (argc - 1)) {
+            std::cerr << "Missing option for " << argv[k] << "\n";
+            print_help(argv[0]);
+            exit(1);
+          }
+          context = static_cast<uint64_t>(std::stoull(std::string(argv[++k]), nullptr, 0));
+        } else if ((std::strcmp(argv[k], "-d") == 0) ||
+                   (std::strcmp(argv[k], "--skip-defunct") == 0)) {
+          if (k >= (argc - 1)) {
+            std::cerr << "Missing option for " << argv[k] << "\n";
+            print_help(argv[0]);
+            exit(1);
+          }
+          ++k;
+          if (std::strcmp(argv[k], "a") == 0) {
+            skip_defunct_a = true;
+          } else if (std::strcmp(argv[k], "b") == 0) {
+            skip_defunct_b = true;
+          } else if (std::strcmp(argv[k], "both") == 0) {
+            skip_defunct_a = true;
+            skip_defunct_b = true;
+          } else {
+            std::cerr << "Error: Unknown side: " << argv[k] << "\n";
+            print_help(argv[0]);
+            exit(1);
+          }
+        } else {
+          std::cerr << "Error: Unknown option: " << argv[k] << "\n";
+          print_help(argv[0]);
+          exit(1);
+        }
+      } else if (file_a == nullptr) {
+        file_a = argv[k];
+      } else if (file_b == nullptr) {
+        file_b = argv[k];
+      } else {
+        std::cerr << "Error: Too many arguments.\n";
+        print_help(argv[0]);
+        exit(1);
+      }
+    }
+  } catch (...) {
+    std::cerr << "Error: Couldn't parse command line arguments.\n";
+    print_help(argv[0]);
+    exit(1);
+  }
+  if (file_a == nullptr || file_b == nullptr) {
+    std::cerr << "Error: Two trace files must be specified.\n";
+    print_help(argv[0]);
+    std::exit(1);
+  }
+
+  try {
+    const trace_file_t a(file_a);
+    const trace_file_t b(file_b);
+    const uint64_t num_a = a.num_records();
+    const uint64_t num_b = b.num_records();
+
+    // Compare blocks of records. Each block is first compared with memcmp() (which is vectorized),
+    // and only if that fails do we compare the individual records (operands that are not used
+    // may differ without the records being considered different).
+    uint64_t idx_a = 0u;
+    uint64_t idx_b = 0u;
+    bool equal = true;
+    while (true) {
+      if (skip_defunct_a) {
+        idx_a = a.skip_defunct(idx_a);
+      }
+      if (skip_defunct_b) {
+        idx_b = b.skip_defunct(idx_b);
+      }
+      if (idx_a >= num_a || idx_b >= num_b) {
+        equal = (idx_a >= num_a && idx_b >= num_b);
+        break;
+      }
+
+      // Determine the length of the block (a run of records that can be compared directly).
+      uint64_t count = std::min(std::min(num_a - idx_a, num_b - idx_b), BLOCK_RECORDS);
+      if (skip_defunct_a) {
+        count = a.count_valid(idx_a, count);
+      }
+      if (skip_defunct_b) {
+        count = b.count_valid(idx_b, count);
+      }
+
+      if (std::memcmp(a.record(idx_a), b.record(idx_b), count * RECORD_SIZE) != 0) {
+        uint64_t k = 0u;
+        while (k < count && records_equal(a, idx_a + k, b, idx_b + k)) {
+          ++k;
+        }
+        if (k < count) {
+          idx_a += k;
+          idx_b += k;
+          equal = false;
+          break;
+        }
+      }
+      idx_a += count;
+      idx_b += count;
+    }
+
+    if (equal) {
+      std::cout << "The traces are equal (" << num_a << " and " << num_b << " records).\n";
+      return 0;
+    }
+
+    std::cout << "The traces differ at record " << idx_a << " (a) / " << idx_b << " (b).\n\n";
+    print_context(a, idx_a, context, skip_defunct_a);
+    std::cout << "\n";
+    print_context(b, idx_b, context, skip_defunct_b);
+    return 1;
+  } catch (std::exception& e) {
+    std::cerr << "Error: " << e.what() << "\n";
+    std::exit(2);
+  }
+}
@@ -0,0 +1,236 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#include "profiler.hpp"
+
+#include "hex_string.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+
+namespace {
+// The number of instructions to list in the "hottest instructions" section of the report.
+const size_t NUM_HOT_INSTRUCTIONS = 50u;
+
+struct function_stats_t {
+  std::string name;
+  uint64_t instructions;
+  uint64_t cycles;
+  uint64_t vector_loop_cycles;
+};
+
+std::string percent(const uint64_t part, const uint64_t total) {
+  char str[16];
+  std::snprintf(str, sizeof(str), "%6.2f%%", total > 0u ? (100.0 * part) / total : 0.0);
+  return std::string(&str[0]);
+}
+
+std::string symbolize(const uint32_t pc, const symbol_table_t& symbols) {
+  const auto* sym = symbols.find_function(pc);
+  if (sym == nullptr) {
+    return std::string();
+  }
+  return sym->name + "+" + std::to_string(pc - sym->addr);
+}
+
+std::string function_name(const uint32_t addr, const symbol_table_t& symbols) {
+  const auto* sym = symbols.find_function(addr);
+  return (sym != nullptr) ? sym->name : as_hex32(addr);
+}
+}  // namespace
+
+profiler_t::profiler_t(const uint32_t text_begin, const uint32_t text_end, const uint32_t entry_pc)
+    : m_text_begin(text_begin),
+      m_num_text_entries((text_end > text_begin) ? ((text_end - text_begin + 3u) >> 2u) : 0u),
+      m_entries(m_num_text_entries + 1u, entry_t()),
+      m_num_dropped_frames(0u),
+      m_current_node(0u) {
+  m_nodes.push_back(node_t{entry_pc, 0u, 0u});
+}
+
+void profiler_t::call(const uint32_t target, const uint32_t return_addr) {
+  if (m_stack.size() >= MAX_STACK_DEPTH) {
+    // Drop the frame, but count it so that the matching return is dropped too.
+    ++m_num_dropped_frames;
+    return;
+  }
+  m_stack.push_back(frame_t{m_current_node, return_addr});
+
+  // Find or create the call tree node for the new call stack.
+  const uint64_t key = (static_cast<uint64_t>(m_current_node) << 32u) | target;
+  const auto it = m_children.find(key);
+  if (it != m_children.end()) {
+    m_current_node = it->second;
+  } else {
+    const auto node = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.push_back(node_t{target, m_current_node, 0u});
+    m_children[key] = node;
+    m_current_node = node;
+  }
+}
+
+void profiler_t::ret(const uint32_t target) {
+  if (m_num_dropped_frames > 0u) {
+    --m_num_dropped_frames;
+    return;
+  }
+
+  // Usually the innermost frame matches, but we may have to unwind several frames (e.g. for tail
+  // calls or longjmp).
+  for (size_t k = m_stack.size(); k > 0u; --k) {
+    if (m_stack[k - 1u].return_addr == target) {
+      m_current_node = m_stack[k - 1u].node;
+      m_stack.resize(k - 1u);
+      return;
+    }
+  }
+}
+
+void profiler_t::write_report(const std::string& file_name, const symbol_table_t& symbols) const {
+  std::ofstream out(file_name);
+  if (!out.good()) {
+    throw std::runtime_error("Unable to open the profile file.");
+  }
+
+  // Collect per-function and total stats.
+  const std::string outside_name = "<outside of text>";
+  const std::string unknown_name = "<unknown>";
+  std::map<const std::string*, function_stats_t> functions;
+  std::vector<uint32_t> hot_entries;
+  uint64_t total_instructions = 0u;
+  uint64_t total_cycles = 0u;
+  for (uint32_t idx = 0u; idx < static_cast<uint32_t>(m_entries.size()); ++idx) {
+    const auto& e = m_entries[idx];
+    if (e.instructions == 0u && e.cycles == 0u) {
+      continue;
+    }
+    total_instructions += e.instructions;
+    total_cycles += e.cycles;
+
+    const std::string* name = &outside_name;
+    if (idx < m_num_text_entries) {
+      const auto* sym = symbols.find_function(m_text_begin + 4u * idx);
+      name = (sym != nullptr) ? &sym->name : &unknown_name;
+      hot_entries.push_back(idx);
+    }
+    auto& f = functions[name];
+    f.name = *name;
+    f.instructions += e.instructions;
+    f.cycles += e.cycles;
+    f.vector_loop_cycles += e.vector_loop_cycles;
+  }
+
+  // Sort by self cycles.
+  std::vector<function_stats_t> sorted_functions;
+  for (const auto& f : functions) {
+    sorted_functions.push_back(f.second);
+  }
+  std::stable_sort(sorted_functions.begin(),
+                   sorted_functions.end(),
+                   [](const function_stats_t& a, const function_stats_t& b) {
+                     return a.cycles > b.cycles;
+                   });
+  const size_t num_hot = std::min(hot_entries.size(), NUM_HOT_INSTRUCTIONS);
+  std::partial_sort(hot_entries.begin(),
+                    hot_entries.begin() + static_cast<std::ptrdiff_t>(num_hot),
+                    hot_entries.end(),
+                    [this](const uint32_t a, const uint32_t b) {
+                      return m_entries[a].cycles > m_entries[b].cycles;
+                    });
+
+  out << "Total cycles:       " << total_cycles << "\n";
+  out << "Total instructions: " << total_instructions << "\n";
+
+  char line[256];
+  out << "\nFunctions (sorted by self cycles):\n\n";
+  std::snprintf(line,
+                sizeof(line),
+                "%14s %8s %14s %14s  %s\n",
+                "Self cycles",
+                "",
+                "Instructions",
+                "Vector loops",
+                "Function");
+  out << line;
+  for (const auto& f : sorted_functions) {
+    std::snprintf(line,
+                  sizeof(line),
+                  "%14llu %8s %14llu %14llu  ",
+                  static_cast<unsigned long long>(f.cycles),
+                  percent(f.cycles, total_cycles).c_str(),
+                  static_cast<unsigned long long>(f.instructions),
+                  static_cast<unsigned long long>(f.vector_loop_cycles));
+    out << line << f.name << "\n";
+  }
+
+  out << "\nHottest instructions (sorted by cycles):\n\n";
+  std::snprintf(line,
+                sizeof(line),
+                "%-10s %14s %8s %14s %14s  %s\n",
+                "PC",
+                "Cycles",
+                "",
+                "Instructions",
+                "Vector loops",
+                "Location");
+  out << line;
+  for (size_t k = 0u; k < num_hot; ++k) {
+    const uint32_t pc = m_text_begin + 4u * hot_entries[k];
+    const auto& e = m_entries[hot_entries[k]];
+    std::snprintf(line,
+                  sizeof(line),
+                  "%-10s %14llu %8s %14llu %14llu  ",
+                  as_hex32(pc).c_str(),
+                  static_cast<unsigned long long>(e.cycles),
+                  percent(e.cycles, total_cycles).c_str(),
+                  static_cast<unsigned long long>(e.instructions),
+                  static_cast<unsigned long long>(e.vector_loop_cycles));
+    out << line << symbolize(pc, symbols) << "\n";
+  }
+}
+
+void profiler_t::write_folded_stacks(const std::string& file_name,
+                                     const symbol_table_t& symbols) const {
+  std::ofstream out(file_name);
+  if (!out.good()) {
+    throw std::runtime_error("Unable to open the folded stacks file.");
+  }
+
+  // Build the stack strings. Parent nodes are always created before their children, so each node
+  // can extend the string of its parent. Different nodes may map to the same string (e.g. when
+  // several call targets lack symbols), so the cycles are merged per string.
+  std::vector<std::string> stacks(m_nodes.size());
+  std::map<std::string, uint64_t> cycles_per_stack;
+  for (size_t k = 0u; k < m_nodes.size(); ++k) {
+    const auto& node = m_nodes[k];
+    const auto name = function_name(node.func, symbols);
+    stacks[k] = (k == 0u) ? name : (stacks[node.parent] + ";" + name);
+    if (node.cycles > 0u) {
+      cycles_per_stack[stacks[k]] += node.cycles;
+    }
+  }
+
+  for (const auto& stack : cycles_per_stack) {
+    out << stack.first << " " << stack.second << "\n";
+  }
+}
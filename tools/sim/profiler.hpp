@@ -0,0 +1,132 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef SIM_PROFILER_HPP_
+#define SIM_PROFILER_HPP_
+
+#include "elf.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// @brief A per-PC execution profiler.
+///
+/// Instructions and cycles are counted in a flat array that is indexed by PC / 4, covering the
+/// text (code) range of the program. Anything outside of the text range is counted in a single
+/// extra entry.
+///
+/// The profiler also keeps a shadow call stack (from subroutine branches and returns), and counts
+/// cycles per unique call stack, which can be written as folded stacks for flame graph tools.
+class profiler_t {
+public:
+  /// @brief Constructor for profiler_t.
+  /// @param text_begin The first address of the text range.
+  /// @param text_end The end of the text range (exclusive).
+  /// @param entry_pc The address where execution starts (the root of the call stack).
+  profiler_t(const uint32_t text_begin, const uint32_t text_end, const uint32_t entry_pc);
+
+  /// @brief Count an executed (fetched) instruction.
+  void add_instruction(const uint32_t pc) {
+    ++entry(pc).instructions;
+  }
+
+  /// @brief Count cycles for an instruction.
+  /// @param pc The instruction address.
+  /// @param cycles The number of cycles.
+  /// @param vector_loop_cycles The number of cycles that were vector loop iterations (i.e. all
+  /// but the first cycle of a vector operation).
+  void add_cycles(const uint32_t pc, const uint64_t cycles, const uint64_t vector_loop_cycles) {
+    auto& e = entry(pc);
+    e.cycles += cycles;
+    e.vector_loop_cycles += vector_loop_cycles;
+    m_nodes[m_current_node].cycles += cycles;
+  }
+
+  /// @brief Push a frame to the shadow call stack (a subroutine branch was taken).
+  /// @param target The branch target (the called function).
+  /// @param return_addr The return address (the address after the branch instruction).
+  void call(const uint32_t target, const uint32_t return_addr);
+
+  /// @brief Pop frames from the shadow call stack (a subroutine return was taken).
+  ///
+  /// The stack is unwound to the innermost frame with a matching return address. If no such frame
+  /// exists (e.g. for a return from the entry function), the stack is left unchanged.
+  /// @param target The branch target (the return address).
+  void ret(const uint32_t target);
+
+  /// @brief Write a profiling report.
+  ///
+  /// The report contains a per-function summary (using the symbol table, if any) and a list of
+  /// the most frequently executed instructions.
+  /// @param file_name The name of the report file.
+  /// @param symbols The symbol table of the program (may be empty).
+  void write_report(const std::string& file_name, const symbol_table_t& symbols) const;
+
+  /// @brief Write the cycles per call stack in the folded stack format.
+  ///
+  /// Each line holds a semicolon separated list of function names (outermost first), followed by
+  /// the number of cycles that were spent in that exact call stack, e.g:
+  ///   _start;main;draw_frame 123456
+  /// @param file_name The name of the output file.
+  /// @param symbols The symbol table of the program (may be empty).
+  void write_folded_stacks(const std::string& file_name, const symbol_table_t& symbols) const;
+
+private:
+  struct entry_t {
+    uint64_t instructions;
+    uint64_t cycles;
+    uint64_t vector_loop_cycles;
+  };
+
+  entry_t& entry(const uint32_t pc) {
+    const uint32_t idx = (pc - m_text_begin) >> 2u;
+    return m_entries[idx < m_num_text_entries ? idx : m_num_text_entries];
+  }
+
+  // A node in the call tree (i.e. a unique call stack).
+  struct node_t {
+    uint32_t func;    // Function (call target) address.
+    uint32_t parent;  // Index of the parent node (the root node is its own parent).
+    uint64_t cycles;  // Cycles spent in this call stack (exclusive).
+  };
+
+  // A frame in the shadow call stack.
+  struct frame_t {
+    uint32_t node;         // The call tree node of the caller.
+    uint32_t return_addr;  // The expected return address.
+  };
+
+  // Deeper call stacks are folded into the deepest node (e.g. for runaway recursion).
+  static const size_t MAX_STACK_DEPTH = 1024u;
+
+  uint32_t m_text_begin;
+  uint32_t m_num_text_entries;
+  std::vector<entry_t> m_entries;
+
+  std::vector<node_t> m_nodes;
+  std::unordered_map<uint64_t, uint32_t> m_children;  // (parent << 32) | func -> node index
+  std::vector<frame_t> m_stack;
+  uint64_t m_num_dropped_frames;  // Calls beyond MAX_STACK_DEPTH.
+  uint32_t m_current_node;
+};
+
+#endif  // SIM_PROFILER_HPP_
@@ -0,0 +1,375 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#include "ram.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define RAM_USE_MMAP
+#endif
+
+#ifdef ENABLE_GUARDED_RAM
+#include <csignal>
+#endif
+
+namespace {
+
+#ifdef ENABLE_GUARDED_RAM
+// A guarded RAM reserves the full 32-bit address space plus a guard area, so that every guest
+// address (and any access that starts at a guest address) is inside the reserved range.
+const uint64_t GUARDED_RESERVE_SIZE = UINT64_C(0x100000000) + UINT64_C(0x10000);
+
+// The currently active guarded RAM (only one guarded RAM is supported at a time).
+std::atomic<const ram_t*> s_guarded_ram(nullptr);
+
+struct sigaction s_old_segv_action;
+
+void guard_fault_handler(int sig, siginfo_t* info, void* /* context */) {
+  // Note: This throws an exception if the fault is caused by a guest memory access. For that to
+  // work, the code that accesses the RAM must be compiled with -fnon-call-exceptions.
+  ram_t::handle_guard_fault(info->si_addr);
+
+  // Not a guest memory access: Restore the previous handler and retry the access.
+  sigaction(sig, &s_old_segv_action, nullptr);
+}
+
+void install_guard_fault_handler() {
+  static bool s_installed = false;
+  if (!s_installed) {
+    struct sigaction action;
+    action.sa_sigaction = guard_fault_handler;
+    sigemptyset(&action.sa_mask);
+    // SA_NODEFER: We leave the handler by throwing an exception, so the signal must not be blocked.
+    action.sa_flags = SA_SIGINFO | SA_NODEFER;
+    sigaction(SIGSEGV, &action, &s_old_segv_action);
+    s_installed = true;
+  }
+}
+#endif  // ENABLE_GUARDED_RAM
+
+#ifdef RAM_USE_MMAP
+// RAII wrapper for a file descriptor.
+class file_descriptor_t {
+public:
+  explicit file_descriptor_t(const char* file_name) : m_fd(open(file_name, O_RDONLY)) {
+  }
+
+  ~file_descriptor_t() {
+    if (m_fd >= 0) {
+      close(m_fd);
+    }
+  }
+
+  int get() const {
+    return m_fd;
+  }
+
+private:
+  const int m_fd;
+};
+#endif  // RAM_USE_MMAP
+
+}  // namespace
+
+ram_t::ram_t(const uint64_t ram_size, const bool guarded) : m_size(ram_size) {
+#ifdef ENABLE_GUARDED_RAM
+  // Guard pages can only catch out of range accesses if the RAM ends at a page boundary.
+  if (guarded && (m_size % page_size()) == 0u && s_guarded_ram.load() == nullptr) {
+    // Reserve the address space without any access permissions, and enable access to the RAM.
+    void* memory = mmap(nullptr,
+                        static_cast<size_t>(GUARDED_RESERVE_SIZE),
+                        PROT_NONE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                        -1,
+                        0);
+    if (memory == MAP_FAILED) {
+      throw std::runtime_error("Unable to reserve memory for the RAM");
+    }
+    if (m_size > 0u &&
+        mprotect(memory, static_cast<size_t>(m_size), PROT_READ | PROT_WRITE) != 0) {
+      munmap(memory, static_cast<size_t>(GUARDED_RESERVE_SIZE));
+      throw std::runtime_error("Unable to allocate memory for the RAM");
+    }
+    m_memory = static_cast<uint8_t*>(memory);
+    m_mapped_size = GUARDED_RESERVE_SIZE;
+    m_guarded = true;
+    install_guard_fault_handler();
+    s_guarded_ram = this;
+    return;
+  }
+#else
+  (void)guarded;
+#endif
+
+  if (m_size == 0u) {
+    return;
+  }
+#ifdef RAM_USE_MMAP
+  // Anonymous private pages are zero-filled on first access.
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+  flags |= MAP_NORESERVE;
+#endif
+  void* memory = mmap(nullptr, static_cast<size_t>(m_size), PROT_READ | PROT_WRITE, flags, -1, 0);
+  if (memory == MAP_FAILED) {
+    throw std::runtime_error("Unable to allocate memory for the RAM");
+  }
+  m_memory = static_cast<uint8_t*>(memory);
+  m_mapped_size = m_size;
+#else
+  m_memory = static_cast<uint8_t*>(std::calloc(static_cast<size_t>(m_size), 1u));
+  if (m_memory == nullptr) {
+    throw std::runtime_error("Unable to allocate memory for the RAM");
+  }
+#endif
+}
+
+ram_t::~ram_t() {
+#ifdef ENABLE_GUARDED_RAM
+  if (m_guarded) {
+    s_guarded_ram = nullptr;
+  }
+#endif
+  if (m_memory != nullptr) {
+#ifdef RAM_USE_MMAP
+    munmap(m_memory, static_cast<size_t>(m_mapped_size));
+#else
+    std::free(m_memory);
+#endif
+  }
+}
+
+bool ram_t::guard_pages_supported() {
+#ifdef ENABLE_GUARDED_RAM
+  return true;
+#else
+  return false;
+#endif
+}
+
+uint64_t ram_t::load_file(const char* file_name,
+                          const uint64_t file_offset,
+                          const uint32_t addr,
+                          const uint64_t max_size) {
+#ifdef RAM_USE_MMAP
+  file_descriptor_t fd(file_name);
+  struct stat file_stat;
+  if (fd.get() < 0 || fstat(fd.get(), &file_stat) != 0) {
+    throw std::runtime_error("Unable to open the binary file.");
+  }
+  const auto file_size = static_cast<uint64_t>(file_stat.st_size);
+#else
+  std::ifstream f(file_name, std::fstream::in | std::fstream::binary);
+  if (!f.good()) {
+    throw std::runtime_error("Unable to open the binary file.");
+  }
+  f.seekg(0, std::ios::end);
+  const auto file_size = static_cast<uint64_t>(f.tellg());
+#endif
+  if (file_size < file_offset) {
+    throw std::runtime_error("Premature end of file.");
+  }
+  const uint64_t size = std::min(file_size - file_offset, max_size);
+  if (size == 0u) {
+    return 0u;
+  }
+  if (static_cast<uint64_t>(addr) + size > m_size) {
+    out_of_range(static_cast<uint32_t>(std::max(static_cast<uint64_t>(addr), m_size)));
+  }
+  uint8_t* dst = &m_memory[addr];
+
+#ifdef RAM_USE_MMAP
+  const uint64_t page = page_size();
+
+  // Map whole pages copy-on-write, straight from the page cache.
+  uint64_t mapped_size = 0u;
+  if ((addr % page) == 0u && (file_offset % page) == 0u && size >= page) {
+    const uint64_t map_size = size - (size % page);
+    void* mapped = mmap(dst,
+                        static_cast<size_t>(map_size),
+                        PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_FIXED,
+                        fd.get(),
+                        static_cast<off_t>(file_offset));
+    if (mapped != MAP_FAILED) {
+      mapped_size = map_size;
+    }
+  }
+
+  // Copy the remaining part of the file.
+  if (mapped_size < size) {
+    const uint64_t copy_offset = file_offset + mapped_size;
+    const uint64_t map_offset = copy_offset - (copy_offset % page);
+    const uint64_t map_size = file_offset + size - map_offset;
+    void* src = mmap(
+        nullptr, static_cast<size_t>(map_size), PROT_READ, MAP_PRIVATE, fd.get(), map_offset);
+    if (src == MAP_FAILED) {
+      throw std::runtime_error("Unable to read the binary file.");
+    }
+    std::memcpy(dst + mapped_size,
+                static_cast<const uint8_t*>(src) + (copy_offset - map_offset),
+                static_cast<size_t>(size - mapped_size));
+    munmap(src, static_cast<size_t>(map_size));
+  }
+#else
+  f.seekg(static_cast<std::streamoff>(file_offset), std::ios::beg);
+  f.read(reinterpret_cast<char*>(dst), static_cast<std::streamsize>(size));
+  if (!f.good()) {
+    throw std::runtime_error("Unable to read the binary file.");
+  }
+#endif
+
+  return size;
+}
+
+uint64_t ram_t::page_size() {
+#ifdef RAM_USE_MMAP
+  return static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#else
+  return 4096u;
+#endif
+}
+
+uint64_t ram_t::touched_pages() const {
+  const uint64_t num_pages = (m_size + page_size() - 1u) / page_size();
+#ifdef RAM_USE_MMAP
+  if (num_pages == 0u) {
+    return 0u;
+  }
+#ifdef __APPLE__
+  std::vector<char> residency(static_cast<size_t>(num_pages));
+#else
+  std::vector<unsigned char> residency(static_cast<size_t>(num_pages));
+#endif
+  if (mincore(m_memory, static_cast<size_t>(m_size), residency.data()) != 0) {
+    return num_pages;
+  }
+  uint64_t count = 0u;
+  for (const auto x : residency) {
+    count += static_cast<uint64_t>(x & 1);
+  }
+  return count;
+#else
+  return num_pages;
+#endif
+}
+
+void ram_t::handle_guard_fault(const void* fault_addr) {
+#ifdef ENABLE_GUARDED_RAM
+  const ram_t* ram = s_guarded_ram.load();
+  if (ram != nullptr) {
+    const auto* addr = static_cast<const uint8_t*>(fault_addr);
+    if (addr >= ram->m_memory && addr < ram->m_memory + ram->m_mapped_size) {
+      ram->out_of_range(static_cast<uint32_t>(addr - ram->m_memory));
+    }
+  }
+#else
+  (void)fault_addr;
+#endif
+}
+
+void ram_t::map_device(const uint32_t addr, const uint32_t size, mmio_device_t* device) {
+  const uint64_t addr_end = static_cast<uint64_t>(addr) + size;
+  if (size == 0u || (addr % 4u) != 0u || addr_end > UINT64_C(0x100000000)) {
+    throw std::runtime_error("Invalid I/O device region");
+  }
+  for (const auto& region : m_io_regions) {
+    if (addr < static_cast<uint64_t>(region.begin) + region.size && region.begin < addr_end) {
+      throw std::runtime_error("Overlapping I/O device regions");
+    }
+  }
+  m_io_regions.push_back(io_region_t{addr, size, device});
+
+  // Extend the I/O window to cover all regions.
+  uint64_t begin = addr;
+  uint64_t end = addr_end;
+  if (m_io_size != 0u) {
+    begin = std::min<uint64_t>(begin, m_io_begin);
+    end = std::max<uint64_t>(end, static_cast<uint64_t>(m_io_begin) + m_io_size);
+  }
+  m_io_begin = static_cast<uint32_t>(begin);
+  m_io_size = static_cast<uint32_t>(std::min<uint64_t>(end - begin, UINT32_MAX));
+}
+
+uint32_t ram_t::io_load(const uint32_t addr, const uint32_t size) const {
+  check_align(addr, size);
+  for (const auto& region : m_io_regions) {
+    const uint32_t offset = addr - region.begin;
+    if (offset < region.size) {
+      // Narrow accesses read the whole word and extract the addressed (little endian) part.
+      const uint32_t word = region.device->read32(offset & ~3u);
+      const uint32_t shift = 8u * (offset & 3u);
+      return size == 4u ? word : (word >> shift) & ((1u << (8u * size)) - 1u);
+    }
+  }
+
+  // Not a device: Access the RAM (if any).
+  check_addr(addr, size);
+  switch (size) {
+    case 1u:
+      return load_shared<uint8_t>(addr);
+    case 2u:
+      return convert_endianity(load_shared<uint16_t>(addr));
+    default:
+      return convert_endianity(load_shared<uint32_t>(addr));
+  }
+}
+
+void ram_t::io_store(const uint32_t addr, const uint32_t value, const uint32_t size) {
+  check_align(addr, size);
+  for (const auto& region : m_io_regions) {
+    const uint32_t offset = addr - region.begin;
+    if (offset < region.size) {
+      if (size == 4u) {
+        region.device->write32(offset, value);
+      } else {
+        // Narrow accesses are performed as a read-modify-write of the whole word.
+        const uint32_t shift = 8u * (offset & 3u);
+        const uint32_t mask = ((1u << (8u * size)) - 1u) << shift;
+        const uint32_t word = region.device->read32(offset & ~3u);
+        region.device->write32(offset & ~3u, (word & ~mask) | ((value << shift) & mask));
+      }
+      return;
+    }
+  }
+
+  // Not a device: Access the RAM (if any).
+  check_addr(addr, size);
+  switch (size) {
+    case 1u:
+      store_shared<uint8_t>(addr, static_cast<uint8_t>(value));
+      break;
+    case 2u:
+      store_shared<uint16_t>(addr, convert_endianity(static_cast<uint16_t>(value)));
+      break;
+    default:
+      store_shared<uint32_t>(addr, convert_endianity(value));
+      break;
+  }
+}
@@ -20,7 +20,11 @@
 #ifndef SIM_RAM_HPP_
 #define SIM_RAM_HPP_
 
+#include "mmio.hpp"
+
+#include <algorithm>
 #include <cstdint>
+#include <cstdio>
 #include <sstream>
 #include <stdexcept>
 #include <vector>
@@ -51,20 +55,43 @@ static inline uint16_t convert_endianity(const uint16_t x) {
 
 /// @brief Simulated RAM.
 ///
-/// The memory is 32-bit addressable. All memory is allocated up front from the host machine.
+/// The memory is 32-bit addressable. The address space is reserved up front, but host memory is
+/// only committed for pages that are actually touched (on hosts that support mmap()).
+///
+/// Memory mapped I/O devices can be mapped into an I/O window of the address space. Accesses
+/// outside of the I/O window only pay for a single address comparison.
 class ram_t {
 public:
-  ram_t(const uint64_t ram_size) : m_memory(ram_size, 0u) {
+  /// @brief Constructor for ram_t.
+  /// @param ram_size The size of the RAM, in bytes.
+  /// @param guarded Catch out of range accesses with guard pages instead of checking the address
+  /// of every access (falls back to address checks if guard pages are not supported).
+  ram_t(const uint64_t ram_size, const bool guarded = false);
+  ~ram_t();
+
+  /// @brief Check if guard pages are supported on this host.
+  static bool guard_pages_supported();
+
+  /// @brief Check if out of range accesses are caught by guard pages.
+  bool guarded() const {
+    return m_guarded;
   }
 
   uint8_t& at(const uint32_t byte_addr) {
-    check_addr(byte_addr, sizeof(uint8_t));
+    // Note: The address is checked even in guarded mode, since the returned reference may be used
+    // for accessing a range of bytes (e.g. a framebuffer).
+    if (!valid_range(byte_addr, sizeof(uint8_t))) {
+      out_of_range(byte_addr);
+    }
     return m_memory[byte_addr];
   }
 
   uint32_t load8(const uint32_t addr) {
+    if (in_io_window(addr)) {
+      return io_load(addr, sizeof(uint8_t));
+    }
     check_addr(addr, sizeof(uint8_t));
-    return m_memory[addr];
+    return load_shared<uint8_t>(addr);
   }
 
   uint32_t load8signed(const uint32_t addr) {
@@ -72,15 +99,22 @@ public:
   }
 
   void store8(const uint32_t addr, const uint32_t value) {
+    if (in_io_window(addr)) {
+      io_store(addr, value, sizeof(uint8_t));
+      return;
+    }
     check_addr(addr, sizeof(uint8_t));
     check_align(addr, sizeof(uint8_t));
-    m_memory[addr] = static_cast<uint8_t>(value);
+    store_shared<uint8_t>(addr, static_cast<uint8_t>(value));
   }
 
   uint32_t load16(const uint32_t addr) const {
+    if (in_io_window(addr)) {
+      return io_load(addr, sizeof(uint16_t));
+    }
     check_addr(addr, sizeof(uint16_t));
     check_align(addr, sizeof(uint16_t));
-    return convert_endianity(reinterpret_cast<const uint16_t&>(m_memory[addr]));
+    return convert_endianity(load_shared<uint16_t>(addr));
   }
 
   uint32_t load16signed(const uint32_t addr) const {
@@ -88,30 +122,94 @@ public:
   }
 
   void store16(const uint32_t addr, const uint32_t value) {
+    if (in_io_window(addr)) {
+      io_store(addr, value, sizeof(uint16_t));
+      return;
+    }
     check_addr(addr, sizeof(uint16_t));
     check_align(addr, sizeof(uint16_t));
-    reinterpret_cast<uint16_t&>(m_memory[addr]) = convert_endianity(static_cast<uint16_t>(value));
+    store_shared<uint16_t>(addr, convert_endianity(static_cast<uint16_t>(value)));
   }
 
   uint32_t load32(const uint32_t addr) {
+    if (in_io_window(addr)) {
+      return io_load(addr, sizeof(uint32_t));
+    }
     check_addr(addr, sizeof(uint32_t));
     check_align(addr, sizeof(uint32_t));
-    return convert_endianity(reinterpret_cast<const uint32_t&>(m_memory[addr]));
+    return convert_endianity(load_shared<uint32_t>(addr));
   }
 
   void store32(const uint32_t addr, const uint32_t value) {
+    if (in_io_window(addr)) {
+      io_store(addr, value, sizeof(uint32_t));
+      return;
+    }
     check_addr(addr, sizeof(uint32_t));
     check_align(addr, sizeof(uint32_t));
-    reinterpret_cast<uint32_t&>(m_memory[addr]) = convert_endianity(value);
+    store_shared<uint32_t>(addr, convert_endianity(value));
+  }
+
+  uint8_t* data() {
+    return m_memory;
+  }
+
+  uint64_t size() const {
+    return m_size;
   }
 
+  /// @brief Get the size of the RAM that can be accessed directly through data().
+  ///
+  /// This is the part of the RAM below the I/O window. Accesses above it must go through the
+  /// load/store methods.
+  uint64_t direct_size() const {
+    return m_io_size != 0u ? std::min<uint64_t>(m_size, m_io_begin) : m_size;
+  }
+
+  /// @brief Map a memory mapped I/O device into the address space.
+  ///
+  /// Devices must be mapped before any CPU starts running. The I/O window is extended to cover all
+  /// mapped devices, and any RAM in the gaps between devices is still accessible.
+  /// @param addr The start address of the device region (must be word aligned).
+  /// @param size The size of the device region, in bytes.
+  /// @param device The device (owned by the caller, and it must outlive all RAM accesses).
+  void map_device(const uint32_t addr, const uint32_t size, mmio_device_t* device);
+
   bool valid_range(const uint32_t addr, const uint32_t size) const {
-    const auto addr_first = static_cast<std::vector<uint8_t>::size_type>(addr);
-    const auto addr_last = static_cast<std::vector<uint8_t>::size_type>(addr + size - 1);
-    const auto mem_size = m_memory.size();
-    return (addr_first < mem_size && addr_last < mem_size);
+    const auto addr_first = static_cast<uint64_t>(addr);
+    const auto addr_last = static_cast<uint64_t>(addr + size - 1);
+    return (addr_first < m_size && addr_last < m_size);
   }
 
+  /// @brief Load a file into RAM.
+  ///
+  /// The file is copied into RAM in bulk. When both the address and the file offset are page
+  /// aligned, whole pages of the file are instead mapped copy-on-write directly into the RAM, so
+  /// that only the pages that are actually accessed are read from the file.
+  /// @param file_name The name of the file to load.
+  /// @param file_offset The offset into the file where the data to load starts.
+  /// @param addr The RAM address to load the data to.
+  /// @param max_size The maximum number of bytes to load (by default the rest of the file).
+  /// @returns the number of bytes that were loaded.
+  uint64_t load_file(const char* file_name,
+                     const uint64_t file_offset,
+                     const uint32_t addr,
+                     const uint64_t max_size = UINT64_MAX);
+
+  /// @brief Get the size of a host memory page.
+  static uint64_t page_size();
+
+  /// @brief Get the number of host memory pages that have been touched (i.e. committed).
+  ///
+  /// On hosts without mmap() support all pages are counted.
+  uint64_t touched_pages() const;
+
+  /// @brief Handle a host memory access fault (called from the SIGSEGV handler).
+  ///
+  /// If the fault address is in the guard area of a guarded RAM, an out of range exception is
+  /// thrown. Otherwise the function returns.
+  static void handle_guard_fault(const void* fault_addr);
+
 private:
   static std::string as_hex32(const uint32_t x) {
     char str[16];
@@ -119,14 +217,48 @@ private:
     return std::string(&str[0]);
   }
 
+  // The RAM may be shared by several harts, each running in its own host thread. Aligned accesses
+  // are single-copy atomic, loads have acquire semantics and stores have release semantics (i.e.
+  // the guest sees a TSO-like memory model). On x86 hosts these are plain loads and stores.
+  template <typename T>
+  T load_shared(const uint32_t addr) const {
+#if defined(__GNUC__) || defined(__llvm__)
+    return __atomic_load_n(reinterpret_cast<const T*>(&m_memory[addr]), __ATOMIC_ACQUIRE);
+#else
+    return *reinterpret_cast<const volatile T*>(&m_memory[addr]);
+#endif
+  }
+
+  template <typename T>
+  void store_shared(const uint32_t addr, const T value) {
+#if defined(__GNUC__) || defined(__llvm__)
+    __atomic_store_n(reinterpret_cast<T*>(&m_memory[addr]), value, __ATOMIC_RELEASE);
+#else
+    *reinterpret_cast<volatile T*>(&m_memory[addr]) = value;
+#endif
+  }
+
+  bool in_io_window(const uint32_t addr) const {
+    return (addr - m_io_begin) < m_io_size;
+  }
+
+  // Slow paths for accesses in the I/O window (see ram.cpp).
+  uint32_t io_load(const uint32_t addr, const uint32_t size) const;
+  void io_store(const uint32_t addr, const uint32_t value, const uint32_t size);
+
   void check_addr(const uint32_t addr, const uint32_t size) const {
-    if (!valid_range(addr, size)) {
-      std::ostringstream ss;
-      ss << "Out of range memory access: " << as_hex32(addr) << " >= " << m_memory.size();
-      throw std::runtime_error(ss.str());
+    // With guard pages, out of range accesses are caught by the host MMU instead (see ram.cpp).
+    if (!m_guarded && !valid_range(addr, size)) {
+      out_of_range(addr);
     }
   }
 
+  [[noreturn]] void out_of_range(const uint32_t addr) const {
+    std::ostringstream ss;
+    ss << "Out of range memory access: " << as_hex32(addr) << " >= " << m_size;
+    throw std::runtime_error(ss.str());
+  }
+
   void check_align(const uint32_t addr, const uint32_t size) const {
     if ((addr % size) != 0u) {
       std::ostringstream ss;
@@ -143,7 +275,20 @@ private:
     return static_cast<uint32_t>(static_cast<int32_t>(static_cast<int16_t>(x)));
   }
 
-  std::vector<uint8_t> m_memory;
+  uint8_t* m_memory = nullptr;
+  uint64_t m_size;
+  uint64_t m_mapped_size = 0u;
+  bool m_guarded = false;
+
+  // Memory mapped I/O (an empty window if no devices are mapped).
+  struct io_region_t {
+    uint32_t begin;
+    uint32_t size;
+    mmio_device_t* device;
+  };
+  std::vector<io_region_t> m_io_regions;
+  uint32_t m_io_begin = 0u;
+  uint32_t m_io_size = 0u;
 
   // The RAM object is non-copyable.
   ram_t(const ram_t&) = delete;
@@ -0,0 +1,476 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#include "recompiler.hpp"
+
+#include "hex_string.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <set>
+#include <sstream>
+
+namespace {
+// Format a 32-bit value as an unsigned C++ literal.
+std::string as_uint_literal(const uint32_t x) {
+  return as_hex32(x) + "u";
+}
+
+std::string block_name(const uint32_t pc) {
+  char str[16];
+  std::snprintf(str, sizeof(str) - 1, "b_%08x", pc);
+  return std::string(&str[0]);
+}
+}  // namespace
+
+recompiler_t::recompiler_t(ram_t& ram, const uint32_t image_begin, const uint64_t image_end)
+    : m_ram(ram), m_image_begin(image_begin), m_image_end(image_end) {
+}
+
+bool recompiler_t::in_image(const uint32_t pc) const {
+  // Note: The program exit address (PC = 0) and simulator routines are never recompiled.
+  return (pc & 3u) == 0u && pc >= m_image_begin && static_cast<uint64_t>(pc) + 4u <= m_image_end &&
+         pc != 0x00000000u && (pc & 0xffff0000u) != 0xffff0000u;
+}
+
+bool recompiler_t::can_recompile(const decoded_instr_t& instr) {
+  // Vector operations are left to the interpreter.
+  if (instr.vector_mode != 0u) {
+    return false;
+  }
+
+  if (instr.is_mem_op) {
+    switch (instr.mem_op) {
+      case cpu_rec_t::MEM_OP_LOAD8:
+      case cpu_rec_t::MEM_OP_LOAD16:
+      case cpu_rec_t::MEM_OP_LOAD32:
+      case cpu_rec_t::MEM_OP_LOADU8:
+      case cpu_rec_t::MEM_OP_LOADU16:
+      case cpu_rec_t::MEM_OP_LDEA:
+      case cpu_rec_t::MEM_OP_STORE8:
+      case cpu_rec_t::MEM_OP_STORE16:
+      case cpu_rec_t::MEM_OP_STORE32:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  // All scalar ALU operations and branches can be recompiled.
+  return true;
+}
+
+void recompiler_t::discover() {
+  const uint32_t entry_pc = cpu_rec_t::RESET_PC;
+  std::vector<uint32_t> work_list(1u, entry_pc);
+  while (!work_list.empty()) {
+    const uint32_t pc = work_list.back();
+    work_list.pop_back();
+    add_block(pc, work_list);
+  }
+}
+
+void recompiler_t::add_block(const uint32_t block_pc, std::vector<uint32_t>& work_list) {
+  if (!in_image(block_pc) || m_blocks.find(block_pc) != m_blocks.end()) {
+    return;
+  }
+
+  std::vector<decoded_instr_t> instrs;
+  uint32_t pc = block_pc;
+  bool ends_with_branch = false;
+  while (instrs.size() < cpu_rec_t::MAX_BLOCK_INSTRS && in_image(pc)) {
+    const auto instr = cpu_rec_t::decode(m_ram.load32(pc));
+    if (!can_recompile(instr)) {
+      // Explore the code after the instruction, which is reached through the interpreter.
+      work_list.push_back(pc + 4u);
+      break;
+    }
+    instrs.push_back(instr);
+
+    if (instr.is_bcc) {
+      work_list.push_back(pc + 4u);
+      work_list.push_back(pc + (instr.imm << 2u));
+      ends_with_branch = true;
+      break;
+    }
+    if (instr.is_j) {
+      if (instr.reg1 == cpu_rec_t::REG_PC) {
+        work_list.push_back(pc + (instr.imm << 2u));
+      } else if (instr.reg1 == cpu_rec_t::REG_Z) {
+        work_list.push_back(instr.imm << 2u);
+      }
+
+      // The return address of a subroutine call, or (after a plain jump) often the start of the
+      // next function.
+      work_list.push_back(pc + 4u);
+      ends_with_branch = true;
+      break;
+    }
+
+    pc += 4u;
+  }
+  if (instrs.empty()) {
+    return;
+  }
+  if (!ends_with_branch) {
+    work_list.push_back(pc);
+  }
+
+  m_blocks[block_pc] = std::move(instrs);
+}
+
+void recompiler_t::write_cpp(std::ostream& out, const std::string& source_name) const {
+  out << "// Generated by mr32rec from " << source_name << ". Do not edit.\n\n";
+  out << "#include \"alu.hpp\"\n";
+  out << "#include \"cpu_rec.hpp\"\n\n";
+  out << "namespace {\n\n";
+  out << "using next_t = cpu_rec_t::next_t;\n";
+  out << "using context_t = cpu_rec_t::context_t;\n\n";
+
+  out << "next_t dispatch(const uint32_t pc);\n";
+  for (const auto& block : m_blocks) {
+    out << "next_t " << block_name(block.first) << "(context_t& c);\n";
+  }
+  out << "\n";
+
+  uint32_t index = 0u;
+  for (const auto& block : m_blocks) {
+    write_block(out, index++, block.first, block.second);
+  }
+
+  // Indirect jump dispatch table.
+  out << "next_t dispatch(const uint32_t pc) {\n";
+  out << "  switch (pc) {\n";
+  for (const auto& block : m_blocks) {
+    out << "    case " << as_uint_literal(block.first) << ":\n";
+    out << "      return {" << block_name(block.first) << "};\n";
+  }
+  out << "    default:\n";
+  out << "      return {nullptr};\n";
+  out << "  }\n";
+  out << "}\n\n";
+
+  // The original code, for verifying the program at run time.
+  uint32_t code_begin = 0u;
+  uint32_t code_end = 0u;
+  if (!m_blocks.empty()) {
+    code_begin = m_blocks.begin()->first;
+    for (const auto& block : m_blocks) {
+      code_end = std::max(code_end, block.first + 4u * static_cast<uint32_t>(block.second.size()));
+    }
+  }
+  out << "const uint32_t s_code[] = {";
+  for (uint32_t addr = code_begin; addr < code_end; addr += 4u) {
+    out << (((addr - code_begin) % 32u) == 0u ? "\n    " : " ")
+        << as_uint_literal(m_ram.load32(addr)) << ",";
+  }
+  out << "\n    0u};\n\n";
+
+  out << "const cpu_rec_t::block_t s_blocks[] = {\n";
+  for (const auto& block : m_blocks) {
+    out << "    {" << as_uint_literal(block.first) << ", " << block.second.size() << "u, "
+        << block_name(block.first) << "},\n";
+  }
+  out << "    {0u, 0u, nullptr}};\n\n";
+
+  out << "const cpu_rec_t::program_t s_program = {" << as_uint_literal(code_begin) << ", "
+      << as_uint_literal(code_end) << ", s_code, s_blocks, " << m_blocks.size() << "u};\n\n";
+
+  out << "struct registrar_t {\n";
+  out << "  registrar_t() {\n";
+  out << "    cpu_rec_t::register_program(&s_program);\n";
+  out << "  }\n";
+  out << "} s_registrar;\n\n";
+  out << "}  // namespace\n";
+}
+
+void recompiler_t::write_block(std::ostream& out,
+                               const uint32_t index,
+                               const uint32_t block_pc,
+                               const std::vector<decoded_instr_t>& instrs) const {
+  const auto num_instrs = static_cast<uint32_t>(instrs.size());
+
+  // Guest registers are held in local variables while the block runs.
+  std::set<uint32_t> used_regs;
+  std::set<uint32_t> written_regs;
+  const auto use_reg = [&used_regs](const uint32_t reg) {
+    if (reg != cpu_rec_t::REG_Z && reg != cpu_rec_t::REG_PC) {
+      used_regs.insert(reg);
+    }
+  };
+  for (const auto& d : instrs) {
+    use_reg(d.src_reg_a);
+    use_reg(d.src_reg_b);
+    use_reg(d.src_reg_c);
+    if (d.is_bcc || d.is_j) {
+      use_reg(d.reg1);
+    }
+    uint32_t dst_reg = d.dst_reg;
+    if (d.is_j && d.is_subroutine_branch) {
+      dst_reg = cpu_rec_t::REG_LR;
+    } else if (d.is_bcc || d.is_j || (d.is_mem_op && d.mem_op >= cpu_rec_t::MEM_OP_STORE8)) {
+      dst_reg = cpu_rec_t::REG_Z;
+    }
+    if (dst_reg != cpu_rec_t::REG_Z && dst_reg != cpu_rec_t::REG_PC) {
+      used_regs.insert(dst_reg);
+      written_regs.insert(dst_reg);
+    }
+  }
+
+  const auto reg = [](const uint32_t r, const uint32_t ipc) -> std::string {
+    if (r == cpu_rec_t::REG_Z) {
+      return "0u";
+    }
+    if (r == cpu_rec_t::REG_PC) {
+      return as_uint_literal(ipc);
+    }
+    return "r" + std::to_string(r);
+  };
+
+  std::ostringstream writeback;
+  for (const auto r : written_regs) {
+    writeback << "r[" << r << "] = r" << r << "; ";
+  }
+
+  // Exit to a constant PC.
+  const auto exit_to = [this, &writeback](const uint32_t pc) -> std::string {
+    if (m_blocks.find(pc) != m_blocks.end()) {
+      return writeback.str() + "return {" + block_name(pc) + "};";
+    }
+    return writeback.str() + "c.next_pc = " + as_uint_literal(pc) + "; return {nullptr};";
+  };
+
+  out << "// " << block_name(block_pc) << ": " << num_instrs << " instructions\n";
+  out << "next_t " << block_name(block_pc) << "(context_t& c) {\n";
+  out << "  if (c.budget < " << num_instrs << " || c.enabled[" << index << "] == 0u) {\n";
+  out << "    c.next_pc = " << as_uint_literal(block_pc) << ";\n";
+  out << "    c.status = cpu_rec_t::STATUS_INTERPRET;\n";
+  out << "    return {nullptr};\n";
+  out << "  }\n";
+  out << "  c.budget -= " << num_instrs << ";\n";
+  if (!used_regs.empty()) {
+    out << "  uint32_t* const r = c.regs;\n";
+  }
+  for (const auto r : used_regs) {
+    out << "  uint32_t r" << r << " = r[" << r << "];\n";
+  }
+
+  for (uint32_t k = 0u; k < num_instrs; ++k) {
+    const auto& d = instrs[k];
+    const uint32_t ipc = block_pc + 4u * k;
+    const bool src_b_is_imm = d.op_class_C || d.op_class_D;
+    const std::string a = reg(d.src_reg_a, ipc);
+    const std::string b = src_b_is_imm ? as_uint_literal(d.imm) : reg(d.src_reg_b, ipc);
+    const bool has_dst = (d.dst_reg != cpu_rec_t::REG_Z && d.dst_reg != cpu_rec_t::REG_PC);
+    const std::string dst = reg(d.dst_reg, ipc);
+
+    if (d.is_bcc) {
+      const std::string x = reg(d.reg1, ipc);
+      std::string cond;
+      switch (d.condition) {
+        case 0x30u:  // bz
+          cond = x + " == 0u";
+          break;
+        case 0x31u:  // bnz
+          cond = x + " != 0u";
+          break;
+        case 0x32u:  // bs
+          cond = x + " == 0xffffffffu";
+          break;
+        case 0x33u:  // bns
+          cond = x + " != 0xffffffffu";
+          break;
+        case 0x34u:  // blt
+          cond = "(" + x + " & 0x80000000u) != 0u";
+          break;
+        case 0x35u:  // bge
+          cond = "(" + x + " & 0x80000000u) == 0u";
+          break;
+        case 0x36u:  // ble
+          cond = "(" + x + " & 0x80000000u) != 0u || " + x + " == 0u";
+          break;
+        default:  // bgt
+          cond = "(" + x + " & 0x80000000u) == 0u && " + x + " != 0u";
+      }
+      out << "  if (" << cond << ") {\n";
+      out << "    " << exit_to(ipc + (d.imm << 2u)) << "\n";
+      out << "  }\n";
+      out << "  " << exit_to(ipc + 4u) << "\n";
+    } else if (d.is_j) {
+      if (d.reg1 == cpu_rec_t::REG_PC || d.reg1 == cpu_rec_t::REG_Z) {
+        // Direct jump.
+        const uint32_t base = (d.reg1 == cpu_rec_t::REG_PC) ? ipc : 0u;
+        if (d.is_subroutine_branch) {
+          out << "  r" << cpu_rec_t::REG_LR << " = " << as_uint_literal(ipc + 4u) << ";\n";
+        }
+        out << "  " << exit_to(base + (d.imm << 2u)) << "\n";
+      } else {
+        // Indirect jump, through the dispatch table.
+        out << "  const uint32_t target = " << reg(d.reg1, ipc) << " + "
+            << as_uint_literal(d.imm << 2u) << ";\n";
+        if (d.is_subroutine_branch) {
+          out << "  r" << cpu_rec_t::REG_LR << " = " << as_uint_literal(ipc + 4u) << ";\n";
+        }
+        out << "  " << writeback.str() << "c.next_pc = target; return dispatch(target);\n";
+      }
+    } else if (d.is_mem_op) {
+      const uint32_t scale = 1u << d.packed_mode;
+      const std::string addr =
+          src_b_is_imm ? (a + " + " + b) : (a + " + " + b + " * " + std::to_string(scale) + "u");
+      if (d.mem_op == cpu_rec_t::MEM_OP_LDEA) {
+        if (has_dst) {
+          out << "  " << dst << " = " << addr << ";\n";
+        }
+        continue;
+      }
+
+      // Memory faults are reported by the interpreter.
+      const uint32_t size = 1u << ((d.mem_op & 3u) - 1u);
+      out << "  {\n";
+      out << "    const uint32_t addr = " << addr << ";\n";
+      out << "    if (!cpu_rec_t::valid(c, addr, " << size << "u)) {\n";
+      out << "      " << writeback.str() << "c.budget += " << (num_instrs - k) << "; c.next_pc = "
+          << as_uint_literal(ipc)
+          << "; c.status = cpu_rec_t::STATUS_INTERPRET; return {nullptr};\n";
+      out << "    }\n";
+      if (d.mem_op >= cpu_rec_t::MEM_OP_STORE8) {
+        out << "    cpu_rec_t::store" << (8u * size) << "(c, addr, " << reg(d.src_reg_c, ipc)
+            << ");\n";
+        out << "    if (cpu_rec_t::is_code_store(c, addr)) {\n";
+        out << "      " << writeback.str() << "c.budget += " << (num_instrs - k - 1u)
+            << "; c.next_pc = " << as_uint_literal(ipc + 4u) << "; return {nullptr};\n";
+        out << "    }\n";
+      } else if (has_dst) {
+        const char* fn = "load32";
+        switch (d.mem_op) {
+          case cpu_rec_t::MEM_OP_LOAD8:
+            fn = "load8signed";
+            break;
+          case cpu_rec_t::MEM_OP_LOADU8:
+            fn = "load8";
+            break;
+          case cpu_rec_t::MEM_OP_LOAD16:
+            fn = "load16signed";
+            break;
+          case cpu_rec_t::MEM_OP_LOADU16:
+            fn = "load16";
+            break;
+        }
+        out << "    " << dst << " = cpu_rec_t::" << fn << "(c, addr);\n";
+      }
+      out << "  }\n";
+    } else if (has_dst) {
+      const bool is_word = (d.packed_mode == cpu_rec_t::PACKED_NONE || d.packed_mode == 3u);
+      const std::string sa = "static_cast<int32_t>(" + a + ")";
+      const std::string sb = "static_cast<int32_t>(" + b + ")";
+      std::string expr;
+      switch (d.ex_op) {
+        case cpu_rec_t::EX_OP_LDHI:
+          expr = b + " << 11";
+          break;
+        case cpu_rec_t::EX_OP_LDHIO:
+          expr = "(" + b + " << 11) | 0x7ffu";
+          break;
+        case cpu_rec_t::EX_OP_ADDPCHI:
+          expr = a + " + (" + b + " << 11)";
+          break;
+        case cpu_rec_t::EX_OP_OR:
+          expr = a + " | " + b;
+          break;
+        case cpu_rec_t::EX_OP_NOR:
+          expr = "~(" + a + " | " + b + ")";
+          break;
+        case cpu_rec_t::EX_OP_AND:
+          expr = a + " & " + b;
+          break;
+        case cpu_rec_t::EX_OP_BIC:
+          expr = a + " & ~" + b;
+          break;
+        case cpu_rec_t::EX_OP_XOR:
+          expr = a + " ^ " + b;
+          break;
+      }
+      if (expr.empty() && is_word) {
+        switch (d.ex_op) {
+          case cpu_rec_t::EX_OP_ADD:
+            expr = a + " + " + b;
+            break;
+          case cpu_rec_t::EX_OP_SUB:
+            expr = b + " - " + a;
+            break;
+          case cpu_rec_t::EX_OP_SEQ:
+            expr = "(" + a + " == " + b + ") ? 0xffffffffu : 0u";
+            break;
+          case cpu_rec_t::EX_OP_SNE:
+            expr = "(" + a + " != " + b + ") ? 0xffffffffu : 0u";
+            break;
+          case cpu_rec_t::EX_OP_SLT:
+            expr = "(" + sa + " < " + sb + ") ? 0xffffffffu : 0u";
+            break;
+          case cpu_rec_t::EX_OP_SLTU:
+            expr = "(" + a + " < " + b + ") ? 0xffffffffu : 0u";
+            break;
+          case cpu_rec_t::EX_OP_SLE:
+            expr = "(" + sa + " <= " + sb + ") ? 0xffffffffu : 0u";
+            break;
+          case cpu_rec_t::EX_OP_SLEU:
+            expr = "(" + a + " <= " + b + ") ? 0xffffffffu : 0u";
+            break;
+          case cpu_rec_t::EX_OP_MIN:
+            expr = "(" + sa + " < " + sb + ") ? " + a + " : " + b;
+            break;
+          case cpu_rec_t::EX_OP_MAX:
+            expr = "(" + sa + " > " + sb + ") ? " + a + " : " + b;
+            break;
+          case cpu_rec_t::EX_OP_MINU:
+            expr = "(" + a + " < " + b + ") ? " + a + " : " + b;
+            break;
+          case cpu_rec_t::EX_OP_MAXU:
+            expr = "(" + a + " > " + b + ") ? " + a + " : " + b;
+            break;
+          case cpu_rec_t::EX_OP_ASR:
+            // Note: Shift counts are masked like on x86 hosts, which matches the interpreter.
+            expr = "static_cast<uint32_t>(" + sa + " >> (" + b + " & 31u))";
+            break;
+          case cpu_rec_t::EX_OP_LSL:
+            expr = a + " << (" + b + " & 31u)";
+            break;
+          case cpu_rec_t::EX_OP_LSR:
+            expr = a + " >> (" + b + " & 31u)";
+            break;
+          case cpu_rec_t::EX_OP_MUL:
+            expr = a + " * " + b;
+            break;
+        }
+      }
+      if (expr.empty()) {
+        expr = "cpu_rec_t::alu(" + as_uint_literal(d.ex_op) + ", " + std::to_string(d.packed_mode) +
+               "u, " + a + ", " + b + ")";
+      }
+      out << "  " << dst << " = " << expr << ";\n";
+    }
+  }
+
+  // Blocks that do not end with a branch continue with the next instruction.
+  const auto& last = instrs.back();
+  if (!last.is_bcc && !last.is_j) {
+    out << "  " << exit_to(block_pc + 4u * num_instrs) << "\n";
+  }
+  out << "}\n\n";
+}
@@ -0,0 +1,79 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef SIM_RECOMPILER_HPP_
+#define SIM_RECOMPILER_HPP_
+
+#include "cpu_rec.hpp"
+#include "ram.hpp"
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/// @brief A static recompiler that translates a guest program to C++.
+///
+/// Basic blocks are discovered by following the control flow from the reset PC (direct branch and
+/// jump targets, fall through paths and subroutine return addresses). The code following indirect
+/// jumps and instructions that can not be recompiled is also explored, since it usually holds more
+/// code (e.g. the next function). The generated code is run by cpu_rec_t.
+class recompiler_t {
+public:
+  /// @brief Constructor for recompiler_t.
+  ///
+  /// @param ram The RAM that holds the program image.
+  /// @param image_begin Start address of the program image.
+  /// @param image_end End address of the program image (exclusive).
+  recompiler_t(ram_t& ram, const uint32_t image_begin, const uint64_t image_end);
+
+  /// @brief Discover all reachable basic blocks.
+  void discover();
+
+  /// @brief Generate a C++ translation unit for the recompiled program.
+  /// @param out The stream to write the C++ code to.
+  /// @param source_name Name of the program file (for the file header).
+  void write_cpp(std::ostream& out, const std::string& source_name) const;
+
+  /// @returns the number of discovered blocks.
+  size_t num_blocks() const {
+    return m_blocks.size();
+  }
+
+private:
+  using decoded_instr_t = cpu_rec_t::decoded_instr_t;
+
+  bool in_image(const uint32_t pc) const;
+  static bool can_recompile(const decoded_instr_t& instr);
+  void add_block(const uint32_t block_pc, std::vector<uint32_t>& work_list);
+  void write_block(std::ostream& out,
+                   const uint32_t index,
+                   const uint32_t block_pc,
+                   const std::vector<decoded_instr_t>& instrs) const;
+
+  ram_t& m_ram;
+  const uint32_t m_image_begin;
+  const uint64_t m_image_end;
+
+  // Discovered blocks, by start PC.
+  std::map<uint32_t, std::vector<decoded_instr_t>> m_blocks;
+};
+
+#endif  // SIM_RECOMPILER_HPP_
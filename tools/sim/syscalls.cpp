@@ -36,9 +36,14 @@ syscalls_t::~syscalls_t() {
 void syscalls_t::clear() {
   m_terminate = false;
   m_exit_code = 0u;
+  m_call_count = 0u;
 }
 
-void syscalls_t::call(const uint32_t routine_no, std::array<uint32_t, 32>& regs) {
+void syscalls_t::call(const uint32_t routine_no,
+                      std::array<uint32_t, 32>& regs,
+                      const uint64_t cycle) {
+  ++m_call_count;
+  m_written_size = 0u;
   if (routine_no >= static_cast<uint32_t>(routine_t::LAST_)) {
     // TODO(m): Warn!
     return;
@@ -97,7 +102,12 @@ void syscalls_t::call(const uint32_t routine_no, std::array<uint32_t, 32>& regs)
         int fd = fd_to_host(regs[1]);
         char* buf = reinterpret_cast<char*>(&m_ram.at(regs[2]));
         int nbytes = static_cast<int>(regs[3]);
-        regs[1] = static_cast<uint32_t>(sim_read(fd, buf, nbytes));
+        const int result = sim_read(fd, buf, nbytes);
+        regs[1] = static_cast<uint32_t>(result);
+        if (result > 0) {
+          m_written_addr = regs[2];
+          m_written_size = static_cast<uint32_t>(result);
+        }
       }
       break;
 
@@ -127,7 +137,7 @@ void syscalls_t::call(const uint32_t routine_no, std::array<uint32_t, 32>& regs)
 
     case routine_t::GETTIMEMICROS:
       {
-        const auto result = sim_gettimemicros();
+        const auto result = sim_gettimemicros(cycle);
         regs[1] = static_cast<uint32_t>(result);
         regs[2] = static_cast<uint32_t>(result >> 32);
       }
@@ -173,6 +183,8 @@ void syscalls_t::stat_to_ram(struct stat& buf, uint32_t addr) {
   m_ram.store32(addr + 52, buf.st_ctim.tv_nsec);
   m_ram.store32(addr + 56, buf.st_blksize);
   m_ram.store32(addr + 60, buf.st_blocks);
+  m_written_addr = addr;
+  m_written_size = 64u;
 }
 
 std::string syscalls_t::path_to_host(uint32_t addr) {
@@ -279,7 +291,14 @@ int syscalls_t::sim_write(int fd, const char *buf, int nbytes) {
   return ::write(fd, buf, nbytes);
 }
 
-unsigned long long syscalls_t::sim_gettimemicros(void) {
+unsigned long long syscalls_t::sim_gettimemicros(const uint64_t cycle) {
+  if (m_virtual_clock != 0u) {
+    // Split the calculation to avoid overflow for long runs.
+    const uint64_t seconds = cycle / m_virtual_clock;
+    const uint64_t fraction = cycle % m_virtual_clock;
+    return seconds * 1000000ULL + (fraction * 1000000ULL) / m_virtual_clock;
+  }
+
   struct timeval tv;
   if (::gettimeofday(&tv, nullptr) == 0) {
     return static_cast<unsigned long long>(tv.tv_sec) * 1000000ULL + static_cast<unsigned long long>(tv.tv_usec);
@@ -59,7 +59,28 @@ public:
   /// @brief Call a system routine.
   /// @param routine_no Syscall routine ID.
   /// @param regs A mutable array of the current register state.
-  void call(const uint32_t routine_no, std::array<uint32_t, 32>& regs);
+  /// @param cycle The current CPU cycle.
+  void call(const uint32_t routine_no, std::array<uint32_t, 32>& regs, const uint64_t cycle);
+
+  /// @brief Derive the time from the CPU cycle count instead of from the host clock.
+  ///
+  /// With a virtual clock, GETTIMEMICROS returns the simulated time since the start of the run,
+  /// so that guest benchmarks measure the speed of the simulated CPU and are reproducible.
+  /// @param cpu_clk The simulated CPU clock frequency (Hz), or zero to use the host time.
+  void set_virtual_clock(const uint32_t cpu_clk) {
+    m_virtual_clock = cpu_clk;
+  }
+
+  /// @returns the start of the guest memory range that was written by the last call.
+  uint32_t written_addr() const {
+    return m_written_addr;
+  }
+
+  /// @returns the size of the guest memory range that was written by the last call (zero if the
+  /// call did not write to guest memory).
+  uint32_t written_size() const {
+    return m_written_size;
+  }
 
   /// @returns true if a call requested the process to terminate.
   bool terminate() const {
@@ -71,6 +92,11 @@ public:
     return m_exit_code;
   }
 
+  /// @returns the number of routine calls since the last clear().
+  uint64_t call_count() const {
+    return m_call_count;
+  }
+
 private:
   void stat_to_ram(struct stat& buf, uint32_t addr);
   std::string path_to_host(uint32_t addr);
@@ -92,12 +118,16 @@ private:
   int sim_stat(const char *path, struct stat *buf);
   int sim_unlink(const char *pathname);
   int sim_write(int fd, const char *buf, int nbytes);
-  unsigned long long sim_gettimemicros(void);
+  unsigned long long sim_gettimemicros(const uint64_t cycle);
 
   ram_t& m_ram;
 
   bool m_terminate = false;
   uint32_t m_exit_code = 0u;
+  uint64_t m_call_count = 0u;
+  uint32_t m_written_addr = 0u;
+  uint32_t m_written_size = 0u;
+  uint32_t m_virtual_clock = 0u;
 };
 
 #endif  // SIM_SYSCALLS_HPP_
@@ -0,0 +1,219 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#include "timing_model.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+std::string trim(const std::string& str) {
+  const auto first = str.find_first_not_of(" \t\r");
+  if (first == std::string::npos) {
+    return std::string();
+  }
+  const auto last = str.find_last_not_of(" \t\r");
+  return str.substr(first, last - first + 1u);
+}
+
+bool is_long_latency_unit(const exec_unit_t unit) {
+  return unit == exec_unit_t::DIV || unit == exec_unit_t::FDIV || unit == exec_unit_t::FSQRT;
+}
+}  // namespace
+
+void timing_params_t::load(const std::string& file_name) {
+  std::ifstream file(file_name);
+  if (!file.good()) {
+    throw std::runtime_error("Unable to open the timing parameter file " + file_name);
+  }
+
+  std::string line;
+  int line_no = 0;
+  while (std::getline(file, line)) {
+    ++line_no;
+    line = trim(line.substr(0, line.find('#')));
+    if (line.empty()) {
+      continue;
+    }
+
+    const auto eq_pos = line.find('=');
+    if (eq_pos == std::string::npos) {
+      throw std::runtime_error(file_name + ":" + std::to_string(line_no) +
+                               ": Expected name = value");
+    }
+    const auto name = trim(line.substr(0, eq_pos));
+    const auto value_str = trim(line.substr(eq_pos + 1u));
+    uint32_t value;
+    try {
+      value = static_cast<uint32_t>(std::stoul(value_str, nullptr, 0));
+    } catch (std::exception&) {
+      throw std::runtime_error(file_name + ":" + std::to_string(line_no) +
+                               ": Invalid value: " + value_str);
+    }
+
+    if (name == "alu_latency") {
+      alu_latency = value;
+    } else if (name == "mul_latency") {
+      mul_latency = value;
+    } else if (name == "div_latency") {
+      div_latency = value;
+    } else if (name == "fpu_latency") {
+      fpu_latency = value;
+    } else if (name == "fdiv_latency") {
+      fdiv_latency = value;
+    } else if (name == "fsqrt_latency") {
+      fsqrt_latency = value;
+    } else if (name == "load_latency") {
+      load_latency = value;
+    } else if (name == "blocking_div") {
+      blocking_div = (value != 0u);
+    } else if (name == "branch_misprediction_penalty") {
+      branch_misprediction_penalty = value;
+    } else if (name == "indirect_jump_penalty") {
+      indirect_jump_penalty = value;
+    } else if (name == "taken_branch_penalty") {
+      taken_branch_penalty = value;
+    } else if (name == "icache_miss_penalty") {
+      icache_miss_penalty = value;
+    } else if (name == "dcache_miss_penalty") {
+      dcache_miss_penalty = value;
+    } else {
+      throw std::runtime_error(file_name + ":" + std::to_string(line_no) +
+                               ": Unknown timing parameter: " + name);
+    }
+  }
+}
+
+timing_model_t::timing_model_t(const timing_params_t& params) : m_params(params) {
+  reset();
+}
+
+void timing_model_t::reset() {
+  m_cycle = 0u;
+  m_reg_ready.fill(0u);
+  m_operations = 0u;
+  m_data_hazard_stall_cycles = 0u;
+  m_blocking_stall_cycles = 0u;
+  m_branches = 0u;
+  m_branch_mispredictions = 0u;
+  m_jumps = 0u;
+  m_branch_penalty_cycles = 0u;
+  m_cache_miss_stall_cycles = 0u;
+}
+
+void timing_model_t::issue(const op_t& op) {
+  // Wait for the source operands (register 0 is the zero register and never stalls).
+  uint64_t issue_cycle = m_cycle;
+  for (const auto reg : op.src_regs) {
+    if (reg != 0u) {
+      issue_cycle = std::max(issue_cycle, m_reg_ready[reg]);
+    }
+  }
+  m_data_hazard_stall_cycles += issue_cycle - m_cycle;
+
+  // Vector operations are pipelined (one element per cycle), while scalar long latency operations
+  // may block the pipeline until they are done.
+  const uint32_t op_latency = latency(op.unit);
+  if (!op.is_vector && m_params.blocking_div && is_long_latency_unit(op.unit) && op_latency > 1u) {
+    m_cycle = issue_cycle + op_latency;
+    m_blocking_stall_cycles += op_latency - 1u;
+  } else {
+    m_cycle = issue_cycle + op.elements;
+  }
+
+  // The result (of the first element, for vector operations) can be forwarded after the latency.
+  if (op.dst_reg != 0u) {
+    m_reg_ready[op.dst_reg] = issue_cycle + op_latency;
+  }
+
+  m_operations += op.elements;
+}
+
+void timing_model_t::branch(const uint32_t pc, const uint32_t target, const bool taken) {
+  ++m_branches;
+
+  // Static prediction: backward taken, forward not taken (BTFN).
+  const bool predict_taken = (target <= pc);
+  uint32_t penalty = 0u;
+  if (predict_taken != taken) {
+    ++m_branch_mispredictions;
+    penalty = m_params.branch_misprediction_penalty;
+  } else if (taken) {
+    penalty = m_params.taken_branch_penalty;
+  }
+  m_cycle += penalty;
+  m_branch_penalty_cycles += penalty;
+}
+
+void timing_model_t::jump(const bool is_indirect) {
+  ++m_jumps;
+  const uint32_t penalty =
+      is_indirect ? m_params.indirect_jump_penalty : m_params.taken_branch_penalty;
+  m_cycle += penalty;
+  m_branch_penalty_cycles += penalty;
+}
+
+void timing_model_t::dump_stats() const {
+  const double cpo =
+      static_cast<double>(m_cycle) / static_cast<double>(std::max<uint64_t>(m_operations, 1u));
+  std::cout << "Timing model:\n";
+  std::cout << " Total cycles:         " << m_cycle << "\n";
+  std::cout << " Cycles/Operation:     " << cpo << "\n";
+  std::cout << " Data hazard stalls:   " << m_data_hazard_stall_cycles << "\n";
+  std::cout << " Blocking unit stalls: " << m_blocking_stall_cycles << "\n";
+  std::cout << " Branches:             " << m_branches << " (" << m_branch_mispredictions
+            << " mispredicted)\n";
+  std::cout << " Jumps:                " << m_jumps << "\n";
+  std::cout << " Branch penalties:     " << m_branch_penalty_cycles << "\n";
+  std::cout << " Cache miss stalls:    " << m_cache_miss_stall_cycles << "\n";
+}
+
+void timing_model_t::write_stats(json_writer_t& json) const {
+  json.value("total_cycles", m_cycle);
+  json.value("operations", m_operations);
+  json.value("data_hazard_stall_cycles", m_data_hazard_stall_cycles);
+  json.value("blocking_stall_cycles", m_blocking_stall_cycles);
+  json.value("branches", m_branches);
+  json.value("branch_mispredictions", m_branch_mispredictions);
+  json.value("jumps", m_jumps);
+  json.value("branch_penalty_cycles", m_branch_penalty_cycles);
+  json.value("cache_miss_stall_cycles", m_cache_miss_stall_cycles);
+}
+
+uint32_t timing_model_t::latency(const exec_unit_t unit) const {
+  switch (unit) {
+    case exec_unit_t::MUL:
+      return m_params.mul_latency;
+    case exec_unit_t::DIV:
+      return m_params.div_latency;
+    case exec_unit_t::FPU:
+      return m_params.fpu_latency;
+    case exec_unit_t::FDIV:
+      return m_params.fdiv_latency;
+    case exec_unit_t::FSQRT:
+      return m_params.fsqrt_latency;
+    case exec_unit_t::LOAD:
+      return m_params.load_latency;
+    default:
+      return m_params.alu_latency;
+  }
+}
@@ -0,0 +1,162 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef SIM_TIMING_MODEL_HPP_
+#define SIM_TIMING_MODEL_HPP_
+
+#include "json_writer.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+/// @brief Execution unit classes, used for selecting operation latencies.
+enum class exec_unit_t : uint8_t {
+  ALU,     // Single cycle integer operations (and jump/link address calculations).
+  MUL,     // Integer multiplication.
+  DIV,     // Integer division and remainder.
+  FPU,     // Pipelined floating point operations.
+  FDIV,    // Floating point division.
+  FSQRT,   // Floating point square root.
+  LOAD,    // Memory loads.
+  STORE,   // Memory stores.
+  BRANCH,  // Conditional branches.
+};
+
+/// @brief Timing model parameters.
+///
+/// The default values approximate the MRISC32-A1 pipeline. All latencies are given in cycles, from
+/// the cycle when an operation issues until its result can be forwarded to a dependent operation
+/// (i.e. a latency of 1 means that a dependent operation can issue in the next cycle).
+struct timing_params_t {
+  uint32_t alu_latency = 1u;
+  uint32_t mul_latency = 3u;
+  uint32_t div_latency = 34u;
+  uint32_t fpu_latency = 3u;
+  uint32_t fdiv_latency = 24u;
+  uint32_t fsqrt_latency = 24u;
+  uint32_t load_latency = 2u;
+
+  // Scalar DIV, FDIV and FSQRT operations stall the pipeline until they are done (vector operations
+  // are always fully pipelined).
+  bool blocking_div = true;
+
+  // Extra cycles for a mispredicted branch (conditional branches are statically predicted as
+  // taken if they go backwards), and for register indirect jumps (including returns).
+  uint32_t branch_misprediction_penalty = 4u;
+  uint32_t indirect_jump_penalty = 4u;
+
+  // Extra cycles for correctly predicted taken branches and PC-relative jumps.
+  uint32_t taken_branch_penalty = 0u;
+
+  // Extra cycles for instruction and data cache misses (only used when cache models are enabled).
+  uint32_t icache_miss_penalty = 8u;
+  uint32_t dcache_miss_penalty = 8u;
+
+  /// @brief Load parameters from a parameter file.
+  ///
+  /// The file contains one "name = value" pair per line (the names match the member names of this
+  /// struct). Empty lines and lines starting with "#" are ignored. Parameters that are not present
+  /// in the file keep their current values.
+  /// @param file_name The name of the parameter file.
+  /// @throws std::runtime_error if the file could not be read or contains an unknown parameter.
+  void load(const std::string& file_name);
+};
+
+/// @brief A cycle approximate timing model for an in-order, single issue pipeline.
+///
+/// The model is driven by the functional simulation: it is informed about every issued operation
+/// and every branch, and accumulates the number of cycles that the modelled pipeline would need.
+/// Results are forwarded as soon as they are ready, so a dependent operation only stalls until
+/// the latency of its producer has elapsed. Vector operations issue one element per cycle.
+class timing_model_t {
+public:
+  /// @brief A description of an issued operation.
+  struct op_t {
+    exec_unit_t unit;
+    uint8_t src_regs[3];  // Source registers (0 = none), vector registers are offset by 32.
+    uint8_t dst_reg;      // Destination register (0 = none), vector registers are offset by 32.
+    bool is_vector;       // The operation is a vector operation.
+    uint32_t elements;    // The number of vector elements (1 for scalar operations).
+  };
+
+  explicit timing_model_t(const timing_params_t& params);
+
+  /// @brief Clear the timing state and statistics.
+  void reset();
+
+  /// @brief Account for an issued operation.
+  void issue(const op_t& op);
+
+  /// @brief Account for a resolved conditional branch.
+  /// @param pc The address of the branch instruction.
+  /// @param target The branch target address.
+  /// @param taken True if the branch was taken.
+  void branch(const uint32_t pc, const uint32_t target, const bool taken);
+
+  /// @brief Account for a jump (j/jl).
+  /// @param is_indirect True if the target is given by a register (other than PC).
+  void jump(const bool is_indirect);
+
+  /// @brief Account for an instruction cache miss (stalls the pipeline).
+  void icache_miss() {
+    m_cycle += m_params.icache_miss_penalty;
+    m_cache_miss_stall_cycles += m_params.icache_miss_penalty;
+  }
+
+  /// @brief Account for a data cache miss (stalls the pipeline).
+  void dcache_miss() {
+    m_cycle += m_params.dcache_miss_penalty;
+    m_cache_miss_stall_cycles += m_params.dcache_miss_penalty;
+  }
+
+  /// @brief Get the total number of cycles.
+  uint64_t cycles() const {
+    return m_cycle;
+  }
+
+  /// @brief Print the timing statistics.
+  void dump_stats() const;
+
+  /// @brief Write the timing statistics as JSON object members.
+  void write_stats(json_writer_t& json) const;
+
+private:
+  static const uint32_t NUM_REGS = 64u;
+
+  uint32_t latency(const exec_unit_t unit) const;
+
+  const timing_params_t m_params;
+
+  // Pipeline state.
+  uint64_t m_cycle;
+  std::array<uint64_t, NUM_REGS> m_reg_ready;  // The cycle when each register can be read.
+
+  // Statistics.
+  uint64_t m_operations;
+  uint64_t m_data_hazard_stall_cycles;
+  uint64_t m_blocking_stall_cycles;
+  uint64_t m_branches;
+  uint64_t m_branch_mispredictions;
+  uint64_t m_jumps;
+  uint64_t m_branch_penalty_cycles;
+  uint64_t m_cache_miss_stall_cycles;
+};
+
+#endif  // SIM_TIMING_MODEL_HPP_
@@ -0,0 +1,107 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef SIM_TRACE_FILTER_HPP_
+#define SIM_TRACE_FILTER_HPP_
+
+#include <cstdint>
+
+/// @brief Selects which instructions are recorded in a debug trace.
+///
+/// An instruction is recorded if:
+/// - The cycle number is in the cycle window [cycle_begin, cycle_end).
+/// - The trigger PC has been executed (within the cycle window), if a trigger PC is set.
+/// - The PC is in the PC range [pc_begin, pc_end].
+/// - It is the Nth instruction that passed the above tests (for 1-in-N sampling).
+class trace_filter_t {
+public:
+  void set_pc_range(const uint32_t pc_begin, const uint32_t pc_end) {
+    m_pc_begin = pc_begin;
+    m_pc_end = pc_end;
+  }
+
+  void set_cycle_window(const uint64_t cycle_begin, const uint64_t cycle_end) {
+    m_cycle_begin = cycle_begin;
+    m_cycle_end = cycle_end;
+  }
+
+  void set_trigger_pc(const uint32_t trigger_pc) {
+    m_trigger_pc = trigger_pc;
+    m_has_trigger = true;
+  }
+
+  void set_sample_rate(const uint32_t sample_rate) {
+    m_sample_rate = (sample_rate > 0u) ? sample_rate : 1u;
+  }
+
+  /// @brief Reset the recording state (call this before each run).
+  void reset() {
+    m_triggered = !m_has_trigger;
+    m_sample_count = 0u;
+  }
+
+  /// @brief Check if an instruction shall be recorded.
+  /// @param pc The instruction address.
+  /// @param cycle The current cycle number.
+  bool record(const uint32_t pc, const uint64_t cycle) {
+    if (cycle < m_cycle_begin || cycle >= m_cycle_end) {
+      return false;
+    }
+    if (!m_triggered) {
+      if (pc != m_trigger_pc) {
+        return false;
+      }
+      m_triggered = true;
+    }
+    if (pc < m_pc_begin || pc > m_pc_end) {
+      return false;
+    }
+    if (++m_sample_count < m_sample_rate) {
+      return false;
+    }
+    m_sample_count = 0u;
+    return true;
+  }
+
+  /// @brief Check if any of count consecutive cycles at the same PC could be recorded.
+  ///
+  /// This does not alter the recording state.
+  /// @param pc The instruction address.
+  /// @param cycle The first cycle number.
+  /// @param count The number of cycles.
+  bool may_record(const uint32_t pc, const uint64_t cycle, const uint64_t count) const {
+    return (cycle + count > m_cycle_begin && cycle < m_cycle_end) &&
+           (m_triggered || pc == m_trigger_pc) && (pc >= m_pc_begin && pc <= m_pc_end);
+  }
+
+private:
+  uint32_t m_pc_begin = 0u;
+  uint32_t m_pc_end = 0xffffffffu;
+  uint64_t m_cycle_begin = 0u;
+  uint64_t m_cycle_end = UINT64_MAX;
+  uint32_t m_trigger_pc = 0u;
+  bool m_has_trigger = false;
+  uint32_t m_sample_rate = 1u;
+
+  // Recording state.
+  bool m_triggered = true;
+  uint32_t m_sample_count = 0u;
+};
+
+#endif  // SIM_TRACE_FILTER_HPP_
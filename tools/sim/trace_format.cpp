@@ -0,0 +1,210 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#include "trace_format.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+#ifdef ENABLE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+const uint32_t METHOD_STORED = 0u;
+const uint32_t METHOD_ZLIB = 1u;
+const uint8_t FLAG_SEQUENTIAL_PC = 0x10u;
+const uint8_t FLAG_CYCLE_GAP = 0x20u;
+
+uint32_t get32(const uint8_t* buf) {
+  return static_cast<uint32_t>(buf[0]) | (static_cast<uint32_t>(buf[1]) << 8) |
+         (static_cast<uint32_t>(buf[2]) << 16) | (static_cast<uint32_t>(buf[3]) << 24);
+}
+
+void put32(std::vector<uint8_t>& buf, const uint32_t x) {
+  buf.push_back(static_cast<uint8_t>(x));
+  buf.push_back(static_cast<uint8_t>(x >> 8));
+  buf.push_back(static_cast<uint8_t>(x >> 16));
+  buf.push_back(static_cast<uint8_t>(x >> 24));
+}
+
+void put64(std::vector<uint8_t>& buf, const uint64_t x) {
+  put32(buf, static_cast<uint32_t>(x));
+  put32(buf, static_cast<uint32_t>(x >> 32));
+}
+
+uint64_t get64(const uint8_t* buf) {
+  return static_cast<uint64_t>(get32(buf)) | (static_cast<uint64_t>(get32(buf + 4)) << 32);
+}
+
+void put_varint(std::vector<uint8_t>& buf, uint64_t x) {
+  while (x >= 0x80u) {
+    buf.push_back(static_cast<uint8_t>(x | 0x80u));
+    x >>= 7;
+  }
+  buf.push_back(static_cast<uint8_t>(x));
+}
+}  // namespace
+
+compressed_trace_encoder_t::compressed_trace_encoder_t(std::ostream& out) : m_out(out) {
+  std::vector<uint8_t> header{'M', 'R', '3', '2', 'T', 'R', 'C', '1'};
+  put32(header, RECORDS_PER_CHUNK);
+  put32(header, 0u);
+  m_out.write(reinterpret_cast<const char*>(header.data()),
+              static_cast<std::streamsize>(header.size()));
+  m_offset = header.size();
+  m_chunk.reserve(RECORDS_PER_CHUNK * INPUT_RECORD_SIZE);
+}
+
+void compressed_trace_encoder_t::append(const uint8_t* data, const uint64_t size) {
+  const uint8_t* end = data + size;
+
+  // Complete a partial record from the previous call.
+  if (m_partial_size > 0u) {
+    const auto count =
+        static_cast<uint32_t>(std::min<uint64_t>(INPUT_RECORD_SIZE - m_partial_size, size));
+    std::copy(data, data + count, &m_partial[m_partial_size]);
+    m_partial_size += count;
+    data += count;
+    if (m_partial_size < INPUT_RECORD_SIZE) {
+      return;
+    }
+    encode_record(&m_partial[0]);
+    m_partial_size = 0u;
+  }
+
+  // Encode whole records.
+  for (; end - data >= static_cast<ptrdiff_t>(INPUT_RECORD_SIZE); data += INPUT_RECORD_SIZE) {
+    encode_record(data);
+  }
+
+  // Keep any trailing partial record.
+  m_partial_size = static_cast<uint32_t>(end - data);
+  std::copy(data, end, &m_partial[0]);
+}
+
+void compressed_trace_encoder_t::encode_record(const uint8_t* record) {
+  const uint32_t flags = get32(&record[0]) & 15u;
+  const uint32_t pc = get32(&record[4]);
+  const uint64_t cycle = get64(&record[RAW_RECORD_SIZE]);
+
+  // The first record of a chunk defines the first cycle of the chunk.
+  if (m_num_records == 0u) {
+    m_first_cycle = cycle;
+    m_prev_cycle = cycle - 1u;
+  }
+  const uint64_t cycle_gap = cycle - m_prev_cycle - 1u;
+
+  const uint32_t pc_delta = pc - m_prev_pc - 4u;
+  const uint8_t gap_flag = cycle_gap != 0u ? FLAG_CYCLE_GAP : 0u;
+  if (pc_delta == 0u) {
+    m_chunk.push_back(static_cast<uint8_t>(flags | gap_flag | FLAG_SEQUENTIAL_PC));
+  } else {
+    m_chunk.push_back(static_cast<uint8_t>(flags | gap_flag));
+    const auto delta = static_cast<int32_t>(pc_delta);
+    put_varint(m_chunk, (static_cast<uint32_t>(delta) << 1) ^ static_cast<uint32_t>(delta >> 31));
+  }
+  if (cycle_gap != 0u) {
+    put_varint(m_chunk, cycle_gap);
+  }
+  for (uint32_t k = 0u; k < 3u; ++k) {
+    if ((flags & (2u << k)) != 0u) {
+      m_chunk.insert(m_chunk.end(), &record[8u + 4u * k], &record[12u + 4u * k]);
+    }
+  }
+
+  if (m_num_records == 0u) {
+    m_min_pc = pc;
+    m_max_pc = pc;
+  } else {
+    m_min_pc = std::min(m_min_pc, pc);
+    m_max_pc = std::max(m_max_pc, pc);
+  }
+  m_prev_pc = pc;
+  m_prev_cycle = cycle;
+  ++m_num_records;
+  if (m_num_records == RECORDS_PER_CHUNK) {
+    flush_chunk();
+  }
+}
+
+void compressed_trace_encoder_t::flush_chunk() {
+  if (m_num_records == 0u) {
+    return;
+  }
+
+  // Compress the chunk (if zlib is available and it helps).
+  uint32_t method = METHOD_STORED;
+  const std::vector<uint8_t>* data = &m_chunk;
+#ifdef ENABLE_ZLIB
+  auto compressed_size = compressBound(static_cast<uLong>(m_chunk.size()));
+  m_compressed.resize(compressed_size);
+  if (compress2(m_compressed.data(),
+                &compressed_size,
+                m_chunk.data(),
+                static_cast<uLong>(m_chunk.size()),
+                Z_BEST_SPEED) == Z_OK &&
+      compressed_size < m_chunk.size()) {
+    m_compressed.resize(compressed_size);
+    method = METHOD_ZLIB;
+    data = &m_compressed;
+  }
+#endif
+
+  std::vector<uint8_t> header;
+  put32(header, method);
+  put32(header, static_cast<uint32_t>(data->size()));
+  put32(header, static_cast<uint32_t>(m_chunk.size()));
+  put32(header, m_num_records);
+  put64(header, m_first_cycle);
+  put32(header, m_min_pc);
+  put32(header, m_max_pc);
+  m_out.write(reinterpret_cast<const char*>(header.data()),
+              static_cast<std::streamsize>(header.size()));
+  m_out.write(reinterpret_cast<const char*>(data->data()),
+              static_cast<std::streamsize>(data->size()));
+
+  m_index.push_back({m_offset, m_first_cycle, m_num_records, m_min_pc, m_max_pc});
+  m_offset += header.size() + data->size();
+
+  m_chunk.clear();
+  m_num_records = 0u;
+  m_prev_pc = 0u;
+}
+
+void compressed_trace_encoder_t::finish() {
+  flush_chunk();
+
+  std::vector<uint8_t> index;
+  for (const auto& entry : m_index) {
+    put64(index, entry.offset);
+    put64(index, entry.first_cycle);
+    put32(index, entry.num_records);
+    put32(index, entry.min_pc);
+    put32(index, entry.max_pc);
+    put32(index, 0u);
+  }
+  put64(index, m_offset);
+  put64(index, static_cast<uint64_t>(m_index.size()));
+  const char trailer_magic[] = "MR32TIDX";
+  index.insert(index.end(), &trailer_magic[0], &trailer_magic[8]);
+  m_out.write(reinterpret_cast<const char*>(index.data()),
+              static_cast<std::streamsize>(index.size()));
+  m_index.clear();
+}
@@ -0,0 +1,101 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef SIM_TRACE_FORMAT_HPP_
+#define SIM_TRACE_FORMAT_HPP_
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+/// @brief Encoder for compressed, indexed debug trace files.
+///
+/// The input is a stream of cycle tagged debug trace records (28 bytes each: a raw record with
+/// flags, PC, src A, src B and src C as little endian 32-bit words, followed by the cycle number as
+/// a little endian 64-bit word). The cycle numbers must be increasing. The output file has the
+/// following layout (all integers are little endian):
+///
+/// - File header (16 bytes): "MR32TRC1", u32 records per chunk, u32 reserved (0).
+/// - Chunks, each consisting of a chunk header (32 bytes) followed by the chunk data:
+///   u32 method (0 = stored, 1 = zlib), u32 data size, u32 uncompressed size, u32 number of
+///   records, u64 first cycle, u32 min PC, u32 max PC.
+/// - Index (32 bytes per chunk): u64 chunk header offset, u64 first cycle, u32 number of records,
+///   u32 min PC, u32 max PC, u32 reserved (0).
+/// - Trailer (24 bytes): u64 index offset, u64 number of chunks, "MR32TIDX".
+///
+/// Each uncompressed record starts with a flags byte (bits 0-3 are the raw trace flags, bit 4 is
+/// set if PC = previous PC + 4, bit 5 is set if cycles were skipped since the previous record).
+/// Unless bit 4 is set, it is followed by the signed PC delta (PC - previous PC - 4) as a zigzag
+/// encoded varint. If bit 5 is set, the number of skipped cycles (cycle - previous cycle - 1)
+/// follows as a varint. Then follows one little endian 32-bit word for each valid source operand
+/// (A, B, C). The previous PC is zero at the start of each chunk, and the first record of a chunk
+/// is at the first cycle of the chunk, so that every chunk can be decoded on its own. Since the
+/// debug trace filters may skip cycles, the first cycle of a chunk is only a lower bound for the
+/// cycles of the records in the chunk, and the first cycle of the next chunk is an upper bound.
+class compressed_trace_encoder_t {
+public:
+  /// @brief Start a new compressed trace.
+  /// @param out The output stream (must be opened in binary mode).
+  explicit compressed_trace_encoder_t(std::ostream& out);
+
+  /// @brief Append trace data.
+  /// @param data Cycle tagged trace records (need not start or end at a record boundary).
+  /// @param size The number of bytes.
+  void append(const uint8_t* data, const uint64_t size);
+
+  /// @brief Write the last chunk, the index and the trailer.
+  void finish();
+
+  static const uint32_t RAW_RECORD_SIZE = 20u;
+  static const uint32_t INPUT_RECORD_SIZE = RAW_RECORD_SIZE + 8u;
+  static const uint32_t RECORDS_PER_CHUNK = 65536u;
+
+private:
+  struct index_entry_t {
+    uint64_t offset;
+    uint64_t first_cycle;
+    uint32_t num_records;
+    uint32_t min_pc;
+    uint32_t max_pc;
+  };
+
+  void encode_record(const uint8_t* record);
+  void flush_chunk();
+
+  std::ostream& m_out;
+  uint64_t m_offset = 0u;
+
+  // The current chunk.
+  std::vector<uint8_t> m_chunk;
+  std::vector<uint8_t> m_compressed;
+  uint32_t m_num_records = 0u;
+  uint32_t m_prev_pc = 0u;
+  uint64_t m_first_cycle = 0u;
+  uint64_t m_prev_cycle = 0u;
+  uint32_t m_min_pc = 0u;
+  uint32_t m_max_pc = 0u;
+
+  // A partial input record (from a previous append() call).
+  uint8_t m_partial[INPUT_RECORD_SIZE];
+  uint32_t m_partial_size = 0u;
+
+  std::vector<index_entry_t> m_index;
+};
+
+#endif  // SIM_TRACE_FORMAT_HPP_
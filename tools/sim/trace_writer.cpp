@@ -0,0 +1,187 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#include "trace_writer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <csignal>
+#include <time.h>
+#define TRACE_WRITER_USE_SIGNALS
+#endif
+
+namespace {
+// How long the writer thread sleeps when there is no data to write.
+const auto IDLE_SLEEP_TIME = std::chrono::microseconds(500);
+
+#ifdef TRACE_WRITER_USE_SIGNALS
+// Signals that terminate the process, and the actions that were installed before ours.
+const int FATAL_SIGNALS[] = {SIGABRT, SIGBUS, SIGFPE, SIGILL, SIGSEGV};
+const int NUM_FATAL_SIGNALS = sizeof(FATAL_SIGNALS) / sizeof(FATAL_SIGNALS[0]);
+struct sigaction s_old_actions[NUM_FATAL_SIGNALS];
+
+// The trace writer to drain when the process crashes.
+std::atomic<trace_writer_t*> s_crash_writer(nullptr);
+
+void fatal_signal_handler(int sig, siginfo_t* info, void* context) {
+  // Let any previously installed handler go first. In particular, the guarded RAM fault handler
+  // turns guest memory access faults into exceptions (in which case it does not return).
+  int idx = 0;
+  while (FATAL_SIGNALS[idx] != sig) {
+    ++idx;
+  }
+  const struct sigaction& old_action = s_old_actions[idx];
+  if ((old_action.sa_flags & SA_SIGINFO) != 0) {
+    old_action.sa_sigaction(sig, info, context);
+  } else if (old_action.sa_handler != SIG_DFL && old_action.sa_handler != SIG_IGN) {
+    old_action.sa_handler(sig);
+  }
+
+  // The process is about to die: Write the pending trace data.
+  trace_writer_t* writer = s_crash_writer.exchange(nullptr);
+  if (writer != nullptr) {
+    writer->drain_on_crash();
+  }
+
+  // Terminate with the default action for the signal.
+  signal(sig, SIG_DFL);
+  raise(sig);
+}
+
+void install_fatal_signal_handler() {
+  static bool s_installed = false;
+  if (!s_installed) {
+    struct sigaction action;
+    action.sa_sigaction = fatal_signal_handler;
+    sigemptyset(&action.sa_mask);
+    // SA_NODEFER: A chained handler may leave by throwing an exception, and we re-raise the signal.
+    action.sa_flags = SA_SIGINFO | SA_NODEFER;
+    for (int i = 0; i < NUM_FATAL_SIGNALS; ++i) {
+      sigaction(FATAL_SIGNALS[i], &action, &s_old_actions[i]);
+    }
+    s_installed = true;
+  }
+}
+#endif  // TRACE_WRITER_USE_SIGNALS
+}  // namespace
+
+trace_writer_t::trace_writer_t() : m_head(0u), m_tail(0u), m_closing(false), m_finished(false) {
+}
+
+trace_writer_t::~trace_writer_t() {
+  close();
+}
+
+void trace_writer_t::open(const std::string& file_name, const bool compressed) {
+  close();
+  m_file.open(file_name, std::ios::out | std::ios::binary);
+  if (!m_file.good()) {
+    throw std::runtime_error("Unable to open the trace file.");
+  }
+  if (compressed) {
+    m_encoder.reset(new compressed_trace_encoder_t(m_file));
+  }
+  m_buffer.resize(static_cast<size_t>(BUFFER_SIZE));
+  m_head = 0u;
+  m_tail = 0u;
+  m_cached_tail = 0u;
+  m_closing = false;
+  m_finished = false;
+  m_thread = std::thread(&trace_writer_t::writer_thread, this);
+  m_is_open = true;
+
+#ifdef TRACE_WRITER_USE_SIGNALS
+  install_fatal_signal_handler();
+  s_crash_writer = this;
+#endif
+}
+
+void trace_writer_t::close() {
+  if (!m_is_open) {
+    return;
+  }
+#ifdef TRACE_WRITER_USE_SIGNALS
+  trace_writer_t* self = this;
+  s_crash_writer.compare_exchange_strong(self, nullptr);
+#endif
+  m_closing = true;
+  m_thread.join();
+  m_encoder.reset();
+  m_file.close();
+  m_buffer.clear();
+  m_buffer.shrink_to_fit();
+  m_is_open = false;
+}
+
+void trace_writer_t::drain_on_crash() {
+#ifdef TRACE_WRITER_USE_SIGNALS
+  // Ask the writer thread to write the remaining data and finish the file, and give it some time
+  // to do so (it may be the thread that crashed). Only async-signal-safe functions are used here.
+  m_closing = true;
+  for (int i = 0; i < 500 && !m_finished.load(std::memory_order_acquire); ++i) {
+    struct timespec delay = {0, 10000000};  // 10 ms
+    nanosleep(&delay, nullptr);
+  }
+#endif
+}
+
+void trace_writer_t::wait_for_space(const uint64_t new_head) {
+  // The buffer is full: Wait for the writer thread to catch up.
+  m_cached_tail = m_tail.load(std::memory_order_acquire);
+  while (new_head - m_cached_tail > BUFFER_SIZE) {
+    std::this_thread::yield();
+    m_cached_tail = m_tail.load(std::memory_order_acquire);
+  }
+}
+
+void trace_writer_t::writer_thread() {
+  uint64_t tail = m_tail.load(std::memory_order_relaxed);
+  while (true) {
+    // Note: Read m_closing before m_head, so that no data is lost when closing.
+    const bool closing = m_closing.load(std::memory_order_acquire);
+    const uint64_t head = m_head.load(std::memory_order_acquire);
+    if (head == tail) {
+      if (closing) {
+        break;
+      }
+      std::this_thread::sleep_for(IDLE_SLEEP_TIME);
+      continue;
+    }
+
+    // Write as much as possible in one go (up to the end of the buffer).
+    const uint64_t pos = tail & (BUFFER_SIZE - 1u);
+    const uint64_t size = std::min(head - tail, BUFFER_SIZE - pos);
+    if (m_encoder) {
+      m_encoder->append(&m_buffer[pos], size);
+    } else {
+      m_file.write(reinterpret_cast<const char*>(&m_buffer[pos]),
+                   static_cast<std::streamsize>(size));
+    }
+    tail += size;
+    m_tail.store(tail, std::memory_order_release);
+  }
+  if (m_encoder) {
+    m_encoder->finish();
+  }
+  m_file.flush();
+  m_finished.store(true, std::memory_order_release);
+}
@@ -0,0 +1,131 @@
+//--------------------------------------------------------------------------------------------------
+// Copyright (c) 2018 Marcus Geelnard
+//
+// This software is provided 'as-is', without any express or implied warranty. In no event will the
+// authors be held liable for any damages arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose, including commercial
+// applications, and to alter it and redistribute it freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not claim that you wrote
+//     the original software. If you use this software in a product, an acknowledgment in the
+//     product documentation would be appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+//     being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef SIM_TRACE_WRITER_HPP_
+#define SIM_TRACE_WRITER_HPP_
+
+#include "trace_format.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// @brief Buffered asynchronous file writer for debug traces.
+///
+/// Records are appended to a lock-free single-producer/single-consumer ring buffer, which is
+/// drained by a background thread that writes large blocks to the file. Only a single thread may
+/// call write().
+///
+/// The data is written as is, or (for compressed traces) encoded by the background thread with
+/// compressed_trace_encoder_t.
+///
+/// If the process is about to die from a fatal signal (e.g. SIGFPE or SIGSEGV), the buffered data
+/// is written to the file before the process terminates, so that the trace of a crashing run is
+/// kept. This is only supported for one open trace writer at a time.
+class trace_writer_t {
+public:
+  trace_writer_t();
+  ~trace_writer_t();
+
+  /// @brief Open a trace file and start the writer thread.
+  /// @param file_name The name of the trace file.
+  /// @param compressed Write a compressed trace file instead of raw records.
+  void open(const std::string& file_name, const bool compressed = false);
+
+  /// @brief Write all pending data to the file and close it.
+  void close();
+
+  /// @brief Write all pending data to the file before the process dies.
+  ///
+  /// This is called from the fatal signal handler. The writer can not be used after this call.
+  void drain_on_crash();
+
+  bool is_open() const {
+    return m_is_open;
+  }
+
+  /// @brief Append a raw debug trace record to the trace file.
+  /// @param record The raw record (compressed_trace_encoder_t::RAW_RECORD_SIZE bytes).
+  /// @param cycle The cycle number of the record (only stored in compressed traces).
+  void write_record(const uint8_t* record, const uint64_t cycle) {
+    const uint32_t raw_size = compressed_trace_encoder_t::RAW_RECORD_SIZE;
+    if (!m_encoder) {
+      write(record, raw_size);
+      return;
+    }
+
+    // Tag the record with the cycle number (little endian), for the encoder.
+    uint8_t buf[compressed_trace_encoder_t::INPUT_RECORD_SIZE];
+    std::memcpy(&buf[0], record, raw_size);
+    for (uint32_t i = 0u; i < 8u; ++i) {
+      buf[raw_size + i] = static_cast<uint8_t>(cycle >> (8u * i));
+    }
+    write(&buf[0], sizeof(buf));
+  }
+
+  /// @brief Append data to the trace file.
+  /// @param data The data to write.
+  /// @param size The number of bytes to write (must not exceed the buffer size).
+  void write(const void* data, const uint64_t size) {
+    const uint64_t head = m_head.load(std::memory_order_relaxed);
+    if (head + size - m_cached_tail > BUFFER_SIZE) {
+      wait_for_space(head + size);
+    }
+
+    // Copy the data into the ring buffer (possibly in two parts, if it wraps around).
+    const auto* src = static_cast<const uint8_t*>(data);
+    const uint64_t pos = head & (BUFFER_SIZE - 1u);
+    const uint64_t size1 = (pos + size <= BUFFER_SIZE) ? size : (BUFFER_SIZE - pos);
+    std::memcpy(&m_buffer[pos], src, static_cast<size_t>(size1));
+    if (size1 < size) {
+      std::memcpy(&m_buffer[0], src + size1, static_cast<size_t>(size - size1));
+    }
+
+    // Publish the data to the writer thread.
+    m_head.store(head + size, std::memory_order_release);
+  }
+
+private:
+  static const uint64_t BUFFER_SIZE = 16u * 1024u * 1024u;  // Must be a power of two.
+
+  void wait_for_space(const uint64_t new_head);
+  void writer_thread();
+
+  std::vector<uint8_t> m_buffer;
+  std::ofstream m_file;
+  std::unique_ptr<compressed_trace_encoder_t> m_encoder;
+  std::thread m_thread;
+  bool m_is_open = false;
+
+  // Producer/consumer positions (total number of bytes written to / read from the buffer).
+  std::atomic<uint64_t> m_head;
+  std::atomic<uint64_t> m_tail;
+  std::atomic<bool> m_closing;
+  std::atomic<bool> m_finished;
+
+  // The producer's copy of m_tail (avoids touching the consumer's cache line for every write).
+  uint64_t m_cached_tail = 0u;
+};
+
+#endif  // SIM_TRACE_WRITER_HPP_